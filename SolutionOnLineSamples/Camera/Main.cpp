@@ -12,9 +12,11 @@
 //
 // This sample program does the following:
 // - Open connection to TXT interface with IP 192.168.7.2
-// - Start camera server
-// - Receive 20 frames, decode to YUV422 and save as YUV and JPEG
-//   The missing EOI is fixed in images received from the ft camera
+// - Start camera server, optionally with adaptive resolution / frame rate
+// - Receive 20 frames into pooled frame buffers
+//   The missing EOI is fixed in images received from the ft camera (marker scan, no decoding)
+// - Record them into an MJPEG AVI file per camera mode (or save single JPEG files),
+//   optionally decode to YUV422 and save as YUV
 // - Stop camera server
 ///////////////////////////////////////////////////////////////////////////////
 //update 2020-06-26[CvL]
@@ -28,6 +30,12 @@
 
 #include "../Common/ftProInterface2013TransferAreaCom.h"
 #include "../Common/ftProInterface2013JpegDecode.h"
+#include "../Common/ftProInterface2013MjpegRecorder.h"
+#include "../Common/ftProInterface2013CameraGovernor.h"
+#include "../Common/ftProInterface2013MotionDetect.h"
+#include "../Common/ftProInterface2013Vision.h"
+#include "../Common/ftProInterface2013CameraRing.h"
+#include "../Common/ftProInterface2013MjpegStream.h"
 using namespace std;
 
 FISH_X1_TRANSFER *TransArea;
@@ -35,6 +43,33 @@ ftIF2013TransferAreaComHandler *ComHandler;
 const std::string fnBase = "H:/Log/RoboProImg_";
 const std::string MyIP = "192.168.10.171";
 const std::string TaPort = "65000";
+// true: record all frames into fnBase+"rec.avi", false: one JPEG file per frame
+const bool RecordAvi = true;
+// Decode each frame to YUV422 and save it
+const bool SaveYuv = false;
+// Save the YUV file only if something moves (ftProInterface2013MotionDetect)
+const bool SaveOnMotion = true;
+// Print the brightness and the position of a dark line (ftProInterface2013Vision)
+const bool Vision = false;
+// Step the camera mode down / up with the load of the TXT (ftProInterface2013CameraGovernor)
+const bool Adaptive = false;
+// Keep the last seconds in RAM and dump them into fnBase+"fault.avi" on a (simulated) fault
+const bool PreTrigger = false;
+// Mounting of the camera: the images and the recording are rotated / flipped (ftProOrientation)
+const int Orientation = FTPRO_ORIENT_NONE;
+// Send the frames to browsers on this PC: http://localhost:8080/ (ftProInterface2013MjpegStream)
+const bool StreamServer = false;
+
+// Open the AVI file for the current camera mode
+static void OpenRecorder( ftIF2013MjpegWriter &recorder, int width, int height, int framerate )
+{
+    std::ostringstream filename;
+    filename << fnBase << "rec_" << width << "x" << height << ".avi";
+    if( !recorder.Open( filename.str().c_str(), width, height, framerate, Orientation ) )
+    {
+        cerr << "Cannot create the AVI file" << endl;
+    }
+}
 
 
 int main()
@@ -47,37 +82,98 @@ int main()
 
     // Initialize communication handler
     ComHandler->BeginTransfer();
+    // The server holds frames of the camera pool, so the pool is enlarged before the camera starts
+    ftIF2013MjpegStreamServer server;
+    if( StreamServer )
+    {
+        ComHandler->SetCameraFramePool( 4 + server.GetMaxFrames() );
+        server.Start( 8080 );
+    }
     // Start camera.
     // Tested resolutions / frame rates for the ft-camera are 320x240@30fps and 640x480@15fps
- //   ComHandler->StartCamera( 320, 240, 30, 50 );
-    ComHandler->StartCamera( 640, 480, 15, 50 );
-	// Allocate yuv buffer (size must match the numbers given above!
-  //  size_t yuvsize = 320*240*2;
-	size_t yuvsize = 640 * 480 * 2;
-	unsigned char *yuv = new unsigned char[yuvsize];
+    // The governor starts with the highest mode of its table (640x480@15fps)
+    ftIF2013CameraGovernor governor( ComHandler );
+    int width = 640, height = 480, framerate = 15;
+    if( Adaptive )
+    {
+        governor.Start();
+        width = governor.GetMode().width;
+        height = governor.GetMode().height;
+        framerate = governor.GetMode().framerate;
+    }
+    else
+    {
+        ComHandler->StartCamera( width, height, framerate, 50 );
+    }
+	// Allocate yuv buffer for the largest mode (the size of the YUV files must match the current mode!)
+	size_t yuvsize = width * height * 2;
+	unsigned char *yuv = new unsigned char[640 * 480 * 2];
+
+    // The writer thread writes the file, so recording doesn't delay the reception
+    ftIF2013MjpegWriter recorder;
+    if( RecordAvi )
+    {
+        OpenRecorder( recorder, width, height, framerate );
+    }
+
+    // Compares the frames without decoding them
+    ftProJpegMotionDetector motion;
+
+    // Dark line on 3 rows of the lower half, e.g. for a line follower
+    ftProVisionConfig visionconfig;
+    visionconfig.lines = 3;
+    visionconfig.difference = false;
+    ftProVision vision( visionconfig );
+
+    // The frames before and after a fault
+    ftIF2013CameraRingConfig ringconfig;
+    ringconfig.framerate = framerate;
+    ringconfig.orientation = Orientation;
+    ftIF2013CameraRing ring( ringconfig );
 
     // Loop for 20 frames
     int iLoop;
     clock_t prev = clock();
     for( iLoop=0; iLoop<20; iLoop++ )
     {
-        unsigned char *buffer;
-        size_t size;
-		if (!ComHandler->GetCameraFrameJpeg(&buffer, &size))
+        // The frame stays valid until the handle is released, also while the
+        // next frame is received
+        ftIF2013FrameHandle frame;
+		if (!ComHandler->GetCameraFrame(&frame))
 		{
-			cerr << "GetCameraFrameJpeg in Error " << endl;
+			cerr << "GetCameraFrame in Error " << endl;
 			return -1;
 	    }
 		   ;
+        unsigned char *buffer = frame.GetData();
+        size_t size = frame.GetSize();
         clock_t now = clock();
         cout << "Received frame with " << size << " bytes in " << now-prev << " clocks" << endl;
         prev = now;
 
-        if( size )
+        if( PreTrigger )
+        {
+            ring.Add( frame );
+            // A real application calls Trigger e.g. in the callback of a limit switch
+            if( iLoop == 15 && ring.Trigger( ( fnBase + "fault.avi" ).c_str() ) )
+            {
+                cout << "Fault: dumping " << ring.GetFrames() << " frames" << endl;
+            }
+        }
+
+        bool moved = true;
+        if( size && SaveYuv && SaveOnMotion )
+        {
+            // The first frame only sets the background
+            moved = motion.Analyze( buffer, size ) && ( motion.GetFrames() == 1 || motion.GetActivity() > 0.02 );
+        }
+
+        bool decoded = false;
+        if( size && SaveYuv && moved )
         {
             // Decode the JPEG to YUV422
-            size_t bytes_read=0;
-            if( ftProJpegDec( buffer, size, yuv, yuvsize, &bytes_read) )
+            decoded = ftProJpegDec( buffer, size, yuv, yuvsize, 0, FTPRO_PIXEL_YUYV, 1, 0, Orientation );
+            if( decoded )
             {
                 // Write YUV file (typically YUV422 interleaved, depends on camera)
                 std::ostringstream filenameC;
@@ -86,12 +182,50 @@ int main()
                 file.write( (char*)yuv, yuvsize );
                 file.close();
             }
+        }
 
-            // Fix the missing EOI marker using the number of bytes read by the decoder
-            size = bytes_read;
-            buffer[size++] = 0xFF;
-            buffer[size++] = 0xD9;
+        if( size && Vision && ( decoded || ftProJpegDec( buffer, size, yuv, yuvsize, 0, FTPRO_PIXEL_YUYV, 1, 0, Orientation ) ) )
+        {
+            ftProImage image = { FTPRO_PIXEL_YUYV, width, height, yuv };
+            if( ftProOrientationTransposes( Orientation ) )
+            {
+                image.width = height;
+                image.height = width;
+            }
+            ftProVisionResult result;
+            if( vision.Process( image, *frame.GetInfo(), &result ) )
+            {
+                cout << "Brightness " << result.m_mean;
+                for( int line = 0; line < result.m_linecount; line++ )
+                {
+                    if( result.m_lines[line].m_found )
+                    {
+                        cout << ", line at x=" << result.m_lines[line].m_x << " in row " << result.m_lines[line].m_row;
+                    }
+                }
+                cout << " (" << result.GetLatency() << " ms after the frame)" << endl;
+            }
+        }
+
+        // Fix the missing EOI marker behind the end of the scan data
+        // (a pool frame has ftIF2013FramePool::Reserve bytes behind the data)
+        if( size )
+        {
+            size = ftProJpegRepairEoi( buffer, size, size + frame.GetReserve() );
+        }
 
+        // Doesn't copy or wait, the clients send the newest frame
+        if( size && StreamServer )
+        {
+            server.Publish( frame, size );
+        }
+
+        if( size && RecordAvi )
+        {
+            recorder.AddFrame( buffer, size );
+        }
+        else if( size )
+        {
             // Write JPEG
             std::ostringstream filename;
             filename << fnBase << iLoop << "_x.jpg";
@@ -103,11 +237,71 @@ int main()
         // Do some dummy transfer on the main socket. Otherwise it will close cause of a timeout.
         // GetVersion is the most lightweight command supported
         ComHandler->GetVersion();
+
+        if( Adaptive )
+        {
+            // There is no TA communication thread here (GetCycleStats), so the
+            // governor uses the camera statistics only
+            int change = governor.Update();
+            if( change == FTIF2013_GOVERNOR_FAILED )
+            {
+                cerr << "The camera could not be restarted" << endl;
+                break;
+            }
+            else if( change != 0 )
+            {
+                // The next frames have the size of the new mode
+                width = governor.GetMode().width;
+                height = governor.GetMode().height;
+                framerate = governor.GetMode().framerate;
+                yuvsize = width * height * 2;
+                cout << "Camera mode changed to " << width << "x" << height << "@" << framerate << endl;
+                if( recorder.IsOpen() )
+                {
+                    recorder.Close();
+                    OpenRecorder( recorder, width, height, framerate );
+                }
+                ring.Clear();
+            }
+        }
     }
 
+    // Camera link statistics of the last frames
+    ftIF2013CameraStats stats;
+    ComHandler->GetCameraStats( &stats );
+    cout << "Camera: " << stats.m_fps << " fps, " << stats.m_bytespersec/1024 << " KB/s, jitter " << stats.m_jitter << " ms, "
+         << stats.m_serverdropped << " frames dropped by the camera server" << endl;
+
+    if( recorder.IsOpen() )
+    {
+        recorder.Close();
+        cout << "Recorded " << recorder.GetFrames() << " frames, " << recorder.GetDropped() << " dropped" << endl;
+    }
+    if( PreTrigger && ring.WaitDump( 5000 ) && ring.GetDumpResult() )
+    {
+        cout << "Dumped " << ring.GetDumpedFrames() << " frames of the fault" << endl;
+    }
+
+    // The clients release their frames before the pool is deleted with the handler
+    if( StreamServer )
+    {
+        ftIF2013StreamStats streamstats;
+        server.GetStats( &streamstats );
+        cout << "Stream: " << streamstats.m_sent << " frames sent, " << streamstats.m_skipped << " skipped, "
+             << streamstats.m_connections << " connections" << endl;
+    }
+    server.Stop();
+
     // Clean up communication handler
     // Note: The main socket might close after a timeout when no transfers are done on the main socket.
-    ComHandler->StopCamera();
+    if( Adaptive )
+    {
+        governor.Stop();
+    }
+    else
+    {
+        ComHandler->StopCamera();
+    }
     ComHandler->EndTransfer();
 
     // Delete transfer area and communication area
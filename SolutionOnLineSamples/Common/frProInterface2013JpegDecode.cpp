@@ -30,12 +30,27 @@
 // In order to decode such images successfully, we stop decoding
 // after sucessfull decoding of the first scan.
 //
+// ftProJpegDecoder keeps the decompression object between frames: after a
+// frame jpeg_abort_decompress returns it to the ready state, the strip
+// buffers are only reallocated if a wider frame arrives.
+//
 // see also:
 //
+// Changes: 2026-10-19
+//          Add ftProJpegDecoder (persistent decoder object), ftProJpegDec
+//          uses one decoder object per thread
+//          Selectable output format, see ftProInterface2013PixelFormat
+//          GRAY8 skips the IDCT of the chroma components
+//          Scaled decode 1/2, 1/4, 1/8
+//          Region of interest: IDCT only for the MCUs in the region
+//          (roi_iMCU_ fields, local change of libjpeg in jdcoefct.c)
+//          Orientation (rotate / flip) while packing the strips
+//          Scale 1/8: two MCU rows per strip for the line pairs of I420/NV12
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <stdio.h>
 #include <setjmp.h>
+#include <vector>
 
 extern "C" {
 //#pragma warning(disable : 4996)
@@ -44,6 +59,9 @@ extern "C" {
 //#pragma warning(default : 4996)
 };
 
+// UINT8 is defined by jmorecfg.h
+#include "ftProInterface2013JpegDecode.h"
+
 /* Read JPEG image from a memory segment  (This already exists in jpeglib v8) */
 static void init_source (j_decompress_ptr cinfo) {}
 
@@ -103,39 +121,89 @@ void ftProJpegDecErrHandler (j_common_ptr cinfo)
   longjmp(err->setjmp_buffer, 1);
 }
 
-/* Jpeg decoder, adopted from LIBJPEG example.c */
+/* Persistent decoder state, see ftProJpegDecoder */
+
+struct ftProJpegDecoderData {
+  struct jpeg_decompress_struct cinfo;
+  /* Note that this struct must live as long as the main JPEG parameter
+   * struct, to avoid dangling-pointer problems.
+   */
+  struct ftProJpegDecErrDataT jerr;
+  /* Strip buffers for Y, U, V: DCTSIZE rows each, reused while the width
+   * doesn't grow.
+   */
+  std::vector<JSAMPLE> strips;
+  JSAMPROW rows[3][DCTSIZE];
+  JDIMENSION stripwidth;
+  /* Region of the last image */
+  ftProJpegRoi region;
+  /* Orientation of the last image */
+  int orientation;
+};
 
-bool ftProJpegDec(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsize, size_t *bytes_read)
+ftProJpegDecoder::ftProJpegDecoder() :
+    m_data( new ftProJpegDecoderData )
 {
-    /* This struct contains the JPEG decompression parameters and pointers to
-    * working space (which is allocated as needed by the JPEG library).
-    */
-    struct jpeg_decompress_struct cinfo;
-    /* We use our private extension JPEG error handler.
-    * Note that this struct must live as long as the main JPEG parameter
-    * struct, to avoid dangling-pointer problems.
-    */
-    struct ftProJpegDecErrDataT jerr;
+    m_data->stripwidth = 0;
+    m_data->region.x = m_data->region.y = 0;
+    m_data->region.width = m_data->region.height = 0;
+    m_data->orientation = FTPRO_ORIENT_NONE;
 
-    /* Step 1: allocate and initialize JPEG decompression object */
+    /* Step 1: allocate and initialize JPEG decompression object (once) */
 
     /* We set up the normal JPEG error routines, then override error_exit. */
-    cinfo.err = jpeg_std_error(&jerr.pub);
-    jerr.pub.error_exit = ftProJpegDecErrHandler;
+    m_data->cinfo.err = jpeg_std_error(&m_data->jerr.pub);
+    m_data->jerr.pub.error_exit = ftProJpegDecErrHandler;
+    jpeg_create_decompress(&m_data->cinfo);
+}
+
+ftProJpegDecoder::~ftProJpegDecoder()
+{
+    jpeg_destroy_decompress(&m_data->cinfo);
+    delete m_data;
+}
+
+int ftProJpegDecoder::GetWidth() const
+{
+    return ftProOrientationTransposes( m_data->orientation ) ? m_data->region.height : m_data->region.width;
+}
+
+int ftProJpegDecoder::GetHeight() const
+{
+    return ftProOrientationTransposes( m_data->orientation ) ? m_data->region.width : m_data->region.height;
+}
+
+const ftProJpegRoi& ftProJpegDecoder::GetRoi() const
+{
+    return m_data->region;
+}
+
+/* Jpeg decoder, adopted from LIBJPEG example.c */
+
+bool ftProJpegDecoder::Decode(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsize, size_t *bytes_read, int format, int scale, const ftProJpegRoi *roi, int orientation)
+{
+    struct jpeg_decompress_struct &cinfo = m_data->cinfo;
+
+    if( scale!=1 && scale!=2 && scale!=4 && scale!=8 )
+    {
+        return false;
+    }
+    if( orientation < FTPRO_ORIENT_NONE || orientation > FTPRO_ORIENT_ROT270 )
+    {
+        return false;
+    }
+    m_data->orientation = orientation;
 
     /* Establish the setjmp return context for my_error_exit to use. */
-    if (setjmp(jerr.setjmp_buffer))
+    if (setjmp(m_data->jerr.setjmp_buffer))
     {
         /* If we get here, the JPEG code has signaled an error.
-         * We need to clean up the JPEG object, close the input file, and return.
+         * Return the JPEG object to the ready state for the next frame.
          */
-        jpeg_destroy_decompress(&cinfo);
+        jpeg_abort_decompress(&cinfo);
         return false;
     }
 
-    /* Now we can initialize the JPEG decompression object. */
-    jpeg_create_decompress(&cinfo);
-
     /* Step 2: specify data source (eg, a file) */
 
     jpeg_mem_src(&cinfo, jpegdata, jpegsize);
@@ -157,6 +225,66 @@ bool ftProJpegDec(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsi
     cinfo.do_fancy_upsampling = 0;
     cinfo.do_block_smoothing = 0;
 
+    /* Scaled decode: 1/2, 1/4 and 1/8 use the reduced size IDCTs, in raw
+     * mode the chroma components are scaled by the same factor.
+     */
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = scale;
+    jpeg_calc_output_dimensions(&cinfo);
+
+    /* Region of interest: even coordinates, so the chroma of the formats
+     * stays aligned, clipped to the image
+     */
+    ftProJpegRoi &region = m_data->region;
+    region.x = 0;
+    region.y = 0;
+    region.width = cinfo.output_width;
+    region.height = cinfo.output_height;
+    if( roi )
+    {
+        int x0 = roi->x > 0 ? roi->x & ~1 : 0;
+        int y0 = roi->y > 0 ? roi->y & ~1 : 0;
+        int x1 = (roi->x + roi->width + 1) & ~1;
+        int y1 = (roi->y + roi->height + 1) & ~1;
+        if( x1 > region.width ) x1 = region.width;
+        if( y1 > region.height ) y1 = region.height;
+        region.x = x0;
+        region.y = y0;
+        region.width = x1 > x0 ? x1-x0 : 0;
+        region.height = y1 > y0 ? y1-y0 : 0;
+    }
+
+    /* Check the output size (0 for an unknown format, odd image sizes or an empty region) */
+    size_t outsize = ftProPixelFormatSize( format, region.width, region.height );
+    if( outsize == 0 || outsize > (size_t)yuvsize )
+    {
+        jpeg_abort_decompress(&cinfo);
+        return false;
+    }
+
+    /* The IDCT only runs for the iMCUs which intersect the region */
+    if( roi )
+    {
+        int mcuwidth = cinfo.max_h_samp_factor * cinfo.min_DCT_h_scaled_size;
+        int mcuheight = cinfo.max_v_samp_factor * cinfo.min_DCT_v_scaled_size;
+        cinfo.roi_iMCU_col_start = region.x / mcuwidth;
+        cinfo.roi_iMCU_col_end = (region.x + region.width + mcuwidth-1) / mcuwidth;
+        cinfo.roi_iMCU_row_start = region.y / mcuheight;
+        cinfo.roi_iMCU_row_end = (region.y + region.height + mcuheight-1) / mcuheight;
+    }
+
+    /* Luma only: Cb and Cr still have to be entropy decoded to find the
+     * next block, but their coefficients are not stored, dequantized and
+     * transformed. jpeg_read_header sets the flags again for each frame.
+     */
+    if( format == FTPRO_PIXEL_GRAY8 )
+    {
+        for( int comp=1; comp<cinfo.num_components; comp++ )
+        {
+            cinfo.comp_info[comp].component_needed = FALSE;
+        }
+    }
+
     /* Step 5: Start decompressor */
 
     (void) jpeg_start_decompress(&cinfo);
@@ -164,36 +292,87 @@ bool ftProJpegDec(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsi
      * with the stdio data source.
      */
 
-    /* Step 6: read raw data and place into YUV buffer */
-    JSAMPARRAY bufY = (*cinfo.mem->alloc_sarray)( (j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.image_width, DCTSIZE);
-    JSAMPARRAY bufU = (*cinfo.mem->alloc_sarray)( (j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.image_width/2, DCTSIZE);
-    JSAMPARRAY bufV = (*cinfo.mem->alloc_sarray)( (j_common_ptr)&cinfo, JPOOL_IMAGE, cinfo.image_width/2, DCTSIZE);
+    /* Step 6: read raw data and place into the output buffer */
+    if( m_data->stripwidth < cinfo.image_width )
+    {
+        /* Y strip plus U and V strips of half width, rows padded to whole DCT blocks */
+        JDIMENSION width = (cinfo.image_width + 2*DCTSIZE-1) & ~(2*DCTSIZE-1);
+        m_data->strips.resize( (size_t)width*DCTSIZE*2 );
+        JSAMPLE *pos = m_data->strips.data();
+        for( int comp=0; comp<3; comp++ )
+        {
+            JDIMENSION compwidth = comp ? width/2 : width;
+            for( int line=0; line<DCTSIZE; line++ )
+            {
+                m_data->rows[comp][line] = pos;
+                pos += compwidth;
+            }
+        }
+        m_data->stripwidth = width;
+    }
+    JSAMPARRAY bufY = m_data->rows[0];
+    JSAMPARRAY bufU = m_data->rows[1];
+    JSAMPARRAY bufV = m_data->rows[2];
     JSAMPARRAY image[3] = { bufY, bufU, bufV };
-    UINT8 *outpos = yuvdata;
-
-    for( JDIMENSION iscan=0; iscan<cinfo.image_height; iscan+=DCTSIZE )
+    /* The packer writes the rows to their place in the rotated / flipped image */
+    ftProImage output = { format, region.width, region.height, yuvdata, orientation };
+    if( ftProOrientationTransposes( orientation ) )
     {
-        jpeg_read_raw_data(&cinfo, image, DCTSIZE );
+        output.width = region.height;
+        output.height = region.width;
+    }
+    /* Rows of the strip from the left edge of the region on */
+    JSAMPROW packY[DCTSIZE], packU[DCTSIZE], packV[DCTSIZE];
+    JDIMENSION roiend = region.y + region.height;
 
-        for( int line=0; line<DCTSIZE; line++ )
+    while( cinfo.output_scanline < roiend )
+    {
+        /* One MCU row: DCTSIZE lines at full size, DCTSIZE/scale scaled */
+        JDIMENSION iscan = cinfo.output_scanline;
+        JDIMENSION lines = jpeg_read_raw_data(&cinfo, image, DCTSIZE );
+        /* The packers take line pairs: at 1/8 an MCU row of a 4:2:2 frame
+         * has one line, the next one goes into the second half of the strip
+         */
+        while( lines > 0 && (lines & 1) && cinfo.output_scanline < cinfo.output_height )
         {
-            for( JDIMENSION x=0; x<cinfo.image_width; x+=2 )
+            JSAMPARRAY next[3] = { bufY+lines, bufU+lines, bufV+lines };
+            JDIMENSION more = jpeg_read_raw_data(&cinfo, next, DCTSIZE-lines );
+            if( more == 0 )
             {
-                *outpos++ = bufY[line][x];
-                *outpos++ = bufU[line][x>>1];
-                *outpos++ = bufY[line][x+1];
-                *outpos++ = bufV[line][x>>1];
+                lines = 0;
+                break;
             }
+            lines += more;
+        }
+        if( lines == 0 )
+        {
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+
+        /* Convert the lines of the strip in the region directly into the output format */
+        JDIMENSION first = iscan < (JDIMENSION)region.y ? region.y-iscan : 0;
+        if( lines > roiend-iscan )
+        {
+            lines = roiend-iscan;
+        }
+        if( first >= lines )
+        {
+            continue;
+        }
+        for( JDIMENSION line=first; line<lines; line++ )
+        {
+            packY[line-first] = bufY[line] + region.x;
+            packU[line-first] = bufU[line] + region.x/2;
+            packV[line-first] = bufV[line] + region.x/2;
         }
+        ftProPackStrip( output, iscan+first-region.y, lines-first, packY, packU, packV );
     }
 
     /* Step 7: Finish decompression */
     
     /* Don't do this. The MJPEG stream has some bogus stuff after the JPEG data end */
     // (void) jpeg_finish_decompress(&cinfo);
-    /* We can ignore the return value since suspension is not possible
-    * with the stdio data source.
-    */
 
     /* Save number of bytes read */
     if( bytes_read )
@@ -201,10 +380,11 @@ bool ftProJpegDec(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsi
         *bytes_read = cinfo.src->next_input_byte-jpegdata;
     }
 
-    /* Step 8: Release JPEG decompression object */
-
-    /* This is an important step since it will release a good deal of memory. */
-    jpeg_destroy_decompress(&cinfo);
+    /* Step 8: Return the JPEG object to the ready state for the next frame.
+     * This releases the memory of the image, but keeps the object, the
+     * source manager and the strips.
+     */
+    jpeg_abort_decompress(&cinfo);
 
     /* At this point you may want to check to see whether any corrupt-data
     * warnings occurred (test whether jerr.pub.num_warnings is nonzero).
@@ -213,3 +393,12 @@ bool ftProJpegDec(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsi
     /* And we're done! */
     return true;
 }
+
+/* Decode with a decoder object per thread, which is kept for the next frame */
+
+bool ftProJpegDec(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsize, size_t *bytes_read, int format, int scale, const ftProJpegRoi *roi, int orientation)
+{
+    static thread_local ftProJpegDecoder decoder;
+
+    return decoder.Decode( jpegdata, jpegsize, yuvdata, yuvsize, bytes_read, format, scale, roi, orientation );
+}
@@ -0,0 +1,369 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013CameraBroker.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Camera fan-out: one receiver, several consumers
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013CameraBroker
+//
+// A received frame is one ftIF2013BrokerShared object; the queues and the
+// consumers hold shared pointers to it. The JPEG frame returns to the pool of
+// the handler and the image to the image pool when the last one releases it.
+// The EOI is repaired before the frame is shared, afterwards nobody writes it.
+//
+// The subscriber list is locked by the receive thread while it distributes a
+// frame, the pushes don't wait (drop policies), so Subscribe and Unsubscribe
+// wait at most that long. GetFrame only takes the lock to find the queue.
+//
+// GetImage locks the mutex of the frame during the decode, so a second
+// consumer waits for the image instead of decoding it again. Each consumer
+// thread which decodes keeps its own decoder object (thread_local).
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "ftProInterface2013CameraBroker.h"
+#include "ftProInterface2013JpegDecode.h"
+#include "ftProInterface2013MjpegRecorder.h"
+
+using namespace std;
+
+/* Shared state of a received frame, see ftIF2013BrokerFrame */
+
+struct ftIF2013BrokerShared
+{
+    ftIF2013CameraBroker* m_broker;
+    ftIF2013FrameHandle m_jpeg;
+    std::chrono::steady_clock::time_point m_received;
+    std::mutex m_mutex;      // held during the decode
+    bool m_decoded;          // GetImage was called, m_image is the result
+    ftIF2013FrameHandle m_image;
+};
+
+//******************************************************************************
+//****
+//**** Class ftIF2013BrokerFrame: Implementation
+//****
+//******************************************************************************
+
+const ftIF2013FrameHandle& ftIF2013BrokerFrame::GetJpeg() const
+{
+    static const ftIF2013FrameHandle empty;
+    return m_shared ? m_shared->m_jpeg : empty;
+}
+
+std::chrono::steady_clock::time_point ftIF2013BrokerFrame::GetReceived() const
+{
+    return m_shared ? m_shared->m_received : std::chrono::steady_clock::time_point();
+}
+
+bool ftIF2013BrokerFrame::GetImage(ftIF2013FrameHandle* image)
+{
+    if (!m_shared)
+    {
+        image->Reset();
+        return false;
+    }
+
+    ftIF2013BrokerShared& shared = *m_shared;
+    std::lock_guard<std::mutex> lock(shared.m_mutex);
+    if (!shared.m_decoded)
+    {
+        shared.m_image = shared.m_broker->Decode(shared.m_jpeg);
+        shared.m_decoded = true;
+    }
+    else if (shared.m_image)
+    {
+        shared.m_broker->m_imagesshared++;
+    }
+    *image = shared.m_image;
+    return (bool)*image;
+}
+
+//******************************************************************************
+//****
+//**** Class ftIF2013CameraBroker: Implementation
+//****
+//******************************************************************************
+
+ftIF2013CameraBroker::ftIF2013CameraBroker(ftIF2013TransferAreaComHandler* handler, const ftIF2013BrokerConfig& config) :
+    m_handler(handler),
+    m_config(config),
+    m_running(false),
+    m_imagepool(0),
+    m_imagesize(0)
+{
+    if (m_config.orientation < FTPRO_ORIENT_NONE || m_config.orientation > FTPRO_ORIENT_ROT270) m_config.orientation = FTPRO_ORIENT_NONE;
+
+    // The decoder scales by 1, 2, 4 or 8 and the formats need an even image
+    // size: use the largest of these scales up to the requested one which fits
+    int scale = 1;
+    while (scale < 8 && scale * 2 <= m_config.scale) scale *= 2;
+    for (; scale >= 1; scale /= 2)
+    {
+        m_imagesize = ftProPixelFormatSize(m_config.format, (m_config.width + scale - 1) / scale, (m_config.height + scale - 1) / scale);
+        if (m_imagesize) break;
+    }
+    if (!m_imagesize)
+    {
+        cerr << "ftIF2013CameraBroker: No image of format " << m_config.format << " for " << m_config.width << "x" << m_config.height << endl;
+    }
+    else if (scale != m_config.scale)
+    {
+        cerr << "ftIF2013CameraBroker: Scale " << m_config.scale << " is not possible for this size, using " << scale << endl;
+        m_config.scale = scale;
+    }
+}
+
+ftIF2013CameraBroker::~ftIF2013CameraBroker()
+{
+    Stop();
+    for (size_t i = 0; i < m_subscribers.size(); i++)
+    {
+        delete m_subscribers[i];
+    }
+    delete m_imagepool;
+}
+
+int ftIF2013CameraBroker::Subscribe(int depth, int policy)
+{
+    if (depth < 1) depth = 1;
+    if (policy != FTIF2013_BROKER_DROP_NEWEST) policy = FTIF2013_BROKER_DROP_OLDEST;
+
+    std::lock_guard<std::mutex> lock(m_subscribermutex);
+    if (m_running)
+    {
+        cerr << "ftIF2013CameraBroker::Subscribe: The pools are sized for the subscribers at Start" << endl;
+    }
+    m_subscribers.push_back(new Subscriber(depth, policy));
+    return (int)m_subscribers.size() - 1;
+}
+
+void ftIF2013CameraBroker::Unsubscribe(int subscriber)
+{
+    Subscriber* entry = GetSubscriber(subscriber);
+    if (!entry)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_subscribermutex);
+        entry->m_active = false;
+    }
+    entry->m_queue.Close();
+    ftIF2013BrokerFrame frame;
+    while (entry->m_queue.TryPop(&frame)) {}
+}
+
+ftIF2013CameraBroker::Subscriber* ftIF2013CameraBroker::GetSubscriber(int subscriber)
+{
+    std::lock_guard<std::mutex> lock(m_subscribermutex);
+    if (subscriber < 0 || subscriber >= (int)m_subscribers.size() || !m_subscribers[subscriber]->m_active)
+    {
+        return nullptr;
+    }
+    return m_subscribers[subscriber];
+}
+
+bool ftIF2013CameraBroker::Start()
+{
+    if (m_running)
+    {
+        cerr << "ftIF2013CameraBroker::Start: Broker already running" << endl;
+        return false;
+    }
+    if (!m_imagesize)
+    {
+        cerr << "ftIF2013CameraBroker::Start: Invalid image size or format" << endl;
+        return false;
+    }
+    // The receive thread ended with the camera socket
+    if (m_receivethread.joinable()) m_receivethread.join();
+
+    // Every queue can be full while each consumer holds one frame
+    int frames = m_config.frames;
+    {
+        std::lock_guard<std::mutex> lock(m_subscribermutex);
+        if (frames <= 0)
+        {
+            frames = 2;
+            for (size_t i = 0; i < m_subscribers.size(); i++)
+            {
+                if (m_subscribers[i]->m_active) frames += m_subscribers[i]->m_depth + 1;
+            }
+        }
+        for (size_t i = 0; i < m_subscribers.size(); i++)
+        {
+            if (m_subscribers[i]->m_active) m_subscribers[i]->m_queue.Open();
+        }
+    }
+    if (!m_handler->SetCameraFramePool(frames))
+    {
+        return false;
+    }
+    if (!m_imagepool)
+    {
+        m_imagepool = new ftIF2013FramePool(frames, m_imagesize);
+    }
+
+    m_received = 0;
+    m_receivedropped = 0;
+    m_decoded = 0;
+    m_decodeerrors = 0;
+    m_decodedropped = 0;
+    m_imagesshared = 0;
+    m_start = std::chrono::steady_clock::now();
+
+    m_running = true;
+    m_receivethread = std::thread([this] { ReceiveThread(); });
+    return true;
+}
+
+void ftIF2013CameraBroker::Stop()
+{
+    m_running = false;
+    if (m_receivethread.joinable()) m_receivethread.join();
+
+    // Return the queued frames to the pools
+    std::lock_guard<std::mutex> lock(m_subscribermutex);
+    for (size_t i = 0; i < m_subscribers.size(); i++)
+    {
+        m_subscribers[i]->m_queue.Close();
+        ftIF2013BrokerFrame frame;
+        while (m_subscribers[i]->m_queue.TryPop(&frame)) {}
+    }
+}
+
+void ftIF2013CameraBroker::ReceiveThread()
+{
+    while (m_running)
+    {
+        ftIF2013FrameHandle jpeg;
+        if (!m_handler->GetCameraFrame(&jpeg))
+        {
+            if (m_running) cerr << "ftIF2013CameraBroker: Receive stopped" << endl;
+            break;
+        }
+        std::chrono::steady_clock::time_point received = std::chrono::steady_clock::now();
+        if (!jpeg)
+        {
+            // All JPEG frames are in use
+            m_receivedropped++;
+            continue;
+        }
+        m_received++;
+
+        // Only this thread has the frame yet
+        if (m_config.repaireoi)
+        {
+            size_t size = ftProJpegRepairEoi(jpeg.GetData(), jpeg.GetSize(), jpeg.GetSize() + jpeg.GetReserve());
+            if (size) jpeg.GetFrame()->m_size = size;
+        }
+
+        ftIF2013BrokerFrame frame;
+        frame.m_shared = std::make_shared<ftIF2013BrokerShared>();
+        frame.m_shared->m_broker = this;
+        frame.m_shared->m_jpeg = std::move(jpeg);
+        frame.m_shared->m_received = received;
+        frame.m_shared->m_decoded = false;
+
+        std::lock_guard<std::mutex> lock(m_subscribermutex);
+        for (size_t i = 0; i < m_subscribers.size(); i++)
+        {
+            Subscriber* subscriber = m_subscribers[i];
+            if (!subscriber->m_active) continue;
+
+            // The queue may be larger (power of 2), the depth is kept here;
+            // only this thread pushes, so the count can only become smaller
+            ftIF2013BrokerFrame copy = frame;
+            if (subscriber->m_policy == FTIF2013_BROKER_DROP_OLDEST)
+            {
+                ftIF2013BrokerFrame oldest;
+                while (subscriber->m_queue.GetCount() >= subscriber->m_depth && subscriber->m_queue.TryPop(&oldest))
+                {
+                    subscriber->m_dropped++;
+                }
+            }
+            else if (subscriber->m_queue.GetCount() >= subscriber->m_depth)
+            {
+                subscriber->m_dropped++;
+                continue;
+            }
+            if (!subscriber->m_queue.TryPush(copy))
+            {
+                subscriber->m_dropped++;
+            }
+        }
+    }
+
+    // GetFrame returns false after the last queued frame
+    std::lock_guard<std::mutex> lock(m_subscribermutex);
+    for (size_t i = 0; i < m_subscribers.size(); i++)
+    {
+        m_subscribers[i]->m_queue.Close();
+    }
+    m_running = false;
+}
+
+ftIF2013FrameHandle ftIF2013CameraBroker::Decode(const ftIF2013FrameHandle& jpeg)
+{
+    // Each consumer thread keeps its own decoder object
+    thread_local ftProJpegDecoder decoder;
+
+    ftIF2013FrameHandle image = m_imagepool->Acquire(m_imagesize);
+    if (!image)
+    {
+        m_decodedropped++;
+        return image;
+    }
+    if (!decoder.Decode(jpeg.GetData(), (int)jpeg.GetSize(), image.GetData(), (int)m_imagesize, nullptr, m_config.format, m_config.scale, nullptr, m_config.orientation))
+    {
+        m_decodeerrors++;
+        image.Reset();
+        return image;
+    }
+    m_decoded++;
+    return image;
+}
+
+bool ftIF2013CameraBroker::GetFrame(int subscriber, ftIF2013BrokerFrame* frame, int timeout_ms)
+{
+    Subscriber* entry = GetSubscriber(subscriber);
+    if (!entry || !entry->m_queue.Pop(frame, timeout_ms))
+    {
+        return false;
+    }
+    entry->m_delivered++;
+    return true;
+}
+
+void ftIF2013CameraBroker::GetStats(ftIF2013BrokerStats* stats)
+{
+    stats->m_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    stats->m_received = m_received;
+    stats->m_receivedropped = m_receivedropped;
+    stats->m_decoded = m_decoded;
+    stats->m_decodeerrors = m_decodeerrors;
+    stats->m_decodedropped = m_decodedropped;
+    stats->m_imagesshared = m_imagesshared;
+}
+
+bool ftIF2013CameraBroker::GetStats(int subscriber, ftIF2013BrokerSubscriberStats* stats)
+{
+    Subscriber* entry = GetSubscriber(subscriber);
+    if (!entry)
+    {
+        return false;
+    }
+    stats->m_delivered = entry->m_delivered;
+    stats->m_dropped = entry->m_dropped;
+    stats->m_queued = entry->m_queue.GetCount();
+    return true;
+}
@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013CameraBroker.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Camera fan-out: one receiver, several consumers
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013CameraBroker
+//
+//                    +--> queue (depth, policy) --> tracker   GetFrame( tracker, ... )
+//   receive thread --+--> queue (depth, policy) --> recorder  GetFrame( recorder, ... )
+//                    +--> queue (depth, policy) --> preview   GetFrame( preview, ... )
+//
+// Only one thread may call GetCameraFrame. The broker receives each frame
+// once and hands the same reference counted frame (ftIF2013BrokerFrame) to
+// all subscribers. Each subscriber has its own queue; a full queue never
+// waits but drops a frame:
+//   FTIF2013_BROKER_DROP_OLDEST  the oldest queued frame (control loops, preview)
+//   FTIF2013_BROKER_DROP_NEWEST  the new frame, the queued ones stay (e.g. a
+//                                recorder, which catches up later)
+// so a slow consumer never delays the receiver or the other consumers
+// (GetStats counts the drops of each subscriber).
+//
+// The compressed frame is always there (with EOI, see repaireoi). The image is
+// decoded when a consumer asks for it (GetImage), at most once per frame: the
+// first caller decodes, a second one at the same time waits for the result,
+// the later ones get it at once. All get the same image, which must not be
+// changed. The format, scale and orientation are those of the broker.
+//
+//   ftIF2013CameraBroker broker( ComHandler, config );
+//   int tracker = broker.Subscribe( 1, FTIF2013_BROKER_DROP_OLDEST );
+//   int recorder = broker.Subscribe( 30, FTIF2013_BROKER_DROP_NEWEST );
+//   broker.Start();
+//   ...
+//   // tracker thread                          // recorder thread
+//   ftIF2013BrokerFrame frame;                 ftIF2013BrokerFrame frame;
+//   ftIF2013FrameHandle image;                 broker.GetFrame( recorder, &frame );
+//   broker.GetFrame( tracker, &frame );        writer.AddFrame( frame.GetJpeg().GetData(),
+//   frame.GetImage( &image );                                   frame.GetJpeg().GetSize() );
+//
+// Subscribe before Start: the frame pools are sized for the queues of the
+// subscribers at Start (ftIF2013BrokerConfig::frames). Unsubscribe may be
+// called at any time. As for ftIF2013CameraPipeline StartCamera/StopCamera
+// must be called from the main thread and Stop after StopCamera (StopCamera
+// ends the receive of the broker thread and waits for it). All frames must
+// be released before the broker is deleted.
+//
+// All image formats need an even width and height. If the scaled size is odd
+// (e.g. 160x120 at 1/8 gives 20x15) the constructor reports it and uses the
+// next larger size (1/4), see GetConfig. Start fails if no size fits.
+//
+// see also: ftIF2013CameraPipeline, ftIF2013FramePool
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection
+#if(!defined(ftProInterface2013CameraBroker_H))
+#define ftProInterface2013CameraBroker_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ftProInterface2013PixelFormat.h"
+#include "ftProInterface2013FramePool.h"
+#include "ftProInterface2013CameraPipeline.h"
+
+enum ftIF2013BrokerPolicy
+{
+	FTIF2013_BROKER_DROP_OLDEST = 0,
+	FTIF2013_BROKER_DROP_NEWEST
+};
+
+struct ftIF2013BrokerConfig
+{
+	int width = 320;      // frame size as given to StartCamera
+	int height = 240;
+	int format = FTPRO_PIXEL_YUYV;  // ftProPixelFormat of the images
+	int scale = 1;        // decode at 1/scale of the size: 1, 2, 4 or 8 (see module description)
+	int orientation = FTPRO_ORIENT_NONE;  // see ftIF2013PipelineConfig::orientation
+	int frames = 0;       // frames of the pools, 0 = queue depths of the subscribers + 1 each + 2
+	bool repaireoi = true;// write the missing EOI into the frames (ftProJpegRepairEoi)
+};
+
+class ftIF2013CameraBroker;
+struct ftIF2013BrokerShared;
+
+/*!
+ * @brief A received frame shared by the subscribers, like a shared pointer
+ */
+class ftIF2013BrokerFrame
+{
+public:
+	explicit operator bool() const { return (bool)m_shared; }
+	void Reset() { m_shared.reset(); }
+
+	// The compressed frame, the data must not be changed
+	const ftIF2013FrameHandle& GetJpeg() const;
+	const ftIF2013FrameInfo* GetInfo() const { return GetJpeg().GetInfo(); }
+	INT32 GetSequence() const { return GetJpeg().GetSequence(); }
+	INT32 GetFrameNumber() const { return GetJpeg().GetFrameNumber(); }
+	std::chrono::steady_clock::time_point GetReceived() const;
+
+	/*!
+	 * @brief The decoded image, decoded by the first caller only (see module description)
+	 * @return false if the frame can't be decoded or no image frame is free
+	 */
+	bool GetImage(ftIF2013FrameHandle* image);
+
+protected:
+	friend class ftIF2013CameraBroker;
+	std::shared_ptr<ftIF2013BrokerShared> m_shared;
+};
+
+struct ftIF2013BrokerStats
+{
+	double m_elapsed;           // [s]
+	INT32  m_received;          // frames received
+	INT32  m_receivedropped;    // no free JPEG frame in the pool of the handler
+	INT32  m_decoded;           // images decoded
+	INT32  m_decodeerrors;
+	INT32  m_decodedropped;     // no free image frame
+	INT32  m_imagesshared;      // GetImage calls served without a decode
+};
+
+struct ftIF2013BrokerSubscriberStats
+{
+	INT32  m_delivered;         // frames returned by GetFrame
+	INT32  m_dropped;           // dropped by the full queue
+	int    m_queued;            // frames in the queue now
+};
+
+/*!
+ * @brief Receives the camera frames once for several consumers, see the module description
+ */
+class ftIF2013CameraBroker
+{
+public:
+	ftIF2013CameraBroker(ftIF2013TransferAreaComHandler* handler, const ftIF2013BrokerConfig& config);
+	~ftIF2013CameraBroker();
+
+	/*!
+	 * @brief Add a consumer
+	 * @param depth frames of its queue
+	 * @param policy ftIF2013BrokerPolicy
+	 * @return the id of the subscriber for GetFrame
+	 */
+	int Subscribe(int depth, int policy);
+	/*!
+	 * @brief Remove a consumer, its queued frames are released, GetFrame returns false
+	 */
+	void Unsubscribe(int subscriber);
+
+	/*!
+	 * @brief Start the receive thread, the camera must be started
+	 */
+	bool Start();
+	/*!
+	 * @brief Stop the receive thread, call after StopCamera
+	 */
+	void Stop();
+	bool IsRunning() const { return m_running; }
+	// The configuration in use, with the scale which gives an even image size
+	const ftIF2013BrokerConfig& GetConfig() const { return m_config; }
+
+	/*!
+	 * @brief Get the next frame of a subscriber
+	 * @return false on timeout, if the broker stopped or for an unknown subscriber
+	 */
+	bool GetFrame(int subscriber, ftIF2013BrokerFrame* frame, int timeout_ms = 1000);
+
+	void GetStats(ftIF2013BrokerStats* stats);
+	bool GetStats(int subscriber, ftIF2013BrokerSubscriberStats* stats);
+
+protected:
+	friend class ftIF2013BrokerFrame;
+
+	struct Subscriber
+	{
+		Subscriber(int depth, int policy) : m_queue(depth), m_depth(depth), m_policy(policy), m_active(true), m_delivered(0), m_dropped(0) {}
+		ftIF2013PipelineQueue<ftIF2013BrokerFrame> m_queue;
+		int m_depth;
+		int m_policy;
+		bool m_active;
+		std::atomic<INT32> m_delivered;
+		std::atomic<INT32> m_dropped;
+	};
+
+	void ReceiveThread();
+	// Decode a frame into a frame of the image pool, called by GetImage
+	ftIF2013FrameHandle Decode(const ftIF2013FrameHandle& jpeg);
+	Subscriber* GetSubscriber(int subscriber);
+
+	ftIF2013TransferAreaComHandler* m_handler;
+	ftIF2013BrokerConfig m_config;
+	std::atomic<bool> m_running;
+	ftIF2013FramePool* m_imagepool;
+	size_t m_imagesize;
+	std::thread m_receivethread;
+
+	// Subscribers are only deleted with the broker, GetFrame may still wait on the queue
+	std::mutex m_subscribermutex;
+	std::vector<Subscriber*> m_subscribers;
+
+	// Statistics
+	std::chrono::steady_clock::time_point m_start;
+	std::atomic<INT32> m_received;
+	std::atomic<INT32> m_receivedropped;
+	std::atomic<INT32> m_decoded;
+	std::atomic<INT32> m_decodeerrors;
+	std::atomic<INT32> m_decodedropped;
+	std::atomic<INT32> m_imagesshared;
+};
+
+#endif // ftProInterface2013CameraBroker_H
@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013CameraGovernor.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Adaptive camera resolution and frame rate
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013CameraGovernor
+//
+// Update keeps two time stamps: the first Update of the current overload and
+// the first Update of the current period within the limits. Values between
+// hysteresis * limit and the limit reset both, so neither step is taken.
+// An empty time point (time_since_epoch 0) means "not running".
+//
+// SetMode: the previous mode is restarted if the new one can't be started,
+// m_mode always is the mode the camera runs with.
+//
+// Changes: 2026-10-19
+//          First version
+//          Restart the previous mode if a mode change fails
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "ftProInterface2013CameraGovernor.h"
+
+using namespace std;
+
+// Tested modes of the ft camera, see Camera/Resolutions.txt
+static const ftIF2013CameraMode s_defaultmodes[] =
+{
+    { 160, 120, 60 },   // 1.15 MPixel/s
+    { 320, 240, 30 },   // 2.3 MPixel/s
+    { 640, 480, 15 },   // 4.6 MPixel/s, usually with some frames dropped
+};
+
+// Limit of the uptime multiplier of a mode which failed after a step up
+static const int MaxUpFactor = 8;
+
+ftIF2013CameraGovernor::ftIF2013CameraGovernor(ftIF2013TransferAreaComHandler* handler, const ftIF2013GovernorConfig& config,
+    const ftIF2013CameraMode* modes, int count) :
+    m_handler(handler),
+    m_config(config),
+    m_mode(0),
+    m_started(false),
+    m_failed(false),
+    m_stepsdown(0),
+    m_stepsup(0),
+    m_probing(false)
+{
+    if (!modes || count <= 0)
+    {
+        modes = s_defaultmodes;
+        count = sizeof(s_defaultmodes) / sizeof(s_defaultmodes[0]);
+    }
+    m_modes.assign(modes, modes + count);
+    m_upfactor.assign(count, 1);
+    if (m_config.minframes < 2) m_config.minframes = 2;
+}
+
+ftIF2013CameraGovernor::~ftIF2013CameraGovernor()
+{
+    Stop();
+}
+
+bool ftIF2013CameraGovernor::Start(int mode)
+{
+    if (m_started)
+    {
+        cerr << "ftIF2013CameraGovernor::Start: Camera already started" << endl;
+        return false;
+    }
+    if (mode < 0 || mode >= (int)m_modes.size())
+    {
+        mode = (int)m_modes.size() - 1;
+    }
+    m_stepsdown = 0;
+    m_stepsup = 0;
+    m_probing = false;
+    m_failed = false;
+    for (size_t i = 0; i < m_upfactor.size(); i++)
+    {
+        m_upfactor[i] = 1;
+    }
+    return SetMode(mode);
+}
+
+void ftIF2013CameraGovernor::Stop()
+{
+    if (m_started)
+    {
+        m_handler->StopCamera();
+        m_started = false;
+    }
+    m_failed = false;
+}
+
+double ftIF2013CameraGovernor::Seconds(TimePoint start, TimePoint end) const
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+bool ftIF2013CameraGovernor::SetMode(int mode)
+{
+    bool restart = m_started;
+    int previous = m_mode;
+    if (m_started)
+    {
+        m_handler->StopCamera();
+        m_started = false;
+    }
+
+    m_modestart = std::chrono::steady_clock::now();
+    m_overload = TimePoint();
+    m_good = TimePoint();
+    const ftIF2013CameraMode& next = m_modes[mode];
+    if (m_handler->StartCamera(next.width, next.height, next.framerate, m_config.powerlinefreq))
+    {
+        m_mode = mode;
+        m_started = true;
+        return true;
+    }
+    cerr << "ftIF2013CameraGovernor: Cannot start the camera with " << next.width << "x" << next.height << "@" << next.framerate << endl;
+
+    // Back to the mode which worked
+    if (restart)
+    {
+        const ftIF2013CameraMode& last = m_modes[previous];
+        if (m_handler->StartCamera(last.width, last.height, last.framerate, m_config.powerlinefreq))
+        {
+            m_started = true;
+            return false;
+        }
+        cerr << "ftIF2013CameraGovernor: Cannot restart the camera with " << last.width << "x" << last.height << "@" << last.framerate << endl;
+    }
+    m_mode = mode;
+    m_failed = true;
+    return false;
+}
+
+int ftIF2013CameraGovernor::Update(const ftIF2013CycleStats* cycles)
+{
+    if (!m_started)
+    {
+        return m_failed ? FTIF2013_GOVERNOR_FAILED : FTIF2013_GOVERNOR_UNCHANGED;
+    }
+
+    ftIF2013CameraStats stats;
+    m_handler->GetCameraStats(&stats);
+    if (stats.m_frames < m_config.minframes)
+    {
+        return 0;
+    }
+
+    TimePoint now = std::chrono::steady_clock::now();
+    if (m_probing && Seconds(m_modestart, now) >= m_config.uptime)
+    {
+        // The step up has been confirmed
+        m_probing = false;
+        m_upfactor[m_mode] = 1;
+    }
+
+    // Each value as a fraction of its limit, > 1 is an overload
+    double load = 0;
+    if (m_config.maxdroprate > 0)
+    {
+        load = stats.m_droprate / m_config.maxdroprate;
+    }
+    if (m_config.maxjitter > 0 && stats.m_interval > 0)
+    {
+        double jitter = stats.m_jitter / stats.m_interval / m_config.maxjitter;
+        if (jitter > load) load = jitter;
+    }
+    if (m_config.maxexchange > 0 && cycles && cycles->m_cycles > 0)
+    {
+        double exchange = cycles->m_exchange / m_config.maxexchange;
+        if (exchange > load) load = exchange;
+    }
+
+    if (load > 1)
+    {
+        m_good = TimePoint();
+        if (m_overload.time_since_epoch().count() == 0)
+        {
+            m_overload = now;
+        }
+        if (Seconds(m_overload, now) < m_config.downtime || m_mode == 0)
+        {
+            return 0;
+        }
+        if (m_probing && m_upfactor[m_mode] < MaxUpFactor)
+        {
+            // Don't try this mode again so soon
+            m_upfactor[m_mode] *= 2;
+        }
+        m_probing = false;
+        m_stepsdown++;
+        if (SetMode(m_mode - 1)) return FTIF2013_GOVERNOR_DOWN;
+        return m_started ? FTIF2013_GOVERNOR_UNCHANGED : FTIF2013_GOVERNOR_FAILED;
+    }
+
+    m_overload = TimePoint();
+    if (load > m_config.hysteresis)
+    {
+        m_good = TimePoint();
+        return 0;
+    }
+    if (m_good.time_since_epoch().count() == 0)
+    {
+        m_good = now;
+    }
+    if (m_mode + 1 >= (int)m_modes.size() || Seconds(m_good, now) < m_config.uptime * m_upfactor[m_mode + 1])
+    {
+        return 0;
+    }
+    m_probing = true;
+    m_stepsup++;
+    if (SetMode(m_mode + 1)) return FTIF2013_GOVERNOR_UP;
+    // As for a failed probe: don't try this mode again so soon
+    m_probing = false;
+    if (m_started && m_upfactor[m_mode + 1] < MaxUpFactor) m_upfactor[m_mode + 1] *= 2;
+    return m_started ? FTIF2013_GOVERNOR_UNCHANGED : FTIF2013_GOVERNOR_FAILED;
+}
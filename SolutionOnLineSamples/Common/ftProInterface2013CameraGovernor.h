@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013CameraGovernor.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Adaptive camera resolution and frame rate
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013CameraGovernor
+//
+// The TXT drops or distorts frames beyond about 2.3 MPixel/s (320x240@30fps,
+// see Camera/Resolutions.txt), WLAN load makes it worse. The governor switches
+// the camera between a table of tested modes, ordered by pixel rate (default
+// 160x120@60, 320x240@30, 640x480@15):
+// - one mode down if frames are dropped, the frame interval jitters or the
+//   transfers of the TA communication thread take too long for downtime
+// - one mode up if all values have been below hysteresis * limit for uptime.
+//   If the higher mode fails again within uptime, the uptime of this mode is
+//   doubled (up to 8 times), so the governor doesn't oscillate.
+// The rolling camera statistics start again with each StartCamera, a new mode
+// is judged after minframes frames.
+//
+//   ftIF2013CameraGovernor governor( ComHandler );
+//   governor.Start();
+//   for(;;)
+//   {
+//       ComHandler->GetCameraFrame( &frame );
+//       ...
+//       int change = governor.Update();
+//       if( change == FTIF2013_GOVERNOR_FAILED )
+//       {
+//           // the camera is stopped
+//       }
+//       else if( change != 0 )
+//       {
+//           // the next frames have the size of governor.GetMode()
+//       }
+//   }
+//   governor.Stop();
+//
+// ATTENTION: Update calls StopCamera/StartCamera, so it must be called from the
+// main thread while no other thread waits in GetCameraFrame (e.g. between two
+// frames of the receive loop, or with a stopped ftIF2013CameraPipeline).
+// Buffers, pipelines and recorders which depend on the frame size must be
+// recreated after a change.
+// If the camera can't be started in the new mode, the governor restarts the
+// previous one (Update returns 0). If that fails too, the camera stays
+// stopped and Update returns FTIF2013_GOVERNOR_FAILED until Start is called.
+//
+// see also: ftIF2013TransferAreaComHandler::GetCameraStats,
+//           ftIF2013TransferAreaComHandlerEx::GetCycleStats
+//
+// Changes: 2026-10-19
+//          First version
+//          Restart the previous mode if a mode change fails
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection
+#if(!defined(ftProInterface2013CameraGovernor_H))
+#define ftProInterface2013CameraGovernor_H
+
+#include <chrono>
+#include <vector>
+#include "ftProInterface2013TransferAreaCom.h"
+
+// Results of ftIF2013CameraGovernor::Update
+enum ftIF2013GovernorChange
+{
+	FTIF2013_GOVERNOR_FAILED = -2,  // the camera can't be started, it is stopped
+	FTIF2013_GOVERNOR_DOWN = -1,
+	FTIF2013_GOVERNOR_UNCHANGED = 0,
+	FTIF2013_GOVERNOR_UP = 1
+};
+
+/*!
+ * @brief A camera mode as given to StartCamera
+ */
+struct ftIF2013CameraMode
+{
+	int width;
+	int height;
+	int framerate;
+};
+
+/*!
+ * @brief Limits of the governor, see the module description
+ */
+struct ftIF2013GovernorConfig
+{
+	double maxdroprate = 0.10;  // dropped frames / frames of the camera (rolling)
+	double maxjitter = 0.35;    // jitter / frame interval (rolling)
+	double maxexchange = 30.0;  // average transfer time of the TA thread [ms], 0 = not checked
+	double hysteresis = 0.5;    // step up only below hysteresis * limit
+	double downtime = 1.0;      // overload for this time before a step down [s]
+	double uptime = 10.0;       // within the limits for this time before a step up [s]
+	int minframes = 16;         // frames after StartCamera before a mode is judged
+	int powerlinefreq = 50;     // as given to StartCamera
+};
+
+/*!
+ * @brief Steps the camera mode up or down, see the module description
+ */
+class ftIF2013CameraGovernor
+{
+public:
+	/*!
+	 * @param modes table ordered by increasing pixel rate, nullptr = default modes
+	 */
+	ftIF2013CameraGovernor(ftIF2013TransferAreaComHandler* handler, const ftIF2013GovernorConfig& config = ftIF2013GovernorConfig(),
+		const ftIF2013CameraMode* modes = nullptr, int count = 0);
+	~ftIF2013CameraGovernor();
+
+	/*!
+	 * @brief Start the camera
+	 * @param mode index in the mode table, -1 = the highest mode
+	 */
+	bool Start(int mode = -1);
+	void Stop();
+
+	/*!
+	 * @brief Check the statistics and change the mode if needed, call once per frame
+	 * @param cycles timing of the TA communication thread (GetCycleStats),
+	 *               nullptr if there is none
+	 * @return ftIF2013GovernorChange: -1 stepped down, 1 stepped up, 0 unchanged,
+	 *         FTIF2013_GOVERNOR_FAILED the camera is stopped
+	 */
+	int Update(const ftIF2013CycleStats* cycles = nullptr);
+
+	bool IsStarted() const { return m_started; }
+	int GetModeIndex() const { return m_mode; }
+	const ftIF2013CameraMode& GetMode() const { return m_modes[m_mode]; }
+	int GetModeCount() const { return (int)m_modes.size(); }
+	INT32 GetStepsDown() const { return m_stepsdown; }
+	INT32 GetStepsUp() const { return m_stepsup; }
+
+protected:
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	bool SetMode(int mode);
+	double Seconds(TimePoint start, TimePoint end) const;
+
+	ftIF2013TransferAreaComHandler* m_handler;
+	ftIF2013GovernorConfig m_config;
+	std::vector<ftIF2013CameraMode> m_modes;
+	std::vector<int> m_upfactor;   // per mode: multiplier of uptime
+	int m_mode;
+	bool m_started;
+	bool m_failed;                 // the camera could not be restarted
+	INT32 m_stepsdown;
+	INT32 m_stepsup;
+
+	TimePoint m_modestart;         // StartCamera of the current mode
+	TimePoint m_overload;          // first Update with overload, empty if none
+	TimePoint m_good;              // first Update within the limits, empty if none
+	bool m_probing;                // the current mode is a step up
+};
+
+#endif // ftProInterface2013CameraGovernor_H
@@ -0,0 +1,393 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013CameraPipeline.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Multi-stage camera pipeline: receive, decode workers, consumer
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013CameraPipeline
+//
+// Shutdown: the receive thread ends when GetCameraFrame fails (camera socket
+// closed) and closes the decode queue. The workers drain the decode queue,
+// the last worker closes the output queue, so GetFrame returns false after
+// the last frame. Stop additionally makes the workers drop queued frames.
+// It closes both queues before it joins the threads, so a lossless Push into
+// a full queue (the consumer stopped calling GetFrame) returns.
+//
+// Reorder window: the receive thread numbers the frames (tickets). Every
+// ticket reaches Deliver exactly once, also for frames which are dropped by
+// the decode queue, which cannot be decoded or get no image, so the window
+// never waits for a frame which doesn't come. The last worker flushes the
+// window before it closes the output queue.
+// Released frames are pushed outside of the window lock, so a full output
+// queue (lossless) only blocks the pushing thread: one thread pushes the
+// released frames in order, the others append to the list and go on. For
+// lossless the released frames still count against the window size.
+//
+// Changes: 2026-10-19
+//          First version
+//          Reorder window for in-order delivery
+//          Orientation of the images
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+
+#include "ftProInterface2013CameraPipeline.h"
+#include "ftProInterface2013JpegDecode.h"
+
+using namespace std;
+
+ftIF2013CameraPipeline::ftIF2013CameraPipeline(ftIF2013TransferAreaComHandler* handler, const ftIF2013PipelineConfig& config) :
+    m_handler(handler),
+    m_config(config),
+    m_running(false),
+    m_activeworkers(0),
+    m_imagepool(0),
+    m_imagesize(0),
+    m_decodequeue(config.queuedepth),
+    m_outputqueue(config.queuedepth),
+    m_reordernext(0),
+    m_reorderpushing(false),
+    m_tickets(0)
+{
+    if (m_config.workers < 1) m_config.workers = 1;
+    if (m_config.workers > 8) m_config.workers = 8;
+    if (m_config.scale < 1) m_config.scale = 1;
+    if (m_config.reorder < 0) m_config.reorder = 0;
+    if (m_config.orientation < FTPRO_ORIENT_NONE || m_config.orientation > FTPRO_ORIENT_ROT270) m_config.orientation = FTPRO_ORIENT_NONE;
+    m_reorder.resize(m_config.reorder);
+
+    int scale = m_config.scale;
+    m_imagesize = ftProPixelFormatSize(m_config.format, (m_config.width + scale - 1) / scale, (m_config.height + scale - 1) / scale);
+}
+
+ftIF2013CameraPipeline::~ftIF2013CameraPipeline()
+{
+    Stop();
+    delete m_imagepool;
+}
+
+bool ftIF2013CameraPipeline::Start()
+{
+    if (m_running || m_activeworkers != 0)
+    {
+        cerr << "ftIF2013CameraPipeline::Start: Pipeline already running" << endl;
+        return false;
+    }
+
+    // Enough frames that every stage can hold one while the queues and the
+    // reorder window are full (the queues hold their rounded up capacity)
+    int frames = m_config.workers + m_decodequeue.GetCapacity() + m_outputqueue.GetCapacity() + m_config.reorder + 2;
+    if (!m_handler->SetCameraFramePool(frames))
+    {
+        return false;
+    }
+    if (!m_imagepool)
+    {
+        m_imagepool = new ftIF2013FramePool(frames, m_imagesize);
+    }
+
+    m_received = 0;
+    m_receivedropped = 0;
+    m_decodequeuedropped = 0;
+    m_decoded = 0;
+    m_decodeerrors = 0;
+    m_decodedropped = 0;
+    m_outputdropped = 0;
+    m_reorderskipped = 0;
+    m_reorderlate = 0;
+    m_delivered = 0;
+    m_receivetime = 0;
+    m_decodetime = 0;
+    m_latency = 0;
+    m_latencymax = 0;
+    m_start = std::chrono::steady_clock::now();
+    m_reordernext = 0;
+    m_reorderready.clear();
+    m_reorderpushing = false;
+    m_tickets = 0;
+
+    m_decodequeue.Open();
+    m_outputqueue.Open();
+    m_running = true;
+    m_activeworkers = m_config.workers;
+    for (int i = 0; i < m_config.workers; i++)
+    {
+        m_workers.push_back(std::thread([this] { DecodeThread(); }));
+    }
+    m_receivethread = std::thread([this] { ReceiveThread(); });
+    return true;
+}
+
+void ftIF2013CameraPipeline::Stop()
+{
+    m_running = false;
+    m_decodequeue.Close();
+    m_outputqueue.Close();
+    if (m_receivethread.joinable()) m_receivethread.join();
+    for (size_t i = 0; i < m_workers.size(); i++)
+    {
+        m_workers[i].join();
+    }
+    m_workers.clear();
+
+    // Return all queued frames to their pools
+    JpegEntry jpeg;
+    while (m_decodequeue.TryPop(&jpeg)) {}
+    ftIF2013PipelineFrame frame;
+    while (m_outputqueue.TryPop(&frame)) {}
+    for (size_t i = 0; i < m_reorder.size(); i++)
+    {
+        m_reorder[i] = ReorderSlot();
+    }
+    m_reorderready.clear();
+}
+
+void ftIF2013CameraPipeline::AddTime(std::atomic<long long>* sum, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    *sum += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+}
+
+void ftIF2013CameraPipeline::ReceiveThread()
+{
+    bool latest = (m_config.policy == FTIF2013_PIPE_LATEST);
+
+    while (m_running)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        JpegEntry entry;
+        if (!m_handler->GetCameraFrame(&entry.m_jpeg))
+        {
+            if (m_running) cerr << "ftIF2013CameraPipeline: Receive stopped" << endl;
+            break;
+        }
+        entry.m_received = std::chrono::steady_clock::now();
+        if (!entry.m_jpeg)
+        {
+            // All JPEG frames are in use
+            m_receivedropped++;
+            continue;
+        }
+        m_received++;
+        AddTime(&m_receivetime, start, entry.m_received);
+        entry.m_ticket = m_tickets++;
+
+        // A dropped frame leaves its ticket in the reorder window
+        if (!m_decodequeue.Push(entry, latest, &m_decodequeuedropped,
+            [this](JpegEntry& dropped) { Deliver(dropped.m_ticket, nullptr); }))
+        {
+            break;
+        }
+    }
+    m_decodequeue.Close();
+}
+
+void ftIF2013CameraPipeline::DecodeThread()
+{
+    bool latest = (m_config.policy == FTIF2013_PIPE_LATEST);
+    // Each worker keeps its own decoder object
+    ftProJpegDecoder decoder;
+
+    while (m_running)
+    {
+        JpegEntry entry;
+        if (!m_decodequeue.Pop(&entry, 100))
+        {
+            if (m_decodequeue.IsClosed() && m_decodequeue.GetCount() <= 0) break;
+            continue;
+        }
+
+        ftIF2013FrameHandle image = m_imagepool->Acquire(m_imagesize);
+        while (!image && !latest && m_running)
+        {
+            // Lossless: wait until the consumer releases an image
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            image = m_imagepool->Acquire(m_imagesize);
+        }
+        if (!image)
+        {
+            m_decodedropped++;
+            Deliver(entry.m_ticket, nullptr);
+            continue;
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t bytesread = 0;
+        if (!decoder.Decode(entry.m_jpeg.GetData(), (int)entry.m_jpeg.GetSize(), image.GetData(), (int)m_imagesize, &bytesread, m_config.format, m_config.scale, nullptr, m_config.orientation))
+        {
+            m_decodeerrors++;
+            Deliver(entry.m_ticket, nullptr);
+            continue;
+        }
+        m_decoded++;
+        AddTime(&m_decodetime, start, std::chrono::steady_clock::now());
+
+        ftIF2013PipelineFrame frame;
+        frame.m_sequence = entry.m_jpeg.GetSequence();
+        frame.m_framenumber = entry.m_jpeg.GetFrameNumber();
+        frame.m_jpeg = std::move(entry.m_jpeg);
+        frame.m_image = std::move(image);
+        frame.m_bytesread = bytesread;
+        frame.m_received = entry.m_received;
+        if (!Deliver(entry.m_ticket, &frame))
+        {
+            break;
+        }
+    }
+
+    if (--m_activeworkers == 0)
+    {
+        if (m_running) FlushReorder();
+        m_outputqueue.Close();
+    }
+}
+
+bool ftIF2013CameraPipeline::Deliver(INT32 ticket, ftIF2013PipelineFrame* frame)
+{
+    bool latest = (m_config.policy == FTIF2013_PIPE_LATEST);
+    INT32 window = m_config.reorder;
+
+    if (window == 0)
+    {
+        return !frame || m_outputqueue.Push(*frame, latest, &m_outputdropped);
+    }
+
+    std::unique_lock<std::mutex> lock(m_reordermutex);
+    if (ticket < m_reordernext)
+    {
+        // Skipped already, a newer frame has been delivered
+        if (frame) m_reorderlate++;
+        return true;
+    }
+    if (latest)
+    {
+        // Window full: give up the oldest frame if it is still missing
+        while (ticket - m_reordernext >= window)
+        {
+            ReleaseOldest();
+        }
+    }
+    else
+    {
+        // The worker of the oldest frame moves the window on, the pushing
+        // thread empties the released frames
+        while (ticket - m_reordernext + (INT32)m_reorderready.size() >= window)
+        {
+            if (!m_running) return false;
+            m_reordercv.wait_for(lock, std::chrono::milliseconds(100));
+        }
+    }
+
+    ReorderSlot& slot = m_reorder[ticket % window];
+    if (frame)
+    {
+        slot.m_frame = std::move(*frame);
+        slot.m_state = REORDER_FRAME;
+    }
+    else
+    {
+        slot.m_state = REORDER_SKIP;
+    }
+
+    // Deliver all frames which are complete from the oldest on
+    while (m_reorder[m_reordernext % window].m_state != REORDER_EMPTY)
+    {
+        ReleaseOldest();
+    }
+    return PushReady(lock);
+}
+
+void ftIF2013CameraPipeline::ReleaseOldest()
+{
+    ReorderSlot& slot = m_reorder[m_reordernext % m_config.reorder];
+
+    if (slot.m_state == REORDER_FRAME)
+    {
+        m_reorderready.push_back(std::move(slot.m_frame));
+    }
+    else if (slot.m_state == REORDER_EMPTY)
+    {
+        m_reorderskipped++;
+    }
+    slot = ReorderSlot();
+    m_reordernext++;
+    m_reordercv.notify_all();
+}
+
+bool ftIF2013CameraPipeline::PushReady(std::unique_lock<std::mutex>& lock)
+{
+    if (m_reorderpushing)
+    {
+        // The pushing thread also takes the frames released by this one
+        return !m_outputqueue.IsClosed();
+    }
+
+    bool latest = (m_config.policy == FTIF2013_PIPE_LATEST);
+    bool result = true;
+    m_reorderpushing = true;
+    while (!m_reorderready.empty())
+    {
+        ftIF2013PipelineFrame frame = std::move(m_reorderready.front());
+        m_reorderready.pop_front();
+        m_reordercv.notify_all();
+        lock.unlock();
+        // After a failed push the frames are only released
+        if (result && !m_outputqueue.Push(frame, latest, &m_outputdropped))
+        {
+            result = false;
+        }
+        frame = ftIF2013PipelineFrame();
+        lock.lock();
+    }
+    m_reorderpushing = false;
+    return result;
+}
+
+void ftIF2013CameraPipeline::FlushReorder()
+{
+    if (m_config.reorder == 0) return;
+
+    std::unique_lock<std::mutex> lock(m_reordermutex);
+    while (m_reordernext < m_tickets)
+    {
+        ReleaseOldest();
+    }
+    PushReady(lock);
+}
+
+bool ftIF2013CameraPipeline::GetFrame(ftIF2013PipelineFrame* frame, int timeout_ms)
+{
+    if (!m_outputqueue.Pop(frame, timeout_ms))
+    {
+        return false;
+    }
+    m_delivered++;
+
+    long long latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frame->m_received).count();
+    m_latency += latency;
+    long long max = m_latencymax;
+    while (latency > max && !m_latencymax.compare_exchange_weak(max, latency)) {}
+    return true;
+}
+
+void ftIF2013CameraPipeline::GetStats(ftIF2013PipelineStats* stats)
+{
+    stats->m_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    stats->m_received = m_received;
+    stats->m_receivedropped = m_receivedropped;
+    stats->m_decodequeuedropped = m_decodequeuedropped;
+    stats->m_decoded = m_decoded;
+    stats->m_decodeerrors = m_decodeerrors;
+    stats->m_decodedropped = m_decodedropped;
+    stats->m_outputdropped = m_outputdropped;
+    stats->m_reorderskipped = m_reorderskipped;
+    stats->m_reorderlate = m_reorderlate;
+    stats->m_delivered = m_delivered;
+    stats->m_receivetime = m_received ? m_receivetime / 1000.0 / m_received : 0;
+    stats->m_decodetime = m_decoded ? m_decodetime / 1000.0 / m_decoded : 0;
+    stats->m_latency = m_delivered ? m_latency / 1000.0 / m_delivered : 0;
+    stats->m_latencymax = m_latencymax / 1000.0;
+}
@@ -0,0 +1,401 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013CameraPipeline.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Multi-stage camera pipeline: receive, decode workers, consumer
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013CameraPipeline
+//
+//   receive thread --> decode queue --> N decode workers --> output queue --> GetFrame
+//
+// The receive thread calls GetCameraFrame on the camera socket of the handler,
+// the workers decode into frames of an own pool, so no stage waits for another
+// one as long as frames are free. The queues are bounded and lock-free, a
+// thread only sleeps when its queue is empty (or full for lossless).
+//
+// Policy:
+//   FTIF2013_PIPE_LATEST   a full queue drops its oldest frame, the consumer
+//                          always gets the newest image (control loops)
+//   FTIF2013_PIPE_LOSSLESS a full queue blocks the producer, in the end the
+//                          camera server waits for the acknowledge (recording)
+//
+// With more than one worker the frames can be decoded out of order. A reorder
+// window (ftIF2013PipelineConfig::reorder) between the workers and the output
+// queue delivers them in receive order, i.e. in increasing m_numframeready of
+// the camera server. The window holds at most reorder frames:
+//   FTIF2013_PIPE_LATEST   a frame which is still missing when the window is
+//                          full is skipped, a late frame is dropped
+//   FTIF2013_PIPE_LOSSLESS a worker waits until the window has room
+// Without window (reorder=0) the frames are delivered as decoded, see
+// ftIF2013PipelineFrame::m_sequence.
+//
+// ATTENTION: StartCamera/StopCamera must still be called from the main thread.
+// Call Stop after StopCamera: the receive thread ends when the camera socket
+// is closed.
+//
+// see also: ftIF2013TransferAreaComHandler::GetCameraFrame
+//
+// Changes: 2026-10-19
+//          First version
+//          Reorder window for in-order delivery
+//          Orientation of the images
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection 
+#if(!defined(ftProInterface2013CameraPipeline_H))
+#define ftProInterface2013CameraPipeline_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
+#include "ftProInterface2013TransferAreaCom.h"
+#include "ftProInterface2013FramePool.h"
+
+//******************************************************************************
+//*
+//* Bounded lock-free queue (multi producer, multi consumer), used as SPSC or
+//* MPSC. Every cell has a sequence number which tells whether it may be
+//* written or read in the current round. Only a thread which has to wait
+//* takes the mutex.
+//*
+//******************************************************************************
+
+template <class T>
+class ftIF2013PipelineQueue
+{
+public:
+	// capacity is rounded up to a power of 2
+	explicit ftIF2013PipelineQueue(int capacity) :
+		m_head(0), m_tail(0), m_waiting(0), m_closed(false)
+	{
+		size_t size = 2;
+		while (size < (size_t)capacity) size *= 2;
+		m_cells = std::vector<Cell>(size);
+		m_mask = size - 1;
+		for (size_t i = 0; i < size; i++) m_cells[i].m_sequence = i;
+	}
+
+	bool TryPush(T& value)
+	{
+		if (!Enqueue(value)) return false;
+		Wake();
+		return true;
+	}
+
+	bool TryPop(T* value)
+	{
+		if (!Dequeue(value)) return false;
+		Wake();
+		return true;
+	}
+
+	// Push with policy: latest=true drops the oldest entries of a full queue
+	// (counted in dropped, passed to ondrop), else wait until there is room.
+	// Returns false if the queue is closed.
+	template <class OnDrop>
+	bool Push(T& value, bool latest, std::atomic<INT32>* dropped, OnDrop ondrop)
+	{
+		for (;;)
+		{
+			if (m_closed) return false;
+			if (TryPush(value)) return true;
+			if (latest)
+			{
+				T oldest;
+				if (TryPop(&oldest))
+				{
+					if (dropped) (*dropped)++;
+					ondrop(oldest);
+				}
+			}
+			else
+			{
+				WaitFor([&] { return m_closed || !IsFull(); }, 100);
+			}
+		}
+	}
+	bool Push(T& value, bool latest, std::atomic<INT32>* dropped)
+	{
+		return Push(value, latest, dropped, [](T&) {});
+	}
+
+	// Wait up to timeout_ms for an entry. Returns false on timeout or if the
+	// queue is closed and empty.
+	bool Pop(T* value, int timeout_ms)
+	{
+		if (TryPop(value)) return true;
+		bool result = false;
+		WaitFor([&] { return (result = Dequeue(value)) || m_closed; }, timeout_ms);
+		if (result) Wake();
+		return result;
+	}
+
+	// Wake up all waiting threads, Push fails from now on
+	void Close()
+	{
+		m_closed = true;
+		std::lock_guard<std::mutex> lock(m_waitmutex);
+		m_waitcv.notify_all();
+	}
+	void Open() { m_closed = false; }
+	bool IsClosed() const { return m_closed; }
+
+	int GetCount() const { return (int)(m_tail.load() - m_head.load()); }
+	// Entries the queue can hold (the rounded up capacity)
+	int GetCapacity() const { return (int)(m_mask + 1); }
+
+protected:
+	struct Cell
+	{
+		Cell() : m_sequence(0) {}
+		Cell(const Cell& other) : m_sequence(other.m_sequence.load()) {}
+		std::atomic<size_t> m_sequence;
+		T m_value;
+	};
+
+	// Lock-free part of TryPush/TryPop
+	bool Enqueue(T& value)
+	{
+		size_t pos = m_tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell* cell = &m_cells[pos & m_mask];
+			size_t seq = cell->m_sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0)
+			{
+				if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) 
+				{
+					cell->m_value = std::move(value);
+					cell->m_sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0) return false;
+			else pos = m_tail.load(std::memory_order_relaxed);
+		}
+	}
+
+	bool Dequeue(T* value)
+	{
+		size_t pos = m_head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Cell* cell = &m_cells[pos & m_mask];
+			size_t seq = cell->m_sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0)
+			{
+				if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					*value = std::move(cell->m_value);
+					cell->m_value = T();
+					cell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0) return false;
+			else pos = m_head.load(std::memory_order_relaxed);
+		}
+	}
+
+	bool IsFull() const { return m_tail.load() - m_head.load() > m_mask; }
+
+	// Called after each push and pop: only lock if somebody waits
+	void Wake()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_waiting.load() != 0)
+		{
+			std::lock_guard<std::mutex> lock(m_waitmutex);
+			m_waitcv.notify_all();
+		}
+	}
+
+	template <class Predicate>
+	void WaitFor(Predicate predicate, int timeout_ms)
+	{
+		std::unique_lock<std::mutex> lock(m_waitmutex);
+		m_waiting++;
+		m_waitcv.wait_for(lock, std::chrono::milliseconds(timeout_ms), predicate);
+		m_waiting--;
+	}
+
+	std::vector<Cell> m_cells;
+	size_t m_mask;
+	std::atomic<size_t> m_head;
+	std::atomic<size_t> m_tail;
+	std::atomic<int> m_waiting;
+	std::atomic<bool> m_closed;
+	std::mutex m_waitmutex;
+	std::condition_variable m_waitcv;
+};
+
+//******************************************************************************
+//*
+//* Camera pipeline
+//*
+//******************************************************************************
+
+enum ftIF2013PipelinePolicy
+{
+	FTIF2013_PIPE_LATEST = 0,
+	FTIF2013_PIPE_LOSSLESS
+};
+
+struct ftIF2013PipelineConfig
+{
+	int width;       // frame size as given to StartCamera
+	int height;
+	int workers;     // number of decode threads, 1..8
+	int queuedepth;  // entries of the decode and the output queue (rounded up to a power of 2)
+	int policy;      // ftIF2013PipelinePolicy
+	int format;      // ftProPixelFormat of the images, default FTPRO_PIXEL_YUYV
+	int scale;       // decode at 1/scale of the size: 1 (or 0), 2, 4 or 8
+	int reorder;     // frames of the reorder window, 0 = deliver as decoded (see module description)
+	int orientation; // ftProOrientation of the images (mounted camera), width and height are
+	                 // swapped for ROT90, ROT270, TRANSPOSE and TRANSVERSE
+};
+
+/*!
+ * @brief A decoded frame: the JPEG data and the image
+ */
+struct ftIF2013PipelineFrame
+{
+	ftIF2013FrameHandle m_jpeg;
+	ftIF2013FrameHandle m_image;   // in ftIF2013PipelineConfig::format
+	INT32  m_sequence;             // number of the frame since StartCamera
+	INT32  m_framenumber;          // m_numframeready of the camera server
+	size_t m_bytesread;            // JPEG bytes used by the decoder (for the EOI repair)
+	std::chrono::steady_clock::time_point m_received;
+};
+
+/*!
+ * @brief Counters of all stages since Start
+ * Throughput of a stage = count / m_elapsed
+ */
+struct ftIF2013PipelineStats
+{
+	double m_elapsed;           // [s]
+	INT32  m_received;          // frames received
+	INT32  m_receivedropped;    // no free JPEG frame in the pool of the handler
+	INT32  m_decodequeuedropped;// dropped by a full decode queue (latest)
+	INT32  m_decoded;
+	INT32  m_decodeerrors;
+	INT32  m_decodedropped;     // no free image frame (latest)
+	INT32  m_outputdropped;     // dropped by a full output queue (latest)
+	INT32  m_reorderskipped;    // missing when the reorder window was full (latest)
+	INT32  m_reorderlate;       // decoded after being skipped, dropped
+	INT32  m_delivered;         // frames returned by GetFrame
+	double m_receivetime;       // average time per received frame [ms]
+	double m_decodetime;        // average decode time [ms]
+	double m_latency;           // average time from receive to GetFrame [ms]
+	double m_latencymax;        // [ms]
+};
+
+class ftIF2013CameraPipeline
+{
+public:
+	ftIF2013CameraPipeline(ftIF2013TransferAreaComHandler* handler, const ftIF2013PipelineConfig& config);
+	~ftIF2013CameraPipeline();
+
+	/*!
+	 * @brief Start the receive thread and the decode workers, the camera must be started
+	 */
+	bool Start();
+	/*!
+	 * @brief Stop all threads, call after StopCamera (see module description)
+	 */
+	void Stop();
+	/*!
+	 * @return any thread of the pipeline still runs
+	 */
+	bool IsRunning() const { return m_activeworkers != 0; }
+
+	/*!
+	 * @brief Get the next decoded frame
+	 * @return false on timeout or if the pipeline stopped
+	 */
+	bool GetFrame(ftIF2013PipelineFrame* frame, int timeout_ms = 1000);
+
+	void GetStats(ftIF2013PipelineStats* stats);
+
+protected:
+	struct JpegEntry
+	{
+		ftIF2013FrameHandle m_jpeg;
+		INT32 m_ticket;  // receive order, also for frames which are not decoded
+		std::chrono::steady_clock::time_point m_received;
+	};
+
+	// Slot of the reorder window for ticket % reorder
+	enum ReorderState { REORDER_EMPTY = 0, REORDER_FRAME, REORDER_SKIP };
+	struct ReorderSlot
+	{
+		ReorderSlot() : m_state(REORDER_EMPTY) {}
+		int m_state;
+		ftIF2013PipelineFrame m_frame;
+	};
+
+	void ReceiveThread();
+	void DecodeThread();
+	// Hand a decoded frame (or nullptr for a frame which is not decoded) to the
+	// reorder window or directly to the output queue.
+	// Returns false if the pipeline stops.
+	bool Deliver(INT32 ticket, ftIF2013PipelineFrame* frame);
+	// Move the oldest slot of the window to m_reorderready, m_reordermutex is locked
+	void ReleaseOldest();
+	// Push the released frames into the output queue, outside of the lock.
+	// Only one thread pushes at a time, the others leave their frames to it.
+	// lock holds m_reordermutex. Returns false if the output queue is closed.
+	bool PushReady(std::unique_lock<std::mutex>& lock);
+	// Deliver the frames still in the window after the last ticket
+	void FlushReorder();
+	void AddTime(std::atomic<long long>* sum, std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end);
+
+	ftIF2013TransferAreaComHandler* m_handler;
+	ftIF2013PipelineConfig m_config;
+	std::atomic<bool> m_running;       // false: Stop was called
+	std::atomic<int> m_activeworkers;  // decode threads still running
+	ftIF2013FramePool* m_imagepool;
+	size_t m_imagesize;
+	ftIF2013PipelineQueue<JpegEntry> m_decodequeue;
+	ftIF2013PipelineQueue<ftIF2013PipelineFrame> m_outputqueue;
+	std::mutex m_reordermutex;
+	std::condition_variable m_reordercv;  // window moved on (lossless)
+	std::vector<ReorderSlot> m_reorder;
+	INT32 m_reordernext;                  // oldest ticket of the window
+	std::deque<ftIF2013PipelineFrame> m_reorderready;  // released, in order, not pushed yet
+	bool m_reorderpushing;                // a thread is in PushReady
+	std::atomic<INT32> m_tickets;         // tickets given by the receive thread
+	std::thread m_receivethread;
+	std::vector<std::thread> m_workers;
+
+	// Statistics
+	std::chrono::steady_clock::time_point m_start;
+	std::atomic<INT32> m_received;
+	std::atomic<INT32> m_receivedropped;
+	std::atomic<INT32> m_decodequeuedropped;
+	std::atomic<INT32> m_decoded;
+	std::atomic<INT32> m_decodeerrors;
+	std::atomic<INT32> m_decodedropped;
+	std::atomic<INT32> m_outputdropped;
+	std::atomic<INT32> m_reorderskipped;
+	std::atomic<INT32> m_reorderlate;
+	std::atomic<INT32> m_delivered;
+	std::atomic<long long> m_receivetime;  // sums [us]
+	std::atomic<long long> m_decodetime;
+	std::atomic<long long> m_latency;
+	std::atomic<long long> m_latencymax;
+};
+
+#endif // ftProInterface2013CameraPipeline_H
@@ -0,0 +1,289 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013CameraRing.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Pre-trigger ring of camera frames with a dump on an event
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013CameraRing
+//
+// The ring and the dump queue hold handles of the own pool, a frame in both
+// is stored once. Trigger copies the handles of the ring into the dump queue,
+// Add appends the frames up to the end of the post-trigger window to both.
+// The dump thread takes the frames one by one from the queue and writes them
+// with ftIF2013MjpegWriter (waiting for its writer thread, the frames are
+// in memory already), a written frame returns to the pool when the ring has
+// removed it too.
+//
+// Memory: a pool buffer grows to about twice the frame which doesn't fit and
+// keeps its size. When the buffers of the pool exceed maxbytes, Add frees the
+// unused ones and then removes the oldest frames of the ring until the new
+// frame fits; frames which still wait for the dump can't be freed, so during
+// a slow dump the ring may become short or the new frame is dropped.
+//
+// Changes: 2026-10-19
+//          First version
+//          maxbytes limits the memory of the pool buffers
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <iostream>
+
+#include "ftProInterface2013CameraRing.h"
+
+using namespace std;
+
+//******************************************************************************
+//****
+//**** Class ftIF2013CameraRing: Implementation
+//****
+//******************************************************************************
+
+static ftIF2013CameraRingConfig CheckedConfig(ftIF2013CameraRingConfig config)
+{
+    if (config.preseconds < 0) config.preseconds = 0;
+    if (config.postseconds < 0) config.postseconds = 0;
+    if (config.maxframes < 1) config.maxframes = 1;
+    if (config.framerate < 1) config.framerate = 1;
+    return config;
+}
+
+ftIF2013CameraRing::ftIF2013CameraRing(const ftIF2013CameraRingConfig& config) :
+    m_config(CheckedConfig(config)),
+    // The buffers grow with the first frames
+    m_pool(2 * m_config.maxframes, 0),
+    m_bytes(0),
+    m_dumping(false),
+    m_stop(false),
+    m_dropped(0),
+    m_dumpedframes(0),
+    m_dumpresult(false)
+{
+    m_thread = std::thread([this] { DumpThread(); });
+}
+
+ftIF2013CameraRing::~ftIF2013CameraRing()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_cv.notify_all();
+    }
+    m_thread.join();
+}
+
+bool ftIF2013CameraRing::Add(const ftIF2013FrameHandle& frame)
+{
+    if (!frame)
+    {
+        return false;
+    }
+    return Add(frame.GetData(), frame.GetSize(), *frame.GetInfo());
+}
+
+bool ftIF2013CameraRing::Add(const UINT8* jpeg, size_t size, const ftIF2013FrameInfo& info)
+{
+    if (size == 0)
+    {
+        return false;
+    }
+    std::chrono::steady_clock::time_point time = info.m_received.time_since_epoch().count() ? info.m_received : std::chrono::steady_clock::now();
+
+    Entry entry;
+    entry.m_frame = m_pool.Acquire(size);
+    while (!entry.m_frame)
+    {
+        // All buffers are in the ring or in the dump queue: remove the oldest
+        // frame of the ring, it is free unless it waits for the dump
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_ring.empty())
+            {
+                m_dropped++;
+                return false;
+            }
+            m_bytes -= m_ring.front().m_frame.GetSize();
+            m_ring.pop_front();
+        }
+        entry.m_frame = m_pool.Acquire(size);
+    }
+
+    // The buffers of the pool, not only the frames of the ring, stay within maxbytes
+    while (m_pool.GetAllocated() > m_config.maxbytes)
+    {
+        m_pool.FreeUnused();
+        if (m_pool.GetAllocated() <= m_config.maxbytes)
+        {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_ring.empty())
+        {
+            m_dropped++;
+            entry.m_frame.Reset();
+            m_pool.FreeUnused();
+            return false;
+        }
+        m_bytes -= m_ring.front().m_frame.GetSize();
+        m_ring.pop_front();
+    }
+
+    // The frame is only known here until it is in the ring
+    ftIF2013Frame* copy = entry.m_frame.GetFrame();
+    memcpy(copy->m_data, jpeg, size);
+    size = ftProJpegRepairEoi(copy->m_data, size, copy->m_capacity);
+    if (size == 0)
+    {
+        return false;
+    }
+    copy->m_size = size;
+    copy->m_info = info;
+    entry.m_time = time;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Trim(time, size);
+    m_ring.push_back(entry);
+    m_bytes += size;
+    if (m_dumping && time < m_postend)
+    {
+        m_dump.push_back(entry);
+        m_cv.notify_all();
+    }
+    return true;
+}
+
+void ftIF2013CameraRing::Trim(std::chrono::steady_clock::time_point now, size_t add)
+{
+    std::chrono::duration<double> keep(m_config.preseconds);
+    while (!m_ring.empty() &&
+        ((int)m_ring.size() >= m_config.maxframes ||
+         m_bytes + add > m_config.maxbytes ||
+         now - m_ring.front().m_time > keep))
+    {
+        m_bytes -= m_ring.front().m_frame.GetSize();
+        m_ring.pop_front();
+    }
+}
+
+bool ftIF2013CameraRing::Trigger(const char* filename)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_dumping || m_ring.empty())
+    {
+        return false;
+    }
+    m_filename = filename;
+    m_dump.assign(m_ring.begin(), m_ring.end());
+    m_postend = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(m_config.postseconds));
+    m_dumping = true;
+    m_cv.notify_all();
+    return true;
+}
+
+void ftIF2013CameraRing::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ring.clear();
+    m_bytes = 0;
+}
+
+bool ftIF2013CameraRing::IsDumping()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dumping;
+}
+
+bool ftIF2013CameraRing::WaitDump(int timeoutms)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_cv.wait_for(lock, std::chrono::milliseconds(timeoutms), [this] { return !m_dumping; });
+}
+
+int ftIF2013CameraRing::GetFrames()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (int)m_ring.size();
+}
+
+size_t ftIF2013CameraRing::GetBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+void ftIF2013CameraRing::DumpThread()
+{
+    // The write buffers are kept for the next dumps
+    ftIF2013MjpegWriter writer;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_cv.wait(lock, [this] { return m_dumping || m_stop; });
+        if (!m_dumping)
+        {
+            break;
+        }
+
+        std::string filename = m_filename;
+        bool ok = true;
+        INT32 frames = 0;
+        int width = 0, height = 0;
+        for (;;)
+        {
+            if (!m_dump.empty())
+            {
+                Entry entry = m_dump.front();
+                m_dump.pop_front();
+                lock.unlock();
+
+                const ftIF2013FrameInfo* info = entry.m_frame.GetInfo();
+                if (!writer.IsOpen() && ok)
+                {
+                    width = info->m_width;
+                    height = info->m_height;
+                    ok = writer.Open(filename.c_str(), width, height, m_config.framerate, m_config.orientation);
+                }
+                if (ok && info->m_width == width && info->m_height == height)
+                {
+                    if (writer.AddFrame(entry.m_frame.GetData(), entry.m_frame.GetSize(), true))
+                    {
+                        frames++;
+                    }
+                }
+                entry.m_frame.Reset();
+                lock.lock();
+            }
+            else if (m_stop || std::chrono::steady_clock::now() >= m_postend)
+            {
+                break;
+            }
+            else
+            {
+                m_cv.wait_until(lock, m_postend);
+            }
+        }
+        // Add doesn't queue frames anymore
+        m_postend = std::chrono::steady_clock::time_point();
+        m_dump.clear();
+        lock.unlock();
+
+        if (writer.IsOpen())
+        {
+            ok = writer.Close() && ok;
+        }
+        if (!ok)
+        {
+            cerr << "ftIF2013CameraRing: Cannot write " << filename << endl;
+        }
+
+        lock.lock();
+        m_dumpedframes = frames;
+        m_dumpresult = ok;
+        m_dumping = false;
+        m_cv.notify_all();
+    }
+}
@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013CameraRing.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Pre-trigger ring of camera frames with a dump on an event
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013CameraRing
+//
+// ftIF2013CameraRing keeps the compressed frames of the last preseconds in
+// RAM. Trigger (e.g. from a callback of a limit switch) writes these frames
+// and the frames of the next postseconds into an MJPEG AVI file:
+//
+//   ftIF2013CameraRing ring;
+//   ...
+//   ComHandler->GetCameraFrame( &frame );
+//   ring.Add( frame );
+//   ...
+//   if( jammed ) ring.Trigger( "H:/Log/jam.avi" );
+//
+// Add copies the frame into a buffer of the own frame pool (the frames of the
+// receiver return to its pool at once) and repairs the missing EOI. Trigger
+// only takes references of the frames in the ring and returns, a background
+// thread writes the file. Neither waits for the disk, the ring goes on with
+// the next frames during the dump.
+//
+// The ring is limited by preseconds, maxbytes and maxframes, the oldest
+// frames are removed first. The pool has 2 * maxframes buffers, so the ring
+// can be refilled while the frames of a dump are written. maxbytes limits
+// the memory of all buffers: the frames of the ring, those of a dump which
+// are not written yet and the free ones (GetMemory). A buffer has room for up
+// to twice the frame it grew for, so with frames of similar size the ring
+// holds about maxbytes/2 of frames or more while no dump is in progress. If no buffer is free or the frame
+// doesn't fit into maxbytes, it is not kept (GetDropped).
+// A dump only contains frames with the size of its first frame (the AVI
+// header has one size), there is one dump at a time.
+//
+// see also: ftIF2013MjpegWriter, ftIF2013FramePool
+//
+// Changes: 2026-10-19
+//          First version
+//          maxbytes limits the memory of the buffers
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection
+#if(!defined(ftProInterface2013CameraRing_H))
+#define ftProInterface2013CameraRing_H
+
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "ftProInterface2013FramePool.h"
+#include "ftProInterface2013MjpegRecorder.h"
+
+/*!
+ * @brief Size of the ring and of the dump, see the module description
+ */
+struct ftIF2013CameraRingConfig
+{
+	double preseconds = 5.0;        // frames kept before the trigger [s]
+	double postseconds = 2.0;       // frames added to the dump after the trigger [s]
+	size_t maxbytes = 16 * 1024 * 1024;  // memory of the frame buffers (ring, dump, free)
+	int maxframes = 150;            // frames in the ring
+	int framerate = 15;             // stored in the AVI file
+	int orientation = FTPRO_ORIENT_NONE;  // of the AVI file, see ftIF2013MjpegWriter::Open
+};
+
+/*!
+ * @brief Ring of the last camera frames, dumped into a file on a trigger
+ */
+class ftIF2013CameraRing
+{
+public:
+	explicit ftIF2013CameraRing(const ftIF2013CameraRingConfig& config = ftIF2013CameraRingConfig());
+	// Waits for the dump in progress (the post-trigger window is cut)
+	~ftIF2013CameraRing();
+
+	/*!
+	 * @brief Keep a copy of a received frame, the handle can be released afterwards
+	 * @return false if the frame is empty or no buffer is free
+	 */
+	bool Add(const ftIF2013FrameHandle& frame);
+	bool Add(const UINT8* jpeg, size_t size, const ftIF2013FrameInfo& info);
+
+	/*!
+	 * @brief Dump the ring and the next postseconds into an AVI file, doesn't wait
+	 * May be called from any thread, e.g. a callback of the TA communication thread.
+	 * @return false if a dump is still in progress or the ring is empty
+	 */
+	bool Trigger(const char* filename);
+
+	/*!
+	 * @brief Remove all frames from the ring (e.g. after a camera mode change)
+	 */
+	void Clear();
+
+	bool IsDumping();
+	/*!
+	 * @brief Wait until the dump in progress is written
+	 * @return false on a timeout
+	 */
+	bool WaitDump(int timeoutms);
+
+	// Frames and bytes in the ring
+	int GetFrames();
+	size_t GetBytes();
+	// Memory of all frame buffers, at most maxbytes
+	size_t GetMemory() const { return m_pool.GetAllocated(); }
+	// Frames not kept because no buffer was free
+	INT32 GetDropped() const { return m_dropped; }
+	// Frames and result of the last finished dump
+	INT32 GetDumpedFrames() const { return m_dumpedframes; }
+	bool GetDumpResult() const { return m_dumpresult; }
+
+protected:
+	struct Entry
+	{
+		ftIF2013FrameHandle m_frame;
+		std::chrono::steady_clock::time_point m_time;
+	};
+
+	// Remove the oldest frames above the limits, m_mutex must be locked
+	void Trim(std::chrono::steady_clock::time_point now, size_t add);
+	void DumpThread();
+
+	ftIF2013CameraRingConfig m_config;
+	ftIF2013FramePool m_pool;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::deque<Entry> m_ring;
+	size_t m_bytes;
+
+	// Dump in progress
+	bool m_dumping;
+	std::string m_filename;
+	std::deque<Entry> m_dump;      // frames not written yet
+	std::chrono::steady_clock::time_point m_postend;
+	bool m_stop;
+	std::thread m_thread;
+
+	std::atomic<INT32> m_dropped;
+	std::atomic<INT32> m_dumpedframes;
+	std::atomic<bool> m_dumpresult;
+
+private:
+	ftIF2013CameraRing(const ftIF2013CameraRing&);
+	ftIF2013CameraRing& operator=(const ftIF2013CameraRing&);
+};
+
+#endif // ftProInterface2013CameraRing_H
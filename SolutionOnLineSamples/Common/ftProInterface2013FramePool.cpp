@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013FramePool.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Pool of reference counted camera frame buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013FramePool
+//
+// The reference count of a frame is atomic, copying a handle takes no lock.
+// Only taking a frame from and returning it to the free stack is locked.
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+#include <assert.h>
+#include <iostream>
+
+#include "ftProInterface2013FramePool.h"
+
+using namespace std;
+
+//******************************************************************************
+//****
+//**** Class ftIF2013FrameHandle: Implementation 
+//****
+//******************************************************************************
+
+ftIF2013FrameHandle::ftIF2013FrameHandle(const ftIF2013FrameHandle& other) :
+    m_frame(other.m_frame)
+{
+    if (m_frame) m_frame->m_refs++;
+}
+
+ftIF2013FrameHandle& ftIF2013FrameHandle::operator=(const ftIF2013FrameHandle& other)
+{
+    if (other.m_frame) other.m_frame->m_refs++;
+    Reset();
+    m_frame = other.m_frame;
+    return *this;
+}
+
+ftIF2013FrameHandle& ftIF2013FrameHandle::operator=(ftIF2013FrameHandle&& other)
+{
+    if (this != &other)
+    {
+        Reset();
+        m_frame = other.m_frame;
+        other.m_frame = nullptr;
+    }
+    return *this;
+}
+
+void ftIF2013FrameHandle::Reset()
+{
+    if (m_frame)
+    {
+        if (--m_frame->m_refs == 0)
+        {
+            m_frame->m_pool->Release(m_frame);
+        }
+        m_frame = nullptr;
+    }
+}
+
+//******************************************************************************
+//****
+//**** Class ftIF2013FramePool: Implementation 
+//****
+//******************************************************************************
+
+ftIF2013FramePool::ftIF2013FramePool(int count, size_t capacity) :
+    m_allocated(0)
+{
+    m_frames.reserve(count);
+    m_free.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        ftIF2013Frame* frame = new ftIF2013Frame;
+        frame->m_capacity = capacity + Reserve;
+        frame->m_data = new unsigned char[frame->m_capacity];
+        m_allocated += frame->m_capacity;
+        frame->m_size = 0;
+        frame->m_info.Reset();
+        frame->m_refs = 0;
+        frame->m_pool = this;
+        frame->m_index = i;
+        m_frames.push_back(frame);
+        // Pop order 0, 1, ...
+        m_free.push_back(count - 1 - i);
+    }
+}
+
+ftIF2013FramePool::~ftIF2013FramePool()
+{
+    assert((int)m_free.size() == (int)m_frames.size());
+    if (m_free.size() != m_frames.size())
+    {
+        cerr << "~ftIF2013FramePool: Frame handles are still in use" << endl;
+    }
+    for (size_t i = 0; i < m_frames.size(); i++)
+    {
+        delete[] m_frames[i]->m_data;
+        delete m_frames[i];
+    }
+}
+
+ftIF2013FrameHandle ftIF2013FramePool::Acquire(size_t size)
+{
+    ftIF2013Frame* frame;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty()) return ftIF2013FrameHandle();
+        frame = m_frames[m_free.back()];
+        m_free.pop_back();
+    }
+
+    // The frame is owned exclusively now, so it can be enlarged without a lock
+    if (frame->m_capacity < size + Reserve)
+    {
+        delete[] frame->m_data;
+        m_allocated -= frame->m_capacity;
+        frame->m_capacity = 2 * size + Reserve;
+        frame->m_data = new unsigned char[frame->m_capacity];
+        m_allocated += frame->m_capacity;
+    }
+    frame->m_size = size;
+    frame->m_info.Reset();
+    frame->m_refs = 1;
+    return ftIF2013FrameHandle(frame);
+}
+
+int ftIF2013FramePool::GetFreeCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (int)m_free.size();
+}
+
+void ftIF2013FramePool::FreeUnused()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_free.size(); i++)
+    {
+        ftIF2013Frame* frame = m_frames[m_free[i]];
+        delete[] frame->m_data;
+        frame->m_data = nullptr;
+        m_allocated -= frame->m_capacity;
+        frame->m_capacity = 0;
+    }
+}
+
+void ftIF2013FramePool::Release(ftIF2013Frame* frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free.push_back(frame->m_index);
+}
@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013FramePool.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Pool of reference counted camera frame buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013FramePool
+//
+// The pool owns a fixed number of frame buffers. The camera receiver takes a
+// free frame, fills it and hands it out as ftIF2013FrameHandle. Handles can be
+// copied (e.g. to a decode thread), the frame returns to the pool when the
+// last handle is released. A frame buffer only grows when a frame doesn't fit,
+// so in steady state no memory is allocated.
+//
+// All handles must be released before the pool is deleted.
+//
+// see also: ftIF2013TransferAreaComHandler::GetCameraFrame
+//
+// Changes: 2026-10-19
+//          First version
+//          Frame number of the camera server
+//          Frame header and arrival time (ftIF2013FrameInfo)
+//          GetAllocated, FreeUnused for pools with a memory limit
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection 
+#if(!defined(ftProInterface2013FramePool_H))
+#define ftProInterface2013FramePool_H
+
+#include <stddef.h>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <vector>
+extern "C" {
+#include "common.h"
+}
+
+class ftIF2013FramePool;
+
+/*!
+ * @brief Header fields and arrival time of a camera frame
+ */
+struct ftIF2013FrameInfo
+{
+	INT32  m_sequence;        // number of the frame since StartCamera
+	INT32  m_framenumber;     // m_numframeready of the camera server
+	INT16  m_width;           // m_framewidth
+	INT16  m_height;          // m_frameheight
+	INT32  m_sizeraw;         // m_framesizeraw
+	INT32  m_sizecompressed;  // m_framesizecompressed
+	std::chrono::steady_clock::time_point m_headertime;  // header received
+	std::chrono::steady_clock::time_point m_received;    // last byte received
+
+	void Reset()
+	{
+		m_sequence = -1;
+		m_framenumber = -1;
+		m_width = m_height = 0;
+		m_sizeraw = m_sizecompressed = 0;
+		m_headertime = m_received = std::chrono::steady_clock::time_point();
+	}
+};
+
+/*!
+ * @brief One frame buffer of the pool
+ */
+struct ftIF2013Frame
+{
+	unsigned char* m_data;
+	size_t m_size;      // bytes used
+	size_t m_capacity;  // bytes allocated, at least m_size+ftIF2013FramePool::Reserve
+	ftIF2013FrameInfo m_info;
+	std::atomic<int> m_refs;
+	ftIF2013FramePool* m_pool;
+	int    m_index;
+};
+
+/*!
+ * @brief Reference counted lease of a frame, like a shared pointer
+ */
+class ftIF2013FrameHandle
+{
+public:
+	ftIF2013FrameHandle() : m_frame(nullptr) {}
+	explicit ftIF2013FrameHandle(ftIF2013Frame* frame) : m_frame(frame) {}
+	ftIF2013FrameHandle(const ftIF2013FrameHandle& other);
+	ftIF2013FrameHandle(ftIF2013FrameHandle&& other) : m_frame(other.m_frame) { other.m_frame = nullptr; }
+	ftIF2013FrameHandle& operator=(const ftIF2013FrameHandle& other);
+	ftIF2013FrameHandle& operator=(ftIF2013FrameHandle&& other);
+	~ftIF2013FrameHandle() { Reset(); }
+
+	/*!
+	 * @brief Release the frame, it returns to the pool with the last handle
+	 */
+	void Reset();
+
+	explicit operator bool() const { return m_frame != nullptr; }
+	unsigned char* GetData() const { return m_frame ? m_frame->m_data : nullptr; }
+	size_t GetSize() const { return m_frame ? m_frame->m_size : 0; }
+	/*!
+	 * @brief Bytes which may be written behind the data, e.g. to add the missing EOI marker
+	 */
+	size_t GetReserve() const { return m_frame ? m_frame->m_capacity - m_frame->m_size : 0; }
+	INT32 GetSequence() const { return m_frame ? m_frame->m_info.m_sequence : -1; }
+	INT32 GetFrameNumber() const { return m_frame ? m_frame->m_info.m_framenumber : -1; }
+	// Camera frame header and arrival time, nullptr for an empty handle
+	const ftIF2013FrameInfo* GetInfo() const { return m_frame ? &m_frame->m_info : nullptr; }
+	ftIF2013Frame* GetFrame() const { return m_frame; }
+
+protected:
+	ftIF2013Frame* m_frame;
+};
+
+/*!
+ * @brief Fixed number of frame buffers, see the module description
+ */
+class ftIF2013FramePool
+{
+public:
+	// Bytes reserved behind each frame
+	enum { Reserve = 16 };
+
+	// count    = number of frames
+	// capacity = initial size of each frame buffer
+	ftIF2013FramePool(int count, size_t capacity);
+	~ftIF2013FramePool();
+
+	/*!
+	 * @brief Take a free frame with room for size bytes, the buffer grows if needed
+	 * @return handle with m_size=size, empty if no frame is free
+	 */
+	ftIF2013FrameHandle Acquire(size_t size);
+
+	int GetCount() const { return (int)m_frames.size(); }
+	int GetFreeCount();
+
+	// Bytes allocated for the frame buffers
+	size_t GetAllocated() const { return m_allocated; }
+	// Free the buffers of the frames which are not in use, they are
+	// allocated again by Acquire
+	void FreeUnused();
+
+protected:
+	friend class ftIF2013FrameHandle;
+	void Release(ftIF2013Frame* frame);
+
+	std::mutex m_mutex;
+	std::vector<ftIF2013Frame*> m_frames;
+	std::vector<int> m_free;  // stack of free frame indices
+	std::atomic<size_t> m_allocated;
+};
+
+#endif // ftProInterface2013FramePool_H
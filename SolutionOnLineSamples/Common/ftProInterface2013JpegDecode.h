@@ -29,10 +29,82 @@
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+// Double inclusion protection 
+#if(!defined(ftProInterface2013JpegDecode_H))
+#define ftProInterface2013JpegDecode_H
+
+#include <stddef.h>
+#include "ftProInterface2013PixelFormat.h"
+
+// Region of interest in pixels of the (scaled) image
+struct ftProJpegRoi
+{
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+// Decoder object which is kept from frame to frame, so the JPEG decompression
+// object, its source manager and the strip buffers are set up only once.
+// An object must only be used by one thread at a time.
+//
+// jpegdata = pointer to JPEG byte stream
+// jpegsize = Size of JPEG byte stream
+// yuvdata  = Pointer to resulting YUV data, typically YUV422 interleaved
+// yuvsize  = Size of the resulting YUV data, at least ftProPixelFormatSize
+// format   = ftProPixelFormat, default YUV422 interleaved (YUYV)
+//            The frame width and height must be even.
+// scale    = 1, 2, 4 or 8: decode at 1/scale of the size with the reduced
+//            size IDCTs of libjpeg, e.g. 80x60 from a 640x480 stream.
+//            The image is (width+scale-1)/scale x (height+scale-1)/scale.
+// roi      = NULL for the whole image, else only this region is decoded and
+//            the output image is the region (rounded outwards to even
+//            coordinates and clipped to the image, see GetRoi).
+//            All MCUs are entropy decoded up to the last MCU row of the
+//            region, but only the MCUs which intersect it (16x8 pixels for
+//            the camera, 16/scale x 8/scale scaled) are dequantized and
+//            transformed. The rest of the scan is not decoded, so bytes_read
+//            is not the end of the JPEG data if the region ends above the
+//            bottom of the image.
+// orientation = ftProOrientation, the image is rotated or flipped while the
+//            strips are packed (no extra pass). For ROT90, ROT270, TRANSPOSE
+//            and TRANSVERSE width and height of the image are swapped. The
+//            region of interest is given in the frame before the orientation.
+class ftProJpegDecoder
+{
+public:
+	ftProJpegDecoder();
+	~ftProJpegDecoder();
+
+	bool Decode(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsize, size_t *bytes_read, int format = FTPRO_PIXEL_YUYV, int scale = 1, const ftProJpegRoi *roi = 0, int orientation = FTPRO_ORIENT_NONE);
+
+	// Size of the last decoded image (after scaling, region of interest and orientation)
+	int GetWidth() const;
+	int GetHeight() const;
+	// Region of the last decoded image in the scaled image
+	const ftProJpegRoi& GetRoi() const;
+
+protected:
+	// libjpeg state, see frProInterface2013JpegDecode.cpp
+	struct ftProJpegDecoderData *m_data;
+
+private:
+	ftProJpegDecoder(const ftProJpegDecoder&);
+	ftProJpegDecoder& operator=(const ftProJpegDecoder&);
+};
+
 // Decode a JPEG stream in memory, as received from the TXT
+// Uses one ftProJpegDecoder per thread.
 // 
 // jpegdata = pointer to JPEG byte stream
 // jpegsize = Size of JPEG byte stream
 // yuvdata  = Pointer to resulting YUV data, typically YUV422 interleaved
 // yuvsize  = Size of the resulting YUV data. For YUV422 this are 2 bytes per pixel
-bool ftProJpegDec(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsize, size_t *bytes_read);
+// format   = ftProPixelFormat, see ftProInterface2013PixelFormat
+// scale    = 1, 2, 4 or 8, see ftProJpegDecoder
+// roi      = region of interest, see ftProJpegDecoder
+// orientation = ftProOrientation, see ftProJpegDecoder
+bool ftProJpegDec(const UINT8 *jpegdata, int jpegsize, UINT8 *yuvdata, int yuvsize, size_t *bytes_read, int format = FTPRO_PIXEL_YUYV, int scale = 1, const ftProJpegRoi *roi = 0, int orientation = FTPRO_ORIENT_NONE);
+
+#endif // ftProInterface2013JpegDecode_H
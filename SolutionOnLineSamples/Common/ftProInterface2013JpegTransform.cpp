@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013JpegTransform.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Lossless rotate and flip of JPEG frames (DCT domain)
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013JpegTransform
+//
+// The steps of jpegtran.c: jtransform_request_workspace,
+// jpeg_read_coefficients, jpeg_copy_critical_parameters,
+// jtransform_adjust_parameters, jpeg_write_coefficients and
+// jtransform_execute_transform. The decompression and compression objects
+// are kept from frame to frame, the coefficient arrays are allocated for
+// each frame (pool JPOOL_IMAGE).
+//
+// jpeg_read_coefficients reads up to the EOI marker, so the data is cut
+// behind the scan (ftProJpegFindEnd) and jpeg_mem_src inserts the missing
+// EOI. Its warning is only counted, not printed.
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+
+extern "C" {
+#include "jpeglib.h"
+#include "jerror.h"
+#include "transupp.h"
+};
+
+// UINT8 is defined by jmorecfg.h
+#include "ftProInterface2013JpegTransform.h"
+
+// See ftProInterface2013MjpegRecorder.h, which can't be included here,
+// because common.h and jmorecfg.h define INT32 differently
+size_t ftProJpegFindEnd(const UINT8* data, size_t size, bool* complete);
+
+/* error handler info structure */
+
+struct ftProJpegTransformErr {
+  struct jpeg_error_mgr pub;  /* "public" fields */
+  jmp_buf setjmp_buffer;      /* for return to caller */
+};
+
+static void ftProJpegTransformErrExit(j_common_ptr cinfo)
+{
+  ftProJpegTransformErr* err = (ftProJpegTransformErr*)cinfo->err;
+  longjmp(err->setjmp_buffer, 1);
+}
+
+/* Warnings (missing EOI, extraneous data) are normal for camera frames */
+static void ftProJpegTransformMessage(j_common_ptr cinfo, int msg_level)
+{
+  if (msg_level < 0) cinfo->err->num_warnings++;
+}
+
+/* Destination manager which writes into a std::vector */
+
+struct ftProJpegVectorDest {
+  struct jpeg_destination_mgr pub;
+  std::vector<UINT8>* out;
+};
+
+static void ftProJpegVectorInit(j_compress_ptr cinfo)
+{
+  ftProJpegVectorDest* dest = (ftProJpegVectorDest*)cinfo->dest;
+  if (dest->out->size() < 65536) dest->out->resize(65536);
+  dest->out->resize(dest->out->capacity());
+  dest->pub.next_output_byte = dest->out->data();
+  dest->pub.free_in_buffer = dest->out->size();
+}
+
+static boolean ftProJpegVectorEmpty(j_compress_ptr cinfo)
+{
+  /* Called only if the buffer is full */
+  ftProJpegVectorDest* dest = (ftProJpegVectorDest*)cinfo->dest;
+  size_t used = dest->out->size();
+  dest->out->resize(used * 2);
+  dest->pub.next_output_byte = dest->out->data() + used;
+  dest->pub.free_in_buffer = dest->out->size() - used;
+  return TRUE;
+}
+
+static void ftProJpegVectorTerm(j_compress_ptr cinfo)
+{
+  ftProJpegVectorDest* dest = (ftProJpegVectorDest*)cinfo->dest;
+  dest->out->resize(dest->out->size() - dest->pub.free_in_buffer);
+}
+
+/* Persistent state, see ftProJpegTransformer */
+
+struct ftProJpegTransformData {
+  struct jpeg_decompress_struct src;
+  struct jpeg_compress_struct dst;
+  struct ftProJpegTransformErr jerr;
+  struct ftProJpegVectorDest dest;
+};
+
+ftProJpegTransformer::ftProJpegTransformer() :
+    m_data(new ftProJpegTransformData),
+    m_width(0),
+    m_height(0)
+{
+    /* One error manager for both objects */
+    m_data->src.err = jpeg_std_error(&m_data->jerr.pub);
+    m_data->jerr.pub.error_exit = ftProJpegTransformErrExit;
+    m_data->jerr.pub.emit_message = ftProJpegTransformMessage;
+    jpeg_create_decompress(&m_data->src);
+    m_data->dst.err = &m_data->jerr.pub;
+    jpeg_create_compress(&m_data->dst);
+
+    m_data->dest.pub.init_destination = ftProJpegVectorInit;
+    m_data->dest.pub.empty_output_buffer = ftProJpegVectorEmpty;
+    m_data->dest.pub.term_destination = ftProJpegVectorTerm;
+    m_data->dest.out = 0;
+    m_data->dst.dest = &m_data->dest.pub;
+}
+
+ftProJpegTransformer::~ftProJpegTransformer()
+{
+    jpeg_destroy_compress(&m_data->dst);
+    jpeg_destroy_decompress(&m_data->src);
+    delete m_data;
+}
+
+bool ftProJpegTransformer::Transform(const UINT8* jpegdata, size_t jpegsize, int orientation, std::vector<UINT8>* out)
+{
+    struct jpeg_decompress_struct& src = m_data->src;
+    struct jpeg_compress_struct& dst = m_data->dst;
+
+    if (orientation < FTPRO_ORIENT_NONE || orientation > FTPRO_ORIENT_ROT270)
+    {
+        return false;
+    }
+    bool complete = false;
+    size_t size = ftProJpegFindEnd(jpegdata, jpegsize, &complete);
+    if (size == 0)
+    {
+        return false;
+    }
+
+    if (setjmp(m_data->jerr.setjmp_buffer))
+    {
+        jpeg_abort_compress(&dst);
+        jpeg_abort_decompress(&src);
+        return false;
+    }
+
+    jpeg_mem_src(&src, jpegdata, (unsigned long)size);
+    (void)jpeg_read_header(&src, TRUE);
+
+    /* ftProOrientation has the order of JXFORM_CODE */
+    jpeg_transform_info info;
+    memset(&info, 0, sizeof(info));
+    info.transform = (JXFORM_CODE)orientation;
+    info.perfect = FALSE;
+    info.trim = TRUE;
+    if (!jtransform_request_workspace(&src, &info))
+    {
+        jpeg_abort_decompress(&src);
+        return false;
+    }
+
+    jvirt_barray_ptr* srccoefs = jpeg_read_coefficients(&src);
+    jpeg_copy_critical_parameters(&src, &dst);
+    jvirt_barray_ptr* dstcoefs = jtransform_adjust_parameters(&src, &dst, srccoefs, &info);
+
+    m_data->dest.out = out;
+    jpeg_write_coefficients(&dst, dstcoefs);
+    jtransform_execute_transform(&src, &dst, srccoefs, &info);
+    jpeg_finish_compress(&dst);
+
+    m_width = (int)dst.image_width;
+    m_height = (int)dst.image_height;
+
+    /* Releases the coefficient arrays of the frame, keeps the objects */
+    jpeg_abort_decompress(&src);
+    return true;
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013JpegTransform.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Lossless rotate and flip of JPEG frames (DCT domain)
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013JpegTransform
+//
+// ftProJpegTransformer turns a camera frame into a JPEG image with the given
+// ftProOrientation without decoding the pixels: the DCT coefficients are
+// read, rearranged by transupp.c of libjpeg (as jpegtran does) and entropy
+// coded again. The quality stays the same. Used for recording, where the
+// frames are stored as JPEG (ftIF2013MjpegWriter::Open); for decoded images
+// the decoder applies the orientation while packing (ftProJpegDecoder).
+//
+// The frames of the ft camera have no EOI marker, the data behind the scan
+// is not used. The result is a complete JPEG image (baseline, standard
+// Huffman tables, no APPn markers). For ROT90, ROT270, TRANSPOSE and
+// TRANSVERSE the width and height are swapped, 4:2:2 becomes 4:4:0 (h1v2).
+// Players decode this, ftProJpegDecoder only the 4:2:2 frames of the camera
+// (for decoded images use its orientation parameter).
+// An edge of partial MCUs (not for 160x120, 320x240 and 640x480) is cut off.
+//
+// Entropy decoding and coding again and the coefficient arrays of the whole
+// frame cost about 3 times the time of ftProJpegDec (640x480: about 4 ms).
+// An object must only be used by one thread at a time.
+//
+// see also: ftIF2013MjpegWriter, ftProJpegDecoder
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection
+#if(!defined(ftProInterface2013JpegTransform_H))
+#define ftProInterface2013JpegTransform_H
+
+#include <stddef.h>
+#include <vector>
+#include "ftProInterface2013PixelFormat.h"
+// UINT8 is defined by common.h or by jmorecfg.h (in the implementation), see
+// ftProInterface2013JpegDecode.h
+
+class ftProJpegTransformer
+{
+public:
+	ftProJpegTransformer();
+	~ftProJpegTransformer();
+
+	/*!
+	 * @brief Rotate or flip a JPEG frame
+	 * @param orientation ftProOrientation, FTPRO_ORIENT_NONE only copies the coefficients
+	 * @param out the complete JPEG image, the vector is reused for the next frames
+	 * @return false if the data can't be decoded
+	 */
+	bool Transform(const UINT8* jpegdata, size_t jpegsize, int orientation, std::vector<UINT8>* out);
+
+	// Size of the last result
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+
+protected:
+	// libjpeg state, see ftProInterface2013JpegTransform.cpp
+	struct ftProJpegTransformData* m_data;
+	int m_width;
+	int m_height;
+
+private:
+	ftProJpegTransformer(const ftProJpegTransformer&);
+	ftProJpegTransformer& operator=(const ftProJpegTransformer&);
+};
+
+#endif // ftProInterface2013JpegTransform_H
@@ -0,0 +1,523 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013MjpegRecorder.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  MJPEG recording: EOI repair without decoding, AVI file writer
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013MjpegRecorder
+//
+// Marker scan: inside entropy coded data a 0xFF byte is followed by 0x00
+// (stuffing) or by RST0..RST7. Any other byte after 0xFF starts a marker,
+// which ends the scan (0xFF 0xFF is a fill byte in front of a marker).
+// The SIMD variants compare 16 (SSE2) or 32 (AVX2) bytes at once with 0xFF
+// and only look at the positions of the 0xFF bytes.
+// After a scan only the markers which may follow a scan are accepted (EOI,
+// SOS, tables, restart interval, DNL, APPn, COM) and only if their length
+// fits, else the marker is garbage and the data ends in front of it.
+//
+// AVI layout (all numbers little endian):
+//   RIFF 'AVI '
+//     LIST 'hdrl'  avih, LIST 'strl' (strh, strf = BITMAPINFOHEADER)
+//     LIST 'movi'  '00dc' chunk per frame (padded to even size)
+//     idx1         ckid, flags, offset from 'movi', size per frame
+// The sizes and frame counts are written at Close.
+//
+// Changes: 2026-10-19
+//          First version
+//          Orientation: lossless transform in AddFrame, swapped size in the header
+//          AddFrame with wait
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <iostream>
+
+#include "ftProInterface2013MjpegRecorder.h"
+#include "ftProInterface2013PixelFormat.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define FTPRO_SIMD_X86
+#endif
+
+#if defined(FTPRO_SIMD_X86)
+#if defined(_MSC_VER)
+#define FTPRO_TARGET_SSE2
+#define FTPRO_TARGET_AVX2
+#else
+#define FTPRO_TARGET_SSE2 __attribute__((target("sse2")))
+#define FTPRO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+//******************************************************************************
+//****
+//**** EOI repair
+//****
+//******************************************************************************
+
+// 0xFF at pos starts a marker (the byte behind is known)
+static inline bool IsMarker(const UINT8* data, size_t pos)
+{
+    UINT8 next = data[pos + 1];
+    return next != 0x00 && next != 0xFF && (next < 0xD0 || next > 0xD7);
+}
+
+// Position of the first marker behind the entropy coded data from pos, or size
+static size_t ScanEntropyDataC(const UINT8* data, size_t pos, size_t size)
+{
+    for (; pos + 1 < size; pos++)
+    {
+        if (data[pos] == 0xFF && IsMarker(data, pos)) return pos;
+    }
+    return size;
+}
+
+#if defined(FTPRO_SIMD_X86)
+FTPRO_TARGET_SSE2 static size_t ScanEntropyDataSse2(const UINT8* data, size_t pos, size_t size)
+{
+    const __m128i ff = _mm_set1_epi8((char)0xFF);
+
+    // Blocks of 16 bytes, the byte behind a block must exist
+    for (; pos + 16 < size; pos += 16)
+    {
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + pos)), ff));
+        while (mask)
+        {
+            unsigned int bit = 0;
+            while (!(mask & (1u << bit))) bit++;
+            if (IsMarker(data, pos + bit)) return pos + bit;
+            mask &= mask - 1;
+        }
+    }
+    return ScanEntropyDataC(data, pos, size);
+}
+
+FTPRO_TARGET_AVX2 static size_t ScanEntropyDataAvx2(const UINT8* data, size_t pos, size_t size)
+{
+    const __m256i ff = _mm256_set1_epi8((char)0xFF);
+
+    for (; pos + 32 < size; pos += 32)
+    {
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(data + pos)), ff));
+        while (mask)
+        {
+            unsigned int bit = 0;
+            while (!(mask & (1u << bit))) bit++;
+            if (IsMarker(data, pos + bit)) return pos + bit;
+            mask &= mask - 1;
+        }
+    }
+    return ScanEntropyDataC(data, pos, size);
+}
+#endif
+
+static size_t ScanEntropyData(const UINT8* data, size_t pos, size_t size)
+{
+#if defined(FTPRO_SIMD_X86)
+    int features = ftProGetCpuFeatures();
+    if (features & FTPRO_CPU_AVX2) return ScanEntropyDataAvx2(data, pos, size);
+    if (features & FTPRO_CPU_SSE2) return ScanEntropyDataSse2(data, pos, size);
+#endif
+    return ScanEntropyDataC(data, pos, size);
+}
+
+// Markers with a length which may follow the entropy coded data of a scan
+static bool IsMarkerAfterScan(UINT8 marker)
+{
+    return marker == 0xDA || marker == 0xC4 || marker == 0xCC || marker == 0xDB ||
+        marker == 0xDC || marker == 0xDD || marker == 0xFE || (marker >= 0xE0 && marker <= 0xEF);
+}
+
+size_t ftProJpegFindEnd(const UINT8* data, size_t size, bool* complete)
+{
+    *complete = false;
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+    {
+        return 0;
+    }
+
+    size_t pos = 2;
+    bool scan = false;  // behind the data of a scan
+    for (;;)
+    {
+        // Fill bytes in front of a marker
+        while (pos + 1 < size && data[pos] == 0xFF && data[pos + 1] == 0xFF) pos++;
+        if (pos + 1 >= size || data[pos] != 0xFF)
+        {
+            return scan ? pos : 0;
+        }
+
+        UINT8 marker = data[pos + 1];
+        if (marker == 0xD9)
+        {
+            *complete = true;
+            return pos + 2;
+        }
+        if (scan && !IsMarkerAfterScan(marker))
+        {
+            return pos;
+        }
+        if (pos + 4 > size)
+        {
+            return scan ? pos : 0;
+        }
+        size_t length = ((size_t)data[pos + 2] << 8) | data[pos + 3];
+        if (length < 2 || pos + 2 + length > size)
+        {
+            return scan ? pos : 0;
+        }
+        pos += 2 + length;
+
+        if (marker == 0xDA)
+        {
+            pos = ScanEntropyData(data, pos, size);
+            scan = true;
+        }
+    }
+}
+
+size_t ftProJpegRepairEoi(UINT8* data, size_t size, size_t capacity)
+{
+    bool complete;
+    size_t end = ftProJpegFindEnd(data, size, &complete);
+    if (end == 0 || complete)
+    {
+        return end;
+    }
+    if (end + 2 > capacity)
+    {
+        return 0;
+    }
+    data[end] = 0xFF;
+    data[end + 1] = 0xD9;
+    return end + 2;
+}
+
+//******************************************************************************
+//****
+//**** AVI writer
+//****
+//******************************************************************************
+
+// AVI 1.0 readers are limited to 1 GByte
+static const size_t MaxFileSize = 1024 * 1024 * 1024;
+
+// Offsets in the header, see Open
+static const size_t RiffSizePos = 4;
+static const size_t AvihFramesPos = 48;
+static const size_t AvihBufferPos = 60;
+static const size_t StrhLengthPos = 140;
+static const size_t StrhBufferPos = 144;
+static const size_t MoviSizePos = 216;
+static const size_t MoviPos = 220;   // 'movi', index offsets are relative to it
+static const size_t HeaderSize = 224;
+
+static void Put32(unsigned char* pos, unsigned int value)
+{
+    pos[0] = (unsigned char)value;
+    pos[1] = (unsigned char)(value >> 8);
+    pos[2] = (unsigned char)(value >> 16);
+    pos[3] = (unsigned char)(value >> 24);
+}
+
+static void Put16(unsigned char* pos, unsigned int value)
+{
+    pos[0] = (unsigned char)value;
+    pos[1] = (unsigned char)(value >> 8);
+}
+
+static void PutFourcc(unsigned char* pos, const char* fourcc)
+{
+    memcpy(pos, fourcc, 4);
+}
+
+ftIF2013MjpegWriter::ftIF2013MjpegWriter(size_t buffersize) :
+    m_open(false),
+    m_active(0),
+    m_fill(0),
+    m_filesize(0),
+    m_maxchunk(0),
+    m_frames(0),
+    m_dropped(0),
+    m_orientation(FTPRO_ORIENT_NONE),
+    m_pending(false),
+    m_pendingsize(0),
+    m_stop(false),
+    m_error(false)
+{
+    m_buffers[0].resize(buffersize);
+    m_buffers[1].resize(buffersize);
+}
+
+ftIF2013MjpegWriter::~ftIF2013MjpegWriter()
+{
+    Close();
+}
+
+bool ftIF2013MjpegWriter::Open(const char* filename, int width, int height, int fps, int orientation)
+{
+    if (m_open)
+    {
+        cerr << "ftIF2013MjpegWriter::Open: File already open" << endl;
+        return false;
+    }
+    if (orientation < FTPRO_ORIENT_NONE || orientation > FTPRO_ORIENT_ROT270)
+    {
+        cerr << "ftIF2013MjpegWriter::Open: Invalid orientation " << orientation << endl;
+        return false;
+    }
+    if (fps < 1) fps = 1;
+    if (ftProOrientationTransposes(orientation))
+    {
+        int swap = width;
+        width = height;
+        height = swap;
+    }
+
+    m_file.open(filename, ofstream::binary | ofstream::trunc);
+    if (!m_file)
+    {
+        cerr << "ftIF2013MjpegWriter::Open: Cannot create " << filename << endl;
+        return false;
+    }
+
+    unsigned char header[HeaderSize];
+    memset(header, 0, sizeof(header));
+    PutFourcc(header + 0, "RIFF");
+    PutFourcc(header + 8, "AVI ");
+    PutFourcc(header + 12, "LIST");
+    Put32(header + 16, 192);
+    PutFourcc(header + 20, "hdrl");
+
+    // Main header
+    unsigned char* avih = header + 32;
+    PutFourcc(header + 24, "avih");
+    Put32(header + 28, 56);
+    Put32(avih + 0, 1000000 / fps);    // dwMicroSecPerFrame
+    Put32(avih + 12, 0x10);            // dwFlags = AVIF_HASINDEX
+    Put32(avih + 24, 1);               // dwStreams
+    Put32(avih + 32, width);
+    Put32(avih + 36, height);
+
+    // Stream header
+    PutFourcc(header + 88, "LIST");
+    Put32(header + 92, 116);
+    PutFourcc(header + 96, "strl");
+    unsigned char* strh = header + 108;
+    PutFourcc(header + 100, "strh");
+    Put32(header + 104, 56);
+    PutFourcc(strh + 0, "vids");
+    PutFourcc(strh + 4, "MJPG");
+    Put32(strh + 20, 1);               // dwScale
+    Put32(strh + 24, fps);             // dwRate
+    Put32(strh + 40, 0xFFFFFFFF);      // dwQuality = default
+    Put16(strh + 52, width);           // rcFrame
+    Put16(strh + 54, height);
+
+    // Stream format: BITMAPINFOHEADER
+    unsigned char* strf = header + 172;
+    PutFourcc(header + 164, "strf");
+    Put32(header + 168, 40);
+    Put32(strf + 0, 40);
+    Put32(strf + 4, width);
+    Put32(strf + 8, height);
+    Put16(strf + 12, 1);               // biPlanes
+    Put16(strf + 14, 24);              // biBitCount
+    PutFourcc(strf + 16, "MJPG");
+    Put32(strf + 20, width * height * 3);
+
+    PutFourcc(header + 212, "LIST");
+    PutFourcc(header + MoviPos, "movi");
+
+    m_file.write((const char*)header, sizeof(header));
+    if (!m_file)
+    {
+        cerr << "ftIF2013MjpegWriter::Open: Cannot write " << filename << endl;
+        m_file.close();
+        return false;
+    }
+
+    m_active = 0;
+    m_fill = 0;
+    m_index.clear();
+    m_filesize = HeaderSize;
+    m_maxchunk = 0;
+    m_frames = 0;
+    m_dropped = 0;
+    m_orientation = orientation;
+    m_pending = false;
+    m_stop = false;
+    m_error = false;
+    m_open = true;
+    m_writer = std::thread([this] { WriterThread(); });
+    return true;
+}
+
+bool ftIF2013MjpegWriter::AddFrame(const UINT8* jpeg, size_t size, bool wait)
+{
+    if (!m_open || m_error)
+    {
+        return false;
+    }
+
+    if (m_orientation != FTPRO_ORIENT_NONE)
+    {
+        if (!m_transformer.Transform(jpeg, size, m_orientation, &m_transformed))
+        {
+            return false;
+        }
+        jpeg = m_transformed.data();
+        size = m_transformed.size();
+    }
+
+    // Chunk header, data and pad byte, and the index entry at the end
+    size_t chunk = 8 + size + (size & 1);
+    if (m_filesize + chunk + 8 + 16 * (m_index.size() + 1) > MaxFileSize)
+    {
+        return false;
+    }
+
+    if (m_fill + chunk > m_buffers[m_active].size())
+    {
+        if (m_fill > 0 && wait)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return !m_pending; });
+        }
+        if (m_fill > 0 && !SwapBuffers())
+        {
+            // The writer thread still writes the other buffer
+            m_dropped++;
+            return true;
+        }
+        if (chunk > m_buffers[m_active].size())
+        {
+            m_buffers[m_active].resize(chunk);
+        }
+    }
+
+    unsigned char* pos = m_buffers[m_active].data() + m_fill;
+    PutFourcc(pos, "00dc");
+    Put32(pos + 4, (unsigned int)size);
+    memcpy(pos + 8, jpeg, size);
+    if (size & 1) pos[8 + size] = 0;
+
+    IndexEntry entry;
+    entry.m_offset = (unsigned int)(m_filesize - MoviPos);
+    entry.m_size = (unsigned int)size;
+    m_index.push_back(entry);
+
+    m_fill += chunk;
+    m_filesize += chunk;
+    if (size > m_maxchunk) m_maxchunk = (unsigned int)size;
+    m_frames++;
+    return true;
+}
+
+bool ftIF2013MjpegWriter::SwapBuffers()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending)
+    {
+        return false;
+    }
+    m_pending = true;
+    m_pendingsize = m_fill;
+    m_active ^= 1;
+    m_fill = 0;
+    m_cv.notify_all();
+    return true;
+}
+
+void ftIF2013MjpegWriter::WriterThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_cv.wait(lock, [this] { return m_pending || m_stop; });
+        if (m_pending)
+        {
+            // AddFrame only fills the active buffer, so the lock is not needed for writing
+            const char* data = (const char*)m_buffers[m_active ^ 1].data();
+            size_t size = m_pendingsize;
+            lock.unlock();
+            m_file.write(data, size);
+            if (!m_file) m_error = true;
+            lock.lock();
+            m_pending = false;
+            m_cv.notify_all();
+        }
+        else if (m_stop)
+        {
+            break;
+        }
+    }
+}
+
+void ftIF2013MjpegWriter::Patch32(size_t pos, unsigned int value)
+{
+    unsigned char bytes[4];
+    Put32(bytes, value);
+    m_file.seekp(pos);
+    m_file.write((const char*)bytes, 4);
+}
+
+bool ftIF2013MjpegWriter::Close()
+{
+    if (!m_open)
+    {
+        return false;
+    }
+
+    // Write the rest and stop the writer thread
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return !m_pending; });
+    }
+    if (m_fill > 0) SwapBuffers();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_cv.notify_all();
+    }
+    m_writer.join();
+
+    // Index
+    std::vector<unsigned char> index(8 + 16 * m_index.size());
+    PutFourcc(index.data(), "idx1");
+    Put32(index.data() + 4, (unsigned int)(16 * m_index.size()));
+    for (size_t i = 0; i < m_index.size(); i++)
+    {
+        unsigned char* entry = index.data() + 8 + 16 * i;
+        PutFourcc(entry, "00dc");
+        Put32(entry + 4, 0x10);        // AVIIF_KEYFRAME
+        Put32(entry + 8, m_index[i].m_offset);
+        Put32(entry + 12, m_index[i].m_size);
+    }
+    m_file.write((const char*)index.data(), index.size());
+
+    // Sizes and counts in the header
+    Patch32(RiffSizePos, (unsigned int)(m_filesize + index.size() - 8));
+    Patch32(AvihFramesPos, m_frames);
+    Patch32(AvihBufferPos, m_maxchunk);
+    Patch32(StrhLengthPos, m_frames);
+    Patch32(StrhBufferPos, m_maxchunk);
+    Patch32(MoviSizePos, (unsigned int)(m_filesize - MoviPos));
+
+    bool result = m_file.good() && !m_error;
+    m_file.close();
+    m_open = false;
+    if (!result)
+    {
+        cerr << "ftIF2013MjpegWriter::Close: Error writing the file" << endl;
+    }
+    return result;
+}
@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013MjpegRecorder.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  MJPEG recording: EOI repair without decoding, AVI file writer
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013MjpegRecorder
+//
+// The JPEG frames of the ft camera have no EOI marker at the end, but some
+// garbage bytes. ftProJpegFindEnd walks through the marker segments and scans
+// the entropy coded data of each scan for the next marker (SIMD), so a frame
+// can be repaired without decoding it:
+//
+//   size = ftProJpegRepairEoi(frame.GetData(), frame.GetSize(),
+//                             frame.GetSize() + frame.GetReserve());
+//
+// Garbage bytes without 0xFF look like entropy coded data and stay in front
+// of the EOI. Decoders ignore them (libjpeg warns about extraneous bytes).
+//
+// ftIF2013MjpegWriter streams the frames into one AVI file (RIFF 'AVI ',
+// one MJPG video stream, idx1 index). AddFrame only copies the frame into a
+// buffer; a background thread writes full buffers to the file. If the disk
+// is too slow and both buffers are in use, the frame is dropped (GetDropped),
+// AddFrame never waits for the disk (unless wait is given, e.g. for a dump of
+// frames which are already in memory).
+// The file size is limited to 1 GByte (AVI 1.0), AddFrame returns false if
+// the frame doesn't fit anymore: Close and open the next file.
+// With an orientation at Open (mounted camera) AddFrame rotates or flips each
+// frame losslessly (ftProJpegTransformer) before it is copied. This is done
+// in the calling thread and costs about 3 times the time of a decode.
+//
+// see also: ftIF2013TransferAreaComHandler::GetCameraFrame, ftProJpegTransformer
+//
+// Changes: 2026-10-19
+//          First version
+//          Orientation of the recorded frames
+//          AddFrame can wait for the writer thread
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection
+#if(!defined(ftProInterface2013MjpegRecorder_H))
+#define ftProInterface2013MjpegRecorder_H
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+extern "C" {
+#include "common.h"
+}
+#include "ftProInterface2013JpegTransform.h"
+
+/*!
+ * @brief Find the end of the JPEG data without decoding it
+ * @param complete set to true if the data ends with an EOI marker
+ * @return number of valid bytes (including the EOI if complete), where the
+ *         EOI must be written otherwise. 0 if the data is no JPEG image or
+ *         has no scan.
+ */
+size_t ftProJpegFindEnd(const UINT8* data, size_t size, bool* complete);
+
+/*!
+ * @brief Write the missing EOI marker behind the end of the JPEG data
+ * @param capacity bytes available at data (at least the end + 2 bytes)
+ * @return new size of the image, 0 if it is no JPEG image or too small
+ */
+size_t ftProJpegRepairEoi(UINT8* data, size_t size, size_t capacity);
+
+/*!
+ * @brief Writes JPEG frames into an MJPEG AVI file, see the module description
+ */
+class ftIF2013MjpegWriter
+{
+public:
+	// buffersize = size of each of the two write buffers
+	explicit ftIF2013MjpegWriter(size_t buffersize = 2 * 1024 * 1024);
+	~ftIF2013MjpegWriter();
+
+	/*!
+	 * @brief Create the file and start the writer thread
+	 * @param fps frame rate stored in the file (as given to StartCamera)
+	 * @param orientation ftProOrientation of the recorded frames, width and
+	 *        height are those of the camera
+	 */
+	bool Open(const char* filename, int width, int height, int fps, int orientation = FTPRO_ORIENT_NONE);
+	/*!
+	 * @brief Add a complete JPEG frame (with EOI), the data is copied
+	 * @param wait wait for the writer thread instead of dropping the frame
+	 * @return false if the file is not open, full (see module description),
+	 *         on a write error or if the frame can't be rotated
+	 */
+	bool AddFrame(const UINT8* jpeg, size_t size, bool wait = false);
+	/*!
+	 * @brief Write the remaining frames and the index, close the file
+	 */
+	bool Close();
+
+	bool IsOpen() const { return m_open; }
+	INT32 GetFrames() const { return m_frames; }
+	INT32 GetDropped() const { return m_dropped; }
+
+protected:
+	struct IndexEntry
+	{
+		unsigned int m_offset;  // from the 'movi' identifier
+		unsigned int m_size;
+	};
+
+	// Hand the current buffer to the writer thread, false if it is still busy
+	bool SwapBuffers();
+	void WriterThread();
+	void Patch32(size_t pos, unsigned int value);
+
+	std::ofstream m_file;
+	bool m_open;
+	std::vector<unsigned char> m_buffers[2];
+	int m_active;              // buffer filled by AddFrame
+	size_t m_fill;             // bytes in the active buffer
+	std::vector<IndexEntry> m_index;
+	size_t m_filesize;         // bytes written and queued
+	unsigned int m_maxchunk;
+	INT32 m_frames;
+	INT32 m_dropped;
+	int m_orientation;
+	ftProJpegTransformer m_transformer;
+	std::vector<UINT8> m_transformed;
+
+	// Writer thread
+	std::thread m_writer;
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	bool m_pending;            // the other buffer waits or is being written
+	size_t m_pendingsize;
+	bool m_stop;
+	std::atomic<bool> m_error;
+};
+
+#endif // ftProInterface2013MjpegRecorder_H
@@ -0,0 +1,363 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013MjpegStream.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Local HTTP MJPEG streaming server for the camera frames
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013MjpegStream
+//
+// Response (HTTP/1.0, the connection ends with the stream):
+//   HTTP/1.0 200 OK
+//   Content-Type: multipart/x-mixed-replace; boundary=ftframe
+//   then per frame: "--ftframe", Content-Type and Content-Length, the JPEG data
+//
+// The part header is the only data which is formatted per frame. WSASend takes
+// it, the frame buffer of the pool and the part end as three buffers, so the
+// frame is not copied into a send buffer.
+//
+// Sockets: a client thread never closes its socket. Stop shuts the sockets
+// down (a blocking WSASend returns), then joins the threads and closes them.
+// Clients which disconnected are removed by the accept thread.
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+
+#include "ftProInterface2013MjpegStream.h"
+
+#pragma comment(lib, "Ws2_32.lib")
+
+using namespace std;
+
+static const char StreamHeader[] =
+    "HTTP/1.0 200 OK\r\n"
+    "Content-Type: multipart/x-mixed-replace; boundary=ftframe\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+static const char BusyResponse[] =
+    "HTTP/1.0 503 Service Unavailable\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+static const char BadResponse[] =
+    "HTTP/1.0 400 Bad Request\r\n"
+    "Connection: close\r\n"
+    "\r\n";
+static const char PartEnd[] = "\r\n";
+
+// A client which doesn't read for this time is disconnected
+static const DWORD SendTimeout = 5000;  // [ms]
+static const DWORD ReceiveTimeout = 2000;
+
+ftIF2013MjpegStreamServer::ftIF2013MjpegStreamServer(int maxclients) :
+    m_maxclients(maxclients < 1 ? 1 : maxclients),
+    m_listen(INVALID_SOCKET),
+    m_running(false),
+    m_latestsize(0),
+    m_latestnumber(0),
+    m_published(0),
+    m_sent(0),
+    m_skipped(0),
+    m_connections(0),
+    m_rejected(0),
+    m_bytes(0)
+{
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 0), &wsaData) != 0)
+    {
+        cerr << "ftIF2013MjpegStreamServer: WSAStartup error" << endl;
+    }
+}
+
+ftIF2013MjpegStreamServer::~ftIF2013MjpegStreamServer()
+{
+    Stop();
+    WSACleanup();
+}
+
+bool ftIF2013MjpegStreamServer::Start(unsigned short port)
+{
+    if (m_running)
+    {
+        cerr << "ftIF2013MjpegStreamServer::Start: Server already running" << endl;
+        return false;
+    }
+
+    m_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (m_listen == INVALID_SOCKET)
+    {
+        cerr << "ftIF2013MjpegStreamServer::Start: Error opening socket " << WSAGetLastError() << endl;
+        return false;
+    }
+    BOOL reuse = TRUE;
+    setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    // Local clients only
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(m_listen, (const struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+        listen(m_listen, SOMAXCONN) == SOCKET_ERROR)
+    {
+        cerr << "ftIF2013MjpegStreamServer::Start: Cannot listen on port " << port << " " << WSAGetLastError() << endl;
+        closesocket(m_listen);
+        m_listen = INVALID_SOCKET;
+        return false;
+    }
+
+    m_published = 0;
+    m_sent = 0;
+    m_skipped = 0;
+    m_connections = 0;
+    m_rejected = 0;
+    m_bytes = 0;
+    m_latestnumber = 0;
+    m_running = true;
+    m_acceptthread = std::thread([this] { AcceptThread(); });
+    return true;
+}
+
+void ftIF2013MjpegStreamServer::Stop()
+{
+    m_running = false;
+
+    // accept returns when the socket is closed (Winsock) or shut down (BSD sockets)
+    if (m_listen != INVALID_SOCKET)
+    {
+        shutdown(m_listen, SD_BOTH);
+        closesocket(m_listen);
+        m_listen = INVALID_SOCKET;
+    }
+    if (m_acceptthread.joinable()) m_acceptthread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_clients.size(); i++)
+        {
+            shutdown(m_clients[i]->m_socket, SD_BOTH);
+        }
+        m_cv.notify_all();
+    }
+    // The accept thread has ended, nobody else changes the list
+    for (size_t i = 0; i < m_clients.size(); i++)
+    {
+        m_clients[i]->m_thread.join();
+        closesocket(m_clients[i]->m_socket);
+        delete m_clients[i];
+    }
+    m_clients.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_latest.Reset();
+}
+
+void ftIF2013MjpegStreamServer::Publish(const ftIF2013FrameHandle& frame, size_t size)
+{
+    if (!frame || !m_running)
+    {
+        return;
+    }
+    m_published++;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_latest = frame;
+    m_latestsize = size ? size : frame.GetSize();
+    m_latestnumber++;
+    m_cv.notify_all();
+}
+
+void ftIF2013MjpegStreamServer::GetStats(ftIF2013StreamStats* stats)
+{
+    INT32 clients = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_clients.size(); i++)
+        {
+            if (!m_clients[i]->m_done) clients++;
+        }
+    }
+    stats->m_published = m_published;
+    stats->m_sent = m_sent;
+    stats->m_skipped = m_skipped;
+    stats->m_clients = clients;
+    stats->m_connections = m_connections;
+    stats->m_rejected = m_rejected;
+    stats->m_bytes = m_bytes;
+}
+
+void ftIF2013MjpegStreamServer::ReapClients()
+{
+    for (size_t i = 0; i < m_clients.size(); )
+    {
+        if (m_clients[i]->m_done)
+        {
+            m_clients[i]->m_thread.join();
+            closesocket(m_clients[i]->m_socket);
+            delete m_clients[i];
+            m_clients.erase(m_clients.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void ftIF2013MjpegStreamServer::AcceptThread()
+{
+    while (m_running)
+    {
+        SOCKET socket = accept(m_listen, nullptr, nullptr);
+        if (socket == INVALID_SOCKET)
+        {
+            if (m_running) cerr << "ftIF2013MjpegStreamServer: accept error " << WSAGetLastError() << endl;
+            break;
+        }
+
+        bool busy;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ReapClients();
+            busy = (int)m_clients.size() >= m_maxclients;
+            if (!busy)
+            {
+                Client* client = new Client;
+                client->m_socket = socket;
+                client->m_done = false;
+                m_clients.push_back(client);
+                m_connections++;
+                client->m_thread = std::thread([this, client] { ClientThread(client); });
+            }
+        }
+        if (busy)
+        {
+            m_rejected++;
+            send(socket, BusyResponse, (int)strlen(BusyResponse), 0);
+            closesocket(socket);
+        }
+    }
+}
+
+bool ftIF2013MjpegStreamServer::ReadRequest(SOCKET socket)
+{
+    // Only the request line matters, the header is read up to its end
+    char request[2048];
+    int length = 0;
+    while (length < (int)sizeof(request) - 1)
+    {
+        int received = recv(socket, request + length, (int)sizeof(request) - 1 - length, 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        length += received;
+        request[length] = 0;
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+        {
+            break;
+        }
+    }
+    return strncmp(request, "GET ", 4) == 0;
+}
+
+bool ftIF2013MjpegStreamServer::SendBuffers(SOCKET socket, WSABUF* buffers, DWORD count)
+{
+    while (count > 0)
+    {
+        DWORD sent = 0;
+        if (WSASend(socket, buffers, count, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+        {
+            return false;
+        }
+        m_bytes += sent;
+        while (count > 0 && sent >= buffers->len)
+        {
+            sent -= buffers->len;
+            buffers++;
+            count--;
+        }
+        if (count > 0)
+        {
+            buffers->buf += sent;
+            buffers->len -= sent;
+        }
+    }
+    return true;
+}
+
+void ftIF2013MjpegStreamServer::ClientThread(Client* client)
+{
+    SOCKET socket = client->m_socket;
+    DWORD sendtimeout = SendTimeout, receivetimeout = ReceiveTimeout;
+    setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&sendtimeout, sizeof(sendtimeout));
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&receivetimeout, sizeof(receivetimeout));
+    BOOL nodelay = TRUE;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+
+    bool ok = ReadRequest(socket);
+    if (!ok)
+    {
+        m_rejected++;
+        send(socket, BadResponse, (int)strlen(BadResponse), 0);
+    }
+    else
+    {
+        WSABUF header;
+        header.buf = (char*)StreamHeader;
+        header.len = (ULONG)strlen(StreamHeader);
+        ok = SendBuffers(socket, &header, 1);
+    }
+
+    INT32 lastsent = 0;
+    bool first = true;
+    while (ok)
+    {
+        // The newest frame, the ones published in the meantime are skipped
+        ftIF2013FrameHandle frame;
+        size_t size;
+        INT32 number;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&] { return !m_running || (m_latest && (first || m_latestnumber != lastsent)); });
+            if (!m_running)
+            {
+                break;
+            }
+            frame = m_latest;
+            size = m_latestsize;
+            number = m_latestnumber;
+        }
+        if (!first && number - lastsent > 1)
+        {
+            m_skipped += number - lastsent - 1;
+        }
+        first = false;
+        lastsent = number;
+
+        char part[128];
+        int partlength = snprintf(part, sizeof(part), "--ftframe\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n", (unsigned int)size);
+        WSABUF buffers[3];
+        buffers[0].buf = part;
+        buffers[0].len = (ULONG)partlength;
+        buffers[1].buf = (char*)frame.GetData();
+        buffers[1].len = (ULONG)size;
+        buffers[2].buf = (char*)PartEnd;
+        buffers[2].len = 2;
+        ok = SendBuffers(socket, buffers, 3);
+        if (ok) m_sent++;
+    }
+
+    // Stop or the accept thread closes the socket
+    shutdown(socket, SD_BOTH);
+    client->m_done = true;
+}
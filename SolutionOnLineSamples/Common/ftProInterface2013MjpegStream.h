@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013MjpegStream.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Local HTTP MJPEG streaming server for the camera frames
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013MjpegStream
+//
+// ftIF2013MjpegStreamServer sends the camera frames as HTTP multipart MJPEG
+// stream (multipart/x-mixed-replace, as IP cameras do) to browsers and
+// dashboards on the same PC, e.g. http://localhost:8080/ . The frames are sent
+// as received from the camera, no client decodes them on the PC side or opens
+// a camera session on the TXT. It listens on 127.0.0.1 only.
+//
+//   ftIF2013MjpegStreamServer server;
+//   ComHandler->SetCameraFramePool( 4 + server.GetMaxFrames() );
+//   server.Start( 8080 );
+//   ...
+//   ComHandler->GetCameraFrame( &frame );
+//   size = ftProJpegRepairEoi( frame.GetData(), frame.GetSize(), frame.GetSize() + frame.GetReserve() );
+//   server.Publish( frame, size );
+//
+// Publish doesn't copy the frame and doesn't wait: the server keeps a copy of
+// the handle (reference counted) of the newest frame. Each client has its own
+// thread, which sends the newest frame with one scatter-gather write (part
+// header, the frame buffer, part end). Frames which are published while a
+// client still sends the previous one are skipped for this client, so a slow
+// client always gets the newest frame and never delays the others or the
+// receiver. The server holds at most GetMaxFrames frames of the pool of the
+// publisher, the frames must not be changed after Publish.
+// With ftIF2013CameraBroker: server.Publish( frame.GetJpeg() ) in a
+// subscriber thread (the broker repairs the EOI).
+//
+// see also: ftIF2013TransferAreaComHandler::GetCameraFrame, ftIF2013CameraBroker
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection
+#if(!defined(ftProInterface2013MjpegStream_H))
+#define ftProInterface2013MjpegStream_H
+
+#include <winsock2.h>
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ftProInterface2013FramePool.h"
+
+/*!
+ * @brief Counters since Start
+ */
+struct ftIF2013StreamStats
+{
+	INT32  m_published;         // frames given to Publish
+	INT32  m_sent;              // frames sent, all clients
+	INT32  m_skipped;           // frames not sent to a client because it was busy
+	INT32  m_clients;           // connected now
+	INT32  m_connections;       // accepted
+	INT32  m_rejected;          // more than maxclients or no GET request
+	long long m_bytes;          // sent
+};
+
+/*!
+ * @brief HTTP MJPEG server on localhost, see the module description
+ */
+class ftIF2013MjpegStreamServer
+{
+public:
+	explicit ftIF2013MjpegStreamServer(int maxclients = 4);
+	~ftIF2013MjpegStreamServer();
+
+	/*!
+	 * @brief Listen on 127.0.0.1:port and start the accept thread
+	 */
+	bool Start(unsigned short port = 8080);
+	/*!
+	 * @brief Close all connections and stop the threads
+	 */
+	void Stop();
+	bool IsRunning() const { return m_running; }
+
+	/*!
+	 * @brief Hand the newest frame to the clients, doesn't wait
+	 * @param size bytes to send, 0 = GetSize (e.g. the result of ftProJpegRepairEoi)
+	 */
+	void Publish(const ftIF2013FrameHandle& frame, size_t size = 0);
+
+	// Frames of the pool the server may hold: the newest and one per client
+	int GetMaxFrames() const { return m_maxclients + 1; }
+	void GetStats(ftIF2013StreamStats* stats);
+
+protected:
+	struct Client
+	{
+		SOCKET m_socket;
+		std::thread m_thread;
+		std::atomic<bool> m_done;  // the thread ended, can be joined
+	};
+
+	void AcceptThread();
+	void ClientThread(Client* client);
+	// Read the request header, false if it is no GET request
+	bool ReadRequest(SOCKET socket);
+	// Send all bytes of the buffers, WSASend may send less
+	bool SendBuffers(SOCKET socket, WSABUF* buffers, DWORD count);
+	// Join and delete the clients which ended, m_mutex must be locked
+	void ReapClients();
+
+	int m_maxclients;
+	SOCKET m_listen;
+	std::atomic<bool> m_running;
+	std::thread m_acceptthread;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;       // a new frame or Stop
+	ftIF2013FrameHandle m_latest;
+	size_t m_latestsize;
+	INT32 m_latestnumber;               // counts the published frames
+	std::vector<Client*> m_clients;
+
+	// Statistics
+	std::atomic<INT32> m_published;
+	std::atomic<INT32> m_sent;
+	std::atomic<INT32> m_skipped;
+	std::atomic<INT32> m_connections;
+	std::atomic<INT32> m_rejected;
+	std::atomic<long long> m_bytes;
+
+private:
+	ftIF2013MjpegStreamServer(const ftIF2013MjpegStreamServer&);
+	ftIF2013MjpegStreamServer& operator=(const ftIF2013MjpegStreamServer&);
+};
+
+#endif // ftProInterface2013MjpegStream_H
@@ -0,0 +1,223 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013MotionDetect.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Motion and change detection in the DCT domain (no pixel decode)
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013MotionDetect
+//
+// The coefficients are taken from the reduced size IDCTs of libjpeg in raw
+// data mode: at scale 1/8 each block gives 1 sample, DC/8 + 128 (the
+// dequantized mean), at 1/4 it gives 2x2 samples, which only depend on DC,
+// AC01, AC10 and AC11. So the values don't depend on the quality setting of
+// the camera. For these sizes the entropy decoder stores only the first
+// coefficients of a block (coef_limit in jdhuff.c) and nothing of the
+// components which are not needed (chroma).
+//
+// jpeg_read_coefficients is not used: it allocates the coefficient arrays of
+// all components for each frame (1.2 MByte at 640x480), which took longer than
+// a full decode with ftProJpegDec. The single pass decoder needs one iMCU row.
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <setjmp.h>
+#include <math.h>
+
+extern "C" {
+#include "jpeglib.h"
+#include "jerror.h"
+};
+
+// UINT8 is defined by jmorecfg.h
+#include "ftProInterface2013MotionDetect.h"
+
+/* error handler info structure */
+
+struct ftProMotionErrData {
+  struct jpeg_error_mgr pub;  /* "public" fields */
+  jmp_buf setjmp_buffer;      /* for return to caller */
+};
+
+static void ftProMotionErrExit(j_common_ptr cinfo)
+{
+  ftProMotionErrData* err = (ftProMotionErrData*)cinfo->err;
+  longjmp(err->setjmp_buffer, 1);
+}
+
+/* Persistent decoder state, see ftProJpegMotionDetector */
+
+struct ftProMotionData {
+  struct jpeg_decompress_struct cinfo;
+  struct ftProMotionErrData jerr;
+  /* Luma samples of one iMCU row, kept for the next frames */
+  std::vector<JSAMPLE> samples;
+  std::vector<JSAMPROW> rows;
+};
+
+ftProJpegMotionDetector::ftProJpegMotionDetector(const ftProMotionConfig& config) :
+    m_data(new ftProMotionData),
+    m_config(config),
+    m_blockswide(0),
+    m_blockshigh(0),
+    m_learned(false),
+    m_activity(0),
+    m_level(0),
+    m_frames(0)
+{
+    m_data->cinfo.err = jpeg_std_error(&m_data->jerr.pub);
+    m_data->jerr.pub.error_exit = ftProMotionErrExit;
+    jpeg_create_decompress(&m_data->cinfo);
+}
+
+ftProJpegMotionDetector::~ftProJpegMotionDetector()
+{
+    jpeg_destroy_decompress(&m_data->cinfo);
+    delete m_data;
+}
+
+void ftProJpegMotionDetector::Reset()
+{
+    m_learned = false;
+}
+
+bool ftProJpegMotionDetector::Analyze(const UINT8* jpegdata, size_t jpegsize)
+{
+    struct jpeg_decompress_struct& cinfo = m_data->cinfo;
+
+    if (setjmp(m_data->jerr.setjmp_buffer))
+    {
+        jpeg_abort_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_mem_src(&cinfo, jpegdata, (unsigned long)jpegsize);
+    (void)jpeg_read_header(&cinfo, TRUE);
+
+    // Raw luma blocks with 1x1 (DC) or 2x2 (DC and the lowest AC) samples
+    int size = m_config.lowfrequency ? 2 : 1;
+    cinfo.raw_data_out = TRUE;
+    cinfo.out_color_space = cinfo.jpeg_color_space;
+    cinfo.do_fancy_upsampling = FALSE;
+    cinfo.do_block_smoothing = FALSE;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = DCTSIZE / size;
+    for (int comp = 1; comp < cinfo.num_components; comp++)
+    {
+        cinfo.comp_info[comp].component_needed = FALSE;
+    }
+    (void)jpeg_start_decompress(&cinfo);
+
+    jpeg_component_info* luma = &cinfo.comp_info[0];
+    if (luma->DCT_h_scaled_size != size || luma->DCT_v_scaled_size != size)
+    {
+        // Block size other than 8x8 (JPEG 9 extension)
+        jpeg_abort_decompress(&cinfo);
+        return false;
+    }
+
+    // One iMCU row of luma; the other components get the same rows, which
+    // are not written because they are not needed
+    int blockrows = luma->v_samp_factor;
+    size_t stride = (luma->width_in_blocks + luma->h_samp_factor - 1) / luma->h_samp_factor * luma->h_samp_factor * size;
+    if (m_data->samples.size() < stride * blockrows * size)
+    {
+        m_data->samples.resize(stride * blockrows * size);
+    }
+    m_data->rows.resize((size_t)blockrows * size);
+    for (size_t i = 0; i < m_data->rows.size(); i++)
+    {
+        m_data->rows[i] = m_data->samples.data() + i * stride;
+    }
+    JSAMPARRAY planes[MAX_COMPONENTS];
+    for (int comp = 0; comp < MAX_COMPONENTS; comp++)
+    {
+        planes[comp] = m_data->rows.data();
+    }
+
+    // A new frame size starts a new background
+    int wide = (int)luma->width_in_blocks;
+    int high = (int)luma->height_in_blocks;
+    int values = size * size;
+    if (wide != m_blockswide || high != m_blockshigh || m_background.size() != (size_t)wide * high * values)
+    {
+        m_blockswide = wide;
+        m_blockshigh = high;
+        m_background.assign((size_t)wide * high * values, 0.0f);
+        m_mask.assign((size_t)wide * high, 0);
+        m_learned = false;
+    }
+
+    float threshold = (float)m_config.threshold * values;
+    float learnrate = (float)m_config.learnrate;
+    float changedrate = (float)m_config.changedrate;
+    int changed = 0;
+    double level = 0;
+    JDIMENSION lines = cinfo.max_v_samp_factor * cinfo.min_DCT_v_scaled_size;
+
+    for (int blockrow = 0; blockrow < high; )
+    {
+        if (jpeg_read_raw_data(&cinfo, planes, lines) == 0)
+        {
+            jpeg_abort_decompress(&cinfo);
+            return false;
+        }
+
+        for (int row = 0; row < blockrows && blockrow < high; row++, blockrow++)
+        {
+            float* background = m_background.data() + (size_t)blockrow * wide * values;
+            UINT8* mask = m_mask.data() + (size_t)blockrow * wide;
+            JSAMPROW* samples = m_data->rows.data() + row * size;
+
+            for (int col = 0; col < wide; col++, background += values)
+            {
+                float value[4];
+                for (int y = 0; y < size; y++)
+                {
+                    for (int x = 0; x < size; x++)
+                    {
+                        value[y * size + x] = samples[y][col * size + x];
+                    }
+                }
+
+                if (!m_learned)
+                {
+                    for (int i = 0; i < values; i++) background[i] = value[i];
+                    mask[col] = 0;
+                    continue;
+                }
+
+                float difference = 0;
+                for (int i = 0; i < values; i++)
+                {
+                    difference += fabsf(value[i] - background[i]);
+                }
+                level += difference;
+                mask[col] = difference > threshold;
+                changed += mask[col];
+
+                float rate = mask[col] ? changedrate : learnrate;
+                for (int i = 0; i < values; i++)
+                {
+                    background[i] += rate * (value[i] - background[i]);
+                }
+            }
+        }
+    }
+
+    int blocks = wide * high;
+    m_activity = m_learned && blocks ? (double)changed / blocks : 0;
+    m_level = m_learned && blocks ? level / values / blocks : 0;
+    m_learned = true;
+    m_frames++;
+
+    // The rest of the data (garbage instead of EOI for the camera) is not read
+    jpeg_abort_decompress(&cinfo);
+    return true;
+}
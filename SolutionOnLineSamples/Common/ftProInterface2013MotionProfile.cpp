@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013MotionProfile.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Trapezoidal and S-curve motion profiles for encoder motors
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013MotionProfile
+//
+// The profile is generated on-line, one step per transfer: the axis brakes as
+// soon as the remaining distance is not more than the braking distance, else
+// it accelerates up to vmax. For the S-curve the acceleration itself is ramped
+// with jmax, and the braking distance includes the time to ramp the
+// acceleration. This needs no pre-calculation, so a motion can be replaced at
+// any time, and costs a few float operations per axis and cycle.
+//
+// Changes: 2026-10-19
+//          First version
+//          A finished axis is free at once, dutymin/dutymax are checked by Start
+///////////////////////////////////////////////////////////////////////////////
+
+#include <memory.h>
+
+extern "C" {
+#include "common.h"
+
+#ifdef WIN32
+    typedef unsigned long       UINT32;
+#endif
+
+#include "FtShmemTxt.h"
+}
+
+#include "ftProInterface2013MotionProfile.h"
+
+// Cycles to wait for the TXT after the profile is finished, before a stalled
+// motor is given up
+#define SETTLE_CYCLES_MAX 100
+
+ftIF2013MotionEngine::ftIF2013MotionEngine() :
+    m_count(0)
+{
+    memset(m_axes, 0, sizeof(m_axes));
+}
+
+int ftIF2013MotionEngine::Start(const ftIF2013MotionConfig& config, INT32 distance, FISH_X1_TRANSFER* transferarea, int nAreas)
+{
+    if (config.area < 0 || config.area >= nAreas || config.motor < 0 || config.motor >= IZ_MOTOR ||
+        config.vmax <= 0 || config.amax <= 0 || config.jmax < 0 || distance == 0 ||
+        distance > 0xFFFF || distance < -0xFFFF ||
+        config.dutymin < 0 || config.dutymax < 1 || config.dutymax > 512 || config.dutymin > config.dutymax)
+    {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // A new motion on the same motor replaces the running one
+    int id = -1;
+    for (int i = 0; i < MaxAxes; i++)
+    {
+        Axis* axis = &m_axes[i];
+        if (axis->active && axis->config.area == config.area && axis->config.motor == config.motor)
+        {
+            id = i;
+            m_count--;
+            break;
+        }
+        if (id < 0 && !axis->active) id = i;
+    }
+    if (id < 0) return -1;
+
+    Axis* axis = &m_axes[id];
+    memset(axis, 0, sizeof(*axis));
+    axis->config = config;
+    axis->distance = (float)((distance < 0) ? -distance : distance);
+    axis->direction = (distance < 0) ? -1 : 1;
+
+    // Start as enhanced motor command, the TXT resets the counter and stops
+    // the motor at the exact distance
+    FISH_X1_TRANSFER* area = &transferarea[config.area];
+    axis->lastcounter = (UINT16)area->ftX1in.counter[config.motor];
+    area->ftX1out.duty[2 * config.motor] = 0;
+    area->ftX1out.duty[2 * config.motor + 1] = 0;
+    area->ftX1out.distance[config.motor] = (UINT16)axis->distance;
+    area->ftX1out.master[config.motor] = 0;
+    area->ftX1in.motor_ex_reached[config.motor] = 0;
+    axis->cmdid = ++area->ftX1out.motor_ex_cmd_id[config.motor];
+
+    axis->active = true;
+    m_count++;
+    return id;
+}
+
+bool ftIF2013MotionEngine::Stop(int id, FISH_X1_TRANSFER* transferarea)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxAxes || !m_axes[id].active) return false;
+
+    Finish(&m_axes[id], transferarea);
+    return true;
+}
+
+bool ftIF2013MotionEngine::IsDone(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxAxes) return true;
+    return !m_axes[id].active;
+}
+
+INT32 ftIF2013MotionEngine::GetPosition(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxAxes) return 0;
+    // Kept after the end of the motion until the axis is started again
+    return m_axes[id].direction * m_axes[id].position;
+}
+
+void ftIF2013MotionEngine::Finish(Axis* axis, FISH_X1_TRANSFER* transferarea)
+{
+    FTX1_OUTPUT* out = &transferarea[axis->config.area].ftX1out;
+    out->duty[2 * axis->config.motor] = 0;
+    out->duty[2 * axis->config.motor + 1] = 0;
+    axis->v = 0;
+    axis->a = 0;
+    axis->active = false;
+    m_count--;
+}
+
+void ftIF2013MotionEngine::Step(Axis* axis, float dt)
+{
+    const ftIF2013MotionConfig& cfg = axis->config;
+    float remaining = axis->distance - axis->s;
+    float v = axis->v;
+    float a = axis->a;
+
+    if (cfg.jmax <= 0)
+    {
+        // Trapezoidal: brake such that v reaches 0 at the end
+        if (remaining <= v * v / (2 * cfg.amax))
+        {
+            a = (remaining > 0) ? -v * v / (2 * remaining) : -cfg.amax;
+        }
+        else a = (v < cfg.vmax) ? cfg.amax : 0;
+    }
+    else
+    {
+        // S-curve: ramp the acceleration towards the target with jmax
+        float brake = v * v / (2 * cfg.amax) + v * cfg.amax / (2 * cfg.jmax);
+        if (a > 0) brake += v * a / cfg.jmax;
+        float target;
+        if (remaining <= brake) target = -cfg.amax;
+        else if (v + a * a / (2 * cfg.jmax) >= cfg.vmax) target = 0;
+        else target = cfg.amax;
+
+        float da = cfg.jmax * dt;
+        if (a < target) a = (a + da < target) ? a + da : target;
+        else if (a > target) a = (a - da > target) ? a - da : target;
+    }
+
+    v += a * dt;
+    if (v > cfg.vmax) v = cfg.vmax;
+    if (v <= 0)
+    {
+        // Stopped before the end (rounding): the rest is done at dutymin
+        v = 0;
+        a = 0;
+        if (axis->s > 0) axis->s = axis->distance;
+    }
+    axis->s += v * dt;
+    if (axis->s >= axis->distance)
+    {
+        axis->s = axis->distance;
+        v = 0;
+        a = 0;
+    }
+    axis->v = v;
+    axis->a = a;
+}
+
+void ftIF2013MotionEngine::Process(FISH_X1_TRANSFER* transferarea, float dt)
+{
+    if (m_count == 0) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int id = 0; id < MaxAxes; id++)
+    {
+        Axis* axis = &m_axes[id];
+        if (!axis->active) continue;
+        const ftIF2013MotionConfig& cfg = axis->config;
+        FISH_X1_TRANSFER* area = &transferarea[cfg.area];
+
+        // Counter steps done, the counter is reset by the TXT when the command starts
+        UINT16 counter = (UINT16)area->ftX1in.counter[cfg.motor];
+        UINT16 delta = (UINT16)(counter - axis->lastcounter);
+        if (delta >= 0x8000) delta = counter;
+        axis->lastcounter = counter;
+        axis->position += delta;
+
+        // The TXT reports the command as finished when the distance is reached
+        if (area->ftX1in.motor_ex_cmd_id[cfg.motor] == axis->cmdid ||
+            (axis->s >= axis->distance && (axis->position >= axis->distance || ++axis->settlecycles > SETTLE_CYCLES_MAX)))
+        {
+            Finish(axis, transferarea);
+            continue;
+        }
+
+        Step(axis, dt);
+
+        float duty = cfg.dutypervelocity * axis->v + cfg.kp * (axis->s - axis->position);
+        if (duty < cfg.dutymin) duty = cfg.dutymin;
+        if (duty > cfg.dutymax) duty = cfg.dutymax;
+        INT16 value = (INT16)(duty + 0.5f);
+        area->ftX1out.duty[2 * cfg.motor] = (axis->direction > 0) ? value : 0;
+        area->ftX1out.duty[2 * cfg.motor + 1] = (axis->direction < 0) ? value : 0;
+    }
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013MotionProfile.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Trapezoidal and S-curve motion profiles for encoder motors
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013MotionProfile
+//
+// A profile moves an encoder motor a distance (in counter steps) with limited
+// velocity, acceleration and, for an S-curve, jerk. It is started as an enhanced
+// motor command with the total distance, so the TXT still stops the motor at
+// the exact counter value. After that the engine streams a new duty into
+// ftX1out.duty with each transfer:
+//
+//   duty = dutypervelocity * v(t) + kp * (s(t) - position), at least dutymin
+//
+// where s(t), v(t) are the set-points of the profile and position the counter
+// steps done so far. jmax=0 gives a trapezoidal profile.
+// The engine runs in the TA communication thread after input decode, the
+// profiles of all axes are calculated in the same cycle.
+//
+// Don't use a profile and a PID controller on the same motor.
+//
+// see also: ftIF2013TransferAreaComHandlerEx::StartMotionProfile
+//
+// The axis is free again as soon as the motion is finished or stopped, its
+// id then stays valid for IsDone and GetPosition until the next Start.
+//
+// Changes: 2026-10-19
+//          First version
+//          A finished axis is free at once, dutymin/dutymax are checked by Start
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection 
+#if(!defined(ftProInterface2013MotionProfile_H))
+#define ftProInterface2013MotionProfile_H
+
+#include <mutex>
+#include <atomic>
+extern "C" {
+#include "common.h"
+}
+// The transfer area, see FtShmemTxt.h
+// (not included here, because it needs UINT32 from windows.h)
+typedef struct shm_if_s FISH_X1_TRANSFER;
+
+/*!
+ * @brief Limits of a motion, all in counter steps and seconds
+ */
+struct ftIF2013MotionConfig
+{
+	int   area;            // ShmIfId_TXT
+	int   motor;           // motor M1..M4 (0..3) with its encoder on C1..C4
+	float vmax;            // maximum velocity [steps/s]
+	float amax;            // maximum acceleration [steps/s^2]
+	float jmax;            // maximum jerk [steps/s^3], 0 = trapezoidal profile
+	float dutypervelocity; // feed forward [duty per step/s], e.g. 512/(steps/s at duty 512)
+	float kp;              // position feedback [duty per step], 0 = feed forward only
+	INT16 dutymin;         // minimum duty while moving (static friction), 0..dutymax
+	INT16 dutymax;         // maximum duty, 1..512
+};
+
+/*!
+ * @brief Fixed size set of axes, see the module description
+ */
+class ftIF2013MotionEngine
+{
+public:
+	enum { MaxAxes = 8 };
+
+	ftIF2013MotionEngine();
+
+	/*!
+	 * @brief Start a motion on a motor, a running motion on the same motor is replaced
+	 * @param distance signed distance in counter steps, the sign gives the direction
+	 * @return id of the axis, -1 if the configuration is wrong (e.g. dutymin > dutymax)
+	 * or all axes are in use
+	 */
+	int Start(const ftIF2013MotionConfig& config, INT32 distance, FISH_X1_TRANSFER* transferarea, int nAreas);
+	/*!
+	 * @brief Stop a motion immediately (duty 0), the axis is free again
+	 * @return false if the motion is already finished or the id is wrong
+	 */
+	bool Stop(int id, FISH_X1_TRANSFER* transferarea);
+	/*!
+	 * @return the motion is finished or stopped (or the id is wrong)
+	 */
+	bool IsDone(int id);
+	/*!
+	 * @return the counter steps done so far, also after the end of the motion
+	 */
+	INT32 GetPosition(int id);
+
+	/*!
+	 * @brief Calculate the next set-points of all axes, called by the TA
+	 * communication thread after decode
+	 * @param dt time since the previous transfer [s]
+	 */
+	void Process(FISH_X1_TRANSFER* transferarea, float dt);
+
+protected:
+	struct Axis
+	{
+		bool   active;      // running, the axis is in use
+		ftIF2013MotionConfig config;
+		float  distance;    // |distance|
+		int    direction;   // +1 or -1
+		UINT16 cmdid;       // motor_ex_cmd_id of this motion
+		float  s, v, a;     // set-points: position, velocity, acceleration
+		INT32  position;    // counter steps done
+		UINT16 lastcounter;
+		int    settlecycles;
+	};
+	void Step(Axis* axis, float dt);
+	void Finish(Axis* axis, FISH_X1_TRANSFER* transferarea);
+
+	std::mutex m_mutex;
+	std::atomic<int> m_count; // number of running axes, so an idle engine costs nothing
+	Axis m_axes[MaxAxes];
+};
+
+#endif // ftProInterface2013MotionProfile_H
@@ -0,0 +1,154 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013PidControl.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  PID controller engine running in the TA communication thread
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013PidControl
+//
+// Per cycle and loop:
+//   e        = setpoint - value
+//   integral = clamp( integral + ki*e, +-imax )   (not while the output saturates
+//                                                  in the direction of e)
+//   output   = clamp( kp*e + integral - kd*(value-lastvalue), outmin, outmax )
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+#include <memory.h>
+
+extern "C" {
+#include "common.h"
+
+#ifdef WIN32
+    typedef unsigned long       UINT32;
+#endif
+
+#include "FtShmemTxt.h"
+}
+
+#include "ftProInterface2013PidControl.h"
+
+ftIF2013PidEngine::ftIF2013PidEngine() :
+    m_count(0)
+{
+    memset(m_loops, 0, sizeof(m_loops));
+}
+
+INT32 ftIF2013PidEngine::ReadValue(Loop* loop, FISH_X1_TRANSFER* transferarea)
+{
+    FTX1_INPUT* in = &transferarea[loop->config.area].ftX1in;
+    if (loop->config.source == FTIF2013_PID_UNI)
+    {
+        return in->uni[loop->config.input];
+    }
+
+    // Counters only count up, use the direction of the last output
+    UINT16 counter = (UINT16)in->counter[loop->config.input];
+    UINT16 delta = (UINT16)(counter - loop->lastcounter);
+    if (delta >= 0x8000)
+    {
+        // counter has been reset (e.g. by a motor_ex command)
+        delta = counter;
+    }
+    loop->lastcounter = counter;
+    return (loop->output < 0) ? loop->value - delta : loop->value + delta;
+}
+
+int ftIF2013PidEngine::Add(const ftIF2013PidConfig& config, FISH_X1_TRANSFER* transferarea, int nAreas)
+{
+    if (config.area < 0 || config.area >= nAreas || config.motor < 0 || config.motor >= IZ_MOTOR ||
+        config.input < 0 || config.input >= ((config.source == FTIF2013_PID_UNI) ? IZ_UNI_INPUT : IZ_COUNTER) ||
+        config.outmin > config.outmax)
+    {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int id = 0; id < MaxLoops; id++)
+    {
+        Loop* loop = &m_loops[id];
+        if (loop->active) continue;
+
+        memset(loop, 0, sizeof(*loop));
+        loop->config = config;
+        loop->lastcounter = (UINT16)transferarea[config.area].ftX1in.counter[config.input];
+        loop->value = (config.source == FTIF2013_PID_UNI) ? transferarea[config.area].ftX1in.uni[config.input] : 0;
+        loop->lastvalue = loop->value;
+        loop->setpoint = loop->value;
+        loop->active = true;
+        m_count++;
+        return id;
+    }
+    return -1;
+}
+
+bool ftIF2013PidEngine::Remove(int id, FISH_X1_TRANSFER* transferarea)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxLoops || !m_loops[id].active) return false;
+
+    Loop* loop = &m_loops[id];
+    loop->active = false;
+    m_count--;
+    FTX1_OUTPUT* out = &transferarea[loop->config.area].ftX1out;
+    out->duty[2 * loop->config.motor] = 0;
+    out->duty[2 * loop->config.motor + 1] = 0;
+    return true;
+}
+
+bool ftIF2013PidEngine::SetSetpoint(int id, INT32 setpoint)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxLoops || !m_loops[id].active) return false;
+    m_loops[id].setpoint = setpoint;
+    return true;
+}
+
+INT32 ftIF2013PidEngine::GetValue(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxLoops || !m_loops[id].active) return 0;
+    return m_loops[id].value;
+}
+
+void ftIF2013PidEngine::Process(FISH_X1_TRANSFER* transferarea)
+{
+    if (m_count == 0) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int id = 0; id < MaxLoops; id++)
+    {
+        Loop* loop = &m_loops[id];
+        if (!loop->active) continue;
+        const ftIF2013PidConfig& cfg = loop->config;
+
+        loop->lastvalue = loop->value;
+        loop->value = ReadValue(loop, transferarea);
+        INT32 error = loop->setpoint - loop->value;
+
+        // Integral with clamping, and no further integration while saturated
+        bool saturated = (loop->output >= cfg.outmax && error > 0) || (loop->output <= cfg.outmin && error < 0);
+        if (!saturated)
+        {
+            long long imax = (long long)cfg.imax << 16;
+            loop->integral += (long long)cfg.ki * error;
+            if (loop->integral > imax) loop->integral = imax;
+            if (loop->integral < -imax) loop->integral = -imax;
+        }
+
+        long long output = (long long)cfg.kp * error + loop->integral - (long long)cfg.kd * (loop->value - loop->lastvalue);
+        output >>= 16;
+        if (output > cfg.outmax) output = cfg.outmax;
+        if (output < cfg.outmin) output = cfg.outmin;
+        loop->output = (INT32)output;
+
+        FTX1_OUTPUT* out = &transferarea[cfg.area].ftX1out;
+        out->duty[2 * cfg.motor] = (loop->output > 0) ? (INT16)loop->output : 0;
+        out->duty[2 * cfg.motor + 1] = (loop->output < 0) ? (INT16)-loop->output : 0;
+    }
+}
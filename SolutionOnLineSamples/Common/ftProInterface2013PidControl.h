@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013PidControl.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  PID controller engine running in the TA communication thread
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013PidControl
+//
+// The engine runs right after the inputs of a transfer have been decoded and
+// writes the motor duty values which are sent with the next transfer, so the
+// control latency is exactly one exchange (10 ms).
+// All calculations are done in fixed point, the gains are Q16.16 numbers
+// (65536 = 1.0) per cycle.
+//
+// The TXT counters count the encoder pulses in both directions up. For
+// FTIF2013_PID_COUNTER the engine integrates the counter steps with the sign
+// of the duty it has sent, which gives a signed position.
+//
+// see also: ftIF2013TransferAreaComHandlerEx::AddPidController
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection 
+#if(!defined(ftProInterface2013PidControl_H))
+#define ftProInterface2013PidControl_H
+
+#include <mutex>
+#include <atomic>
+extern "C" {
+#include "common.h"
+}
+// The transfer area, see FtShmemTxt.h
+// (not included here, because it needs UINT32 from windows.h)
+typedef struct shm_if_s FISH_X1_TRANSFER;
+
+/*!
+ * @brief Source of the process value
+ */
+enum ftIF2013PidSource
+{
+	FTIF2013_PID_COUNTER = 0, // signed position from counter C1..C4 (input=0..3)
+	FTIF2013_PID_UNI          // value of universal input I1..I8 (input=0..7)
+};
+
+/*!
+ * @brief Configuration of one control loop
+ */
+struct ftIF2013PidConfig
+{
+	int   area;    // ShmIfId_TXT
+	int   source;  // ftIF2013PidSource
+	int   input;   // counter or universal input index
+	int   motor;   // motor output M1..M4 (0..3), writes duty[2*motor] and duty[2*motor+1]
+	INT32 kp;      // proportional gain, Q16.16
+	INT32 ki;      // integral gain per cycle, Q16.16
+	INT32 kd;      // derivative gain per cycle, Q16.16 (on the process value)
+	INT16 outmin;  // output clamp, -512..512
+	INT16 outmax;  // output clamp, -512..512
+	INT32 imax;    // anti-windup: limit of the integral part in duty units
+};
+
+/*!
+ * @brief Fixed size set of PID loops, see the module description
+ */
+class ftIF2013PidEngine
+{
+public:
+	enum { MaxLoops = 8 };
+
+	ftIF2013PidEngine();
+
+	/*!
+	 * @brief Add a loop, the setpoint is the current process value
+	 * @return id of the loop, -1 if the configuration is wrong or all loops are in use
+	 */
+	int Add(const ftIF2013PidConfig& config, FISH_X1_TRANSFER* transferarea, int nAreas);
+	/*!
+	 * @brief Remove a loop, the motor output is set to 0
+	 */
+	bool Remove(int id, FISH_X1_TRANSFER* transferarea);
+	bool SetSetpoint(int id, INT32 setpoint);
+	/*!
+	 * @return the process value of the last cycle (e.g. the signed position)
+	 */
+	INT32 GetValue(int id);
+
+	/*!
+	 * @brief Run all loops, called by the TA communication thread after decode
+	 */
+	void Process(FISH_X1_TRANSFER* transferarea);
+
+protected:
+	struct Loop
+	{
+		bool   active;
+		ftIF2013PidConfig config;
+		INT32  setpoint;
+		INT32  value;      // process value
+		INT32  lastvalue;
+		UINT16 lastcounter;
+		INT32  output;     // duty sent with the next transfer
+		long long  integral;   // Q16.16
+	};
+	INT32 ReadValue(Loop* loop, FISH_X1_TRANSFER* transferarea);
+
+	std::mutex m_mutex;
+	std::atomic<int> m_count; // number of active loops, so an idle engine costs nothing
+	Loop m_loops[MaxLoops];
+};
+
+#endif // ftProInterface2013PidControl_H
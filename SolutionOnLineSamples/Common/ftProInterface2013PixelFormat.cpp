@@ -0,0 +1,742 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013PixelFormat.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Output pixel formats of the JPEG decoder and SIMD packers
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013PixelFormat
+//
+// Every kernel converts one row. The SIMD variants handle 16 (SSE2) or
+// 32 (AVX2) pixels per step and leave the rest of a row to the C variant,
+// all variants give identical results.
+//
+// YCbCr to RGB (JFIF), with c_b = 4*(Cb-128) and c_r = 4*(Cr-128):
+//   R = Y + (c_r*22970 >> 16)
+//   G = Y - (c_b*5638 >> 16) - (c_r*11700 >> 16)
+//   B = Y + (c_b*29032 >> 16)
+// where 22970 = 1.402*2^14, 5638 = 0.344136*2^14, 11700 = 0.714136*2^14 and
+// 29032 = 1.772*2^14. A product shifted right by 16 is exactly what
+// _mm_mulhi_epi16 computes.
+//
+// Orientation: a flip of the rows (FLIP_H, ROT180) reverses the Y, U and V
+// rows of the strip into a scratch strip first, a flip of the columns only
+// changes the output row. The transposing orientations write each pair of
+// source rows into a pair of output columns (scalar, the converted RGB rows
+// are copied pixel by pixel).
+//
+// Changes: 2026-10-19
+//          First version
+//          Orientation (rotate and flip) while packing
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <vector>
+
+#include "ftProInterface2013PixelFormat.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define FTPRO_SIMD_X86
+#endif
+
+#if defined(FTPRO_SIMD_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FTPRO_TARGET_SSE2
+#define FTPRO_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define FTPRO_TARGET_SSE2 __attribute__((target("sse2")))
+#define FTPRO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#include <immintrin.h>
+#endif
+
+typedef unsigned char UINT8;
+
+#define K_CR_R 22970
+#define K_CB_G 5638
+#define K_CR_G 11700
+#define K_CB_B 29032
+
+//******************************************************************************
+//****
+//**** CPU detection
+//****
+//******************************************************************************
+
+static int DetectCpuFeatures()
+{
+    int features = 0;
+#if defined(FTPRO_SIMD_X86)
+    unsigned int regs[4] = { 0, 0, 0, 0 };
+    unsigned int maxleaf;
+    unsigned long long xcr0 = 0;
+#if defined(_MSC_VER)
+    __cpuid((int*)regs, 0);
+    maxleaf = regs[0];
+    __cpuid((int*)regs, 1);
+#else
+    __cpuid(0, regs[0], regs[1], regs[2], regs[3]);
+    maxleaf = regs[0];
+    __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    if (regs[3] & (1u << 26)) features |= FTPRO_CPU_SSE2;
+    if (regs[2] & (1u << 9))  features |= FTPRO_CPU_SSSE3;
+    if (regs[2] & (1u << 19)) features |= FTPRO_CPU_SSE41;
+
+    // AVX2 also needs the OS to save the YMM registers (OSXSAVE + XCR0)
+    bool osavx = (regs[2] & (1u << 27)) && (regs[2] & (1u << 28));
+    if (osavx)
+    {
+#if defined(_MSC_VER)
+        xcr0 = _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+    }
+    if (osavx && (xcr0 & 6) == 6 && maxleaf >= 7)
+    {
+#if defined(_MSC_VER)
+        __cpuidex((int*)regs, 7, 0);
+#else
+        __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+        if (regs[1] & (1u << 5)) features |= FTPRO_CPU_AVX2;
+    }
+#endif
+    return features;
+}
+
+static int s_cpulimit = -1;
+
+int ftProGetCpuFeatures()
+{
+    static int features = DetectCpuFeatures();
+    return features & s_cpulimit;
+}
+
+void ftProLimitCpuFeatures(int mask)
+{
+    s_cpulimit = mask;
+}
+
+size_t ftProPixelFormatSize(int format, int width, int height)
+{
+    if (width <= 0 || height <= 0 || (width & 1) || (height & 1))
+    {
+        return 0;
+    }
+    size_t pixels = (size_t)width * height;
+    switch (format)
+    {
+    case FTPRO_PIXEL_YUYV:  return pixels * 2;
+    case FTPRO_PIXEL_I420:  return pixels * 3 / 2;
+    case FTPRO_PIXEL_NV12:  return pixels * 3 / 2;
+    case FTPRO_PIXEL_RGB24: return pixels * 3;
+    case FTPRO_PIXEL_BGRA:  return pixels * 4;
+    case FTPRO_PIXEL_GRAY8: return pixels;
+    default:                return 0;
+    }
+}
+
+//******************************************************************************
+//****
+//**** Row kernels: plain C
+//****
+//******************************************************************************
+
+static inline UINT8 Clamp255(int value)
+{
+    return (UINT8)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+static inline void YccToRgb(int y, int cb, int cr, UINT8* r, UINT8* g, UINT8* b)
+{
+    int cb4 = (cb - 128) * 4;
+    int cr4 = (cr - 128) * 4;
+    *r = Clamp255(y + ((cr4 * K_CR_R) >> 16));
+    *g = Clamp255(y - ((cb4 * K_CB_G) >> 16) - ((cr4 * K_CR_G) >> 16));
+    *b = Clamp255(y + ((cb4 * K_CB_B) >> 16));
+}
+
+static void RowYuyvC(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    for (; x < width; x += 2)
+    {
+        UINT8* out = dst + 2 * x;
+        out[0] = y[x];
+        out[1] = u[x >> 1];
+        out[2] = y[x + 1];
+        out[3] = v[x >> 1];
+    }
+}
+
+static void RowAvgC(const UINT8* a, const UINT8* b, UINT8* dst, int x, int count)
+{
+    for (; x < count; x++)
+    {
+        dst[x] = (UINT8)((a[x] + b[x] + 1) >> 1);
+    }
+}
+
+static void RowAvgInterleaveC(const UINT8* u0, const UINT8* u1, const UINT8* v0, const UINT8* v1, UINT8* dst, int x, int count)
+{
+    for (; x < count; x++)
+    {
+        dst[2 * x] = (UINT8)((u0[x] + u1[x] + 1) >> 1);
+        dst[2 * x + 1] = (UINT8)((v0[x] + v1[x] + 1) >> 1);
+    }
+}
+
+static void RowRgb24C(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    for (; x < width; x++)
+    {
+        UINT8* out = dst + 3 * x;
+        YccToRgb(y[x], u[x >> 1], v[x >> 1], &out[0], &out[1], &out[2]);
+    }
+}
+
+static void RowBgraC(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    for (; x < width; x++)
+    {
+        UINT8* out = dst + 4 * x;
+        YccToRgb(y[x], u[x >> 1], v[x >> 1], &out[2], &out[1], &out[0]);
+        out[3] = 255;
+    }
+}
+
+// dst[i] = src[count-1-i] for i >= x
+static void RowReverseC(const UINT8* src, UINT8* dst, int x, int count)
+{
+    for (; x < count; x++)
+    {
+        dst[x] = src[count - 1 - x];
+    }
+}
+
+#if defined(FTPRO_SIMD_X86)
+
+//******************************************************************************
+//****
+//**** Row kernels: SSE2 (16 pixels per step)
+//****
+//******************************************************************************
+
+// Y, Cb, Cr of 8 pixels (16 bit) to R, G, B (16 bit)
+FTPRO_TARGET_SSE2 static inline void YccToRgb8(__m128i y, __m128i cb, __m128i cr, __m128i* r, __m128i* g, __m128i* b)
+{
+    const __m128i bias = _mm_set1_epi16(128);
+    cb = _mm_slli_epi16(_mm_sub_epi16(cb, bias), 2);
+    cr = _mm_slli_epi16(_mm_sub_epi16(cr, bias), 2);
+    *r = _mm_add_epi16(y, _mm_mulhi_epi16(cr, _mm_set1_epi16(K_CR_R)));
+    *g = _mm_sub_epi16(_mm_sub_epi16(y, _mm_mulhi_epi16(cb, _mm_set1_epi16(K_CB_G))), _mm_mulhi_epi16(cr, _mm_set1_epi16(K_CR_G)));
+    *b = _mm_add_epi16(y, _mm_mulhi_epi16(cb, _mm_set1_epi16(K_CB_B)));
+}
+
+// 16 pixels from x: R, G, B as bytes
+FTPRO_TARGET_SSE2 static inline void YccToRgb16(const UINT8* y, const UINT8* u, const UINT8* v, int x, __m128i* r, __m128i* g, __m128i* b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i yy = _mm_loadu_si128((const __m128i*)(y + x));
+    __m128i uu = _mm_loadl_epi64((const __m128i*)(u + (x >> 1)));
+    __m128i vv = _mm_loadl_epi64((const __m128i*)(v + (x >> 1)));
+    // Each chroma sample belongs to two pixels
+    uu = _mm_unpacklo_epi8(uu, uu);
+    vv = _mm_unpacklo_epi8(vv, vv);
+
+    __m128i rlo, glo, blo, rhi, ghi, bhi;
+    YccToRgb8(_mm_unpacklo_epi8(yy, zero), _mm_unpacklo_epi8(uu, zero), _mm_unpacklo_epi8(vv, zero), &rlo, &glo, &blo);
+    YccToRgb8(_mm_unpackhi_epi8(yy, zero), _mm_unpackhi_epi8(uu, zero), _mm_unpackhi_epi8(vv, zero), &rhi, &ghi, &bhi);
+    *r = _mm_packus_epi16(rlo, rhi);
+    *g = _mm_packus_epi16(glo, ghi);
+    *b = _mm_packus_epi16(blo, bhi);
+}
+
+// 16 pixels B G R A
+FTPRO_TARGET_SSE2 static inline void StoreBgra16(UINT8* out, __m128i r, __m128i g, __m128i b)
+{
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+    __m128i bglo = _mm_unpacklo_epi8(b, g);
+    __m128i bghi = _mm_unpackhi_epi8(b, g);
+    __m128i ralo = _mm_unpacklo_epi8(r, alpha);
+    __m128i rahi = _mm_unpackhi_epi8(r, alpha);
+    _mm_storeu_si128((__m128i*)(out), _mm_unpacklo_epi16(bglo, ralo));
+    _mm_storeu_si128((__m128i*)(out + 16), _mm_unpackhi_epi16(bglo, ralo));
+    _mm_storeu_si128((__m128i*)(out + 32), _mm_unpacklo_epi16(bghi, rahi));
+    _mm_storeu_si128((__m128i*)(out + 48), _mm_unpackhi_epi16(bghi, rahi));
+}
+
+FTPRO_TARGET_SSE2 static void RowReverseSse2(const UINT8* src, UINT8* dst, int x, int count)
+{
+    for (; x + 16 <= count; x += 16)
+    {
+        // Reverse the dwords, the words in the dwords and the bytes in the words
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + count - 16 - x));
+        v = _mm_shuffle_epi32(v, 0x1B);
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(dst + x), v);
+    }
+    RowReverseC(src, dst, x, count);
+}
+
+FTPRO_TARGET_SSE2 static void RowYuyvSse2(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i yy = _mm_loadu_si128((const __m128i*)(y + x));
+        __m128i uu = _mm_loadl_epi64((const __m128i*)(u + (x >> 1)));
+        __m128i vv = _mm_loadl_epi64((const __m128i*)(v + (x >> 1)));
+        __m128i uv = _mm_unpacklo_epi8(uu, vv);
+        _mm_storeu_si128((__m128i*)(dst + 2 * x), _mm_unpacklo_epi8(yy, uv));
+        _mm_storeu_si128((__m128i*)(dst + 2 * x + 16), _mm_unpackhi_epi8(yy, uv));
+    }
+    RowYuyvC(y, u, v, dst, x, width);
+}
+
+FTPRO_TARGET_SSE2 static void RowAvgSse2(const UINT8* a, const UINT8* b, UINT8* dst, int x, int count)
+{
+    for (; x + 16 <= count; x += 16)
+    {
+        __m128i aa = _mm_loadu_si128((const __m128i*)(a + x));
+        __m128i bb = _mm_loadu_si128((const __m128i*)(b + x));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_avg_epu8(aa, bb));
+    }
+    RowAvgC(a, b, dst, x, count);
+}
+
+FTPRO_TARGET_SSE2 static void RowAvgInterleaveSse2(const UINT8* u0, const UINT8* u1, const UINT8* v0, const UINT8* v1, UINT8* dst, int x, int count)
+{
+    for (; x + 16 <= count; x += 16)
+    {
+        __m128i uu = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(u0 + x)), _mm_loadu_si128((const __m128i*)(u1 + x)));
+        __m128i vv = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(v0 + x)), _mm_loadu_si128((const __m128i*)(v1 + x)));
+        _mm_storeu_si128((__m128i*)(dst + 2 * x), _mm_unpacklo_epi8(uu, vv));
+        _mm_storeu_si128((__m128i*)(dst + 2 * x + 16), _mm_unpackhi_epi8(uu, vv));
+    }
+    RowAvgInterleaveC(u0, u1, v0, v1, dst, x, count);
+}
+
+FTPRO_TARGET_SSE2 static void RowRgb24Sse2(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    // SSE2 has no byte shuffle: calculate with SIMD, interleave scalar
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i r, g, b;
+        YccToRgb16(y, u, v, x, &r, &g, &b);
+#if defined(_MSC_VER)
+        __declspec(align(16)) UINT8 rgb[3][16];
+#else
+        UINT8 rgb[3][16] __attribute__((aligned(16)));
+#endif
+        _mm_store_si128((__m128i*)rgb[0], r);
+        _mm_store_si128((__m128i*)rgb[1], g);
+        _mm_store_si128((__m128i*)rgb[2], b);
+        UINT8* out = dst + 3 * x;
+        for (int i = 0; i < 16; i++)
+        {
+            out[3 * i] = rgb[0][i];
+            out[3 * i + 1] = rgb[1][i];
+            out[3 * i + 2] = rgb[2][i];
+        }
+    }
+    RowRgb24C(y, u, v, dst, x, width);
+}
+
+FTPRO_TARGET_SSE2 static void RowBgraSse2(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i r, g, b;
+        YccToRgb16(y, u, v, x, &r, &g, &b);
+        StoreBgra16(dst + 4 * x, r, g, b);
+    }
+    RowBgraC(y, u, v, dst, x, width);
+}
+
+//******************************************************************************
+//****
+//**** Row kernels: AVX2 (32 pixels per step)
+//****
+//******************************************************************************
+
+// 16 pixels from x: R, G, B as bytes, the arithmetic on 16 lanes
+FTPRO_TARGET_AVX2 static inline void YccToRgb16Avx2(const UINT8* y, const UINT8* u, const UINT8* v, int x, __m128i* r, __m128i* g, __m128i* b)
+{
+    const __m256i bias = _mm256_set1_epi16(128);
+    __m128i uu = _mm_loadl_epi64((const __m128i*)(u + (x >> 1)));
+    __m128i vv = _mm_loadl_epi64((const __m128i*)(v + (x >> 1)));
+    __m256i yy = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(y + x)));
+    __m256i cb = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(uu, uu));
+    __m256i cr = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(vv, vv));
+    cb = _mm256_slli_epi16(_mm256_sub_epi16(cb, bias), 2);
+    cr = _mm256_slli_epi16(_mm256_sub_epi16(cr, bias), 2);
+    __m256i rr = _mm256_add_epi16(yy, _mm256_mulhi_epi16(cr, _mm256_set1_epi16(K_CR_R)));
+    __m256i gg = _mm256_sub_epi16(_mm256_sub_epi16(yy, _mm256_mulhi_epi16(cb, _mm256_set1_epi16(K_CB_G))), _mm256_mulhi_epi16(cr, _mm256_set1_epi16(K_CR_G)));
+    __m256i bb = _mm256_add_epi16(yy, _mm256_mulhi_epi16(cb, _mm256_set1_epi16(K_CB_B)));
+    // packus works per 128 bit lane: bring the 8 byte halves together
+    *r = _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(rr, rr), 0xD8));
+    *g = _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(gg, gg), 0xD8));
+    *b = _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(bb, bb), 0xD8));
+}
+
+FTPRO_TARGET_AVX2 static void RowYuyvAvx2(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i yy = _mm256_loadu_si256((const __m256i*)(y + x));
+        __m128i uu = _mm_loadu_si128((const __m128i*)(u + (x >> 1)));
+        __m128i vv = _mm_loadu_si128((const __m128i*)(v + (x >> 1)));
+        // uv of pixels 0..15 in the low lane, of pixels 16..31 in the high lane
+        __m256i uv = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(uu, vv)), _mm_unpackhi_epi8(uu, vv), 1);
+        __m256i lo = _mm256_unpacklo_epi8(yy, uv);  // pixels 0..7 | 16..23
+        __m256i hi = _mm256_unpackhi_epi8(yy, uv);  // pixels 8..15 | 24..31
+        _mm256_storeu_si256((__m256i*)(dst + 2 * x), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(dst + 2 * x + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    RowYuyvSse2(y, u, v, dst, x, width);
+}
+
+FTPRO_TARGET_AVX2 static void RowAvgAvx2(const UINT8* a, const UINT8* b, UINT8* dst, int x, int count)
+{
+    for (; x + 32 <= count; x += 32)
+    {
+        __m256i aa = _mm256_loadu_si256((const __m256i*)(a + x));
+        __m256i bb = _mm256_loadu_si256((const __m256i*)(b + x));
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_avg_epu8(aa, bb));
+    }
+    RowAvgSse2(a, b, dst, x, count);
+}
+
+FTPRO_TARGET_AVX2 static void RowAvgInterleaveAvx2(const UINT8* u0, const UINT8* u1, const UINT8* v0, const UINT8* v1, UINT8* dst, int x, int count)
+{
+    for (; x + 32 <= count; x += 32)
+    {
+        __m256i uu = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)(u0 + x)), _mm256_loadu_si256((const __m256i*)(u1 + x)));
+        __m256i vv = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i*)(v0 + x)), _mm256_loadu_si256((const __m256i*)(v1 + x)));
+        __m256i lo = _mm256_unpacklo_epi8(uu, vv);
+        __m256i hi = _mm256_unpackhi_epi8(uu, vv);
+        _mm256_storeu_si256((__m256i*)(dst + 2 * x), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i*)(dst + 2 * x + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    RowAvgInterleaveSse2(u0, u1, v0, v1, dst, x, count);
+}
+
+// Byte positions of R, G, B for the three 16 byte blocks of 16 RGB pixels
+static const signed char s_rgb24shuffle[3][3][16] =
+{
+    { { 0,-1,-1, 1,-1,-1, 2,-1,-1, 3,-1,-1, 4,-1,-1, 5 },
+      {-1, 0,-1,-1, 1,-1,-1, 2,-1,-1, 3,-1,-1, 4,-1,-1 },
+      {-1,-1, 0,-1,-1, 1,-1,-1, 2,-1,-1, 3,-1,-1, 4,-1 } },
+    { {-1,-1, 6,-1,-1, 7,-1,-1, 8,-1,-1, 9,-1,-1,10,-1 },
+      { 5,-1,-1, 6,-1,-1, 7,-1,-1, 8,-1,-1, 9,-1,-1,10 },
+      {-1, 5,-1,-1, 6,-1,-1, 7,-1,-1, 8,-1,-1, 9,-1,-1 } },
+    { {-1,11,-1,-1,12,-1,-1,13,-1,-1,14,-1,-1,15,-1,-1 },
+      {-1,-1,11,-1,-1,12,-1,-1,13,-1,-1,14,-1,-1,15,-1 },
+      {10,-1,-1,11,-1,-1,12,-1,-1,13,-1,-1,14,-1,-1,15 } }
+};
+
+FTPRO_TARGET_AVX2 static void RowRgb24Avx2(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    __m128i mask[3][3];
+    for (int k = 0; k < 3; k++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            mask[k][c] = _mm_loadu_si128((const __m128i*)s_rgb24shuffle[k][c]);
+        }
+    }
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i r, g, b;
+        YccToRgb16Avx2(y, u, v, x, &r, &g, &b);
+        UINT8* out = dst + 3 * x;
+        for (int k = 0; k < 3; k++)
+        {
+            __m128i block = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, mask[k][0]), _mm_shuffle_epi8(g, mask[k][1])), _mm_shuffle_epi8(b, mask[k][2]));
+            _mm_storeu_si128((__m128i*)(out + 16 * k), block);
+        }
+    }
+    RowRgb24C(y, u, v, dst, x, width);
+}
+
+FTPRO_TARGET_AVX2 static void RowBgraAvx2(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i r, g, b;
+        YccToRgb16Avx2(y, u, v, x, &r, &g, &b);
+        StoreBgra16(dst + 4 * x, r, g, b);
+    }
+    RowBgraC(y, u, v, dst, x, width);
+}
+
+#endif // FTPRO_SIMD_X86
+
+//******************************************************************************
+//****
+//**** Kernel selection and strip packing
+//****
+//******************************************************************************
+
+struct ftProPackKernels
+{
+    void (*yuyv)(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width);
+    void (*avg)(const UINT8* a, const UINT8* b, UINT8* dst, int x, int count);
+    void (*avginterleave)(const UINT8* u0, const UINT8* u1, const UINT8* v0, const UINT8* v1, UINT8* dst, int x, int count);
+    void (*rgb24)(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width);
+    void (*bgra)(const UINT8* y, const UINT8* u, const UINT8* v, UINT8* dst, int x, int width);
+    void (*reverse)(const UINT8* src, UINT8* dst, int x, int count);
+};
+
+static ftProPackKernels SelectKernels()
+{
+    ftProPackKernels kernels = { RowYuyvC, RowAvgC, RowAvgInterleaveC, RowRgb24C, RowBgraC, RowReverseC };
+#if defined(FTPRO_SIMD_X86)
+    int features = ftProGetCpuFeatures();
+    if (features & FTPRO_CPU_AVX2)
+    {
+        ftProPackKernels avx2 = { RowYuyvAvx2, RowAvgAvx2, RowAvgInterleaveAvx2, RowRgb24Avx2, RowBgraAvx2, RowReverseSse2 };
+        kernels = avx2;
+    }
+    else if (features & FTPRO_CPU_SSE2)
+    {
+        ftProPackKernels sse2 = { RowYuyvSse2, RowAvgSse2, RowAvgInterleaveSse2, RowRgb24Sse2, RowBgraSse2, RowReverseSse2 };
+        kernels = sse2;
+    }
+#endif
+    return kernels;
+}
+
+static const ftProPackKernels& GetPackKernels()
+{
+    static const ftProPackKernels kernels = SelectKernels();
+    return kernels;
+}
+
+// Transposing orientations: source rows become output columns
+static void PackStripTransposed(const ftProImage& image, int y0, int lines,
+    unsigned char* const* rowsY, unsigned char* const* rowsU, unsigned char* const* rowsV)
+{
+    const ftProPackKernels& kernels = GetPackKernels();
+
+    int width = image.width;      // = height of the frame
+    int height = image.height;    // = width of the frame
+    int cwidth = width / 2;
+    size_t lumasize = (size_t)width * height;
+    UINT8* data = image.data;
+    // Source row y goes to column y or width-1-y, source column x to row x or height-1-x
+    bool mirrorx = image.orientation == FTPRO_ORIENT_ROT90 || image.orientation == FTPRO_ORIENT_TRANSVERSE;
+    bool mirrory = image.orientation == FTPRO_ORIENT_ROT270 || image.orientation == FTPRO_ORIENT_TRANSVERSE;
+
+    // RGB rows of the two source rows
+    int bytes = image.format == FTPRO_PIXEL_RGB24 ? 3 : 4;
+    static thread_local std::vector<UINT8> rgb;
+    if (image.format == FTPRO_PIXEL_RGB24 || image.format == FTPRO_PIXEL_BGRA)
+    {
+        rgb.resize((size_t)height * bytes * 2);
+    }
+
+    for (int line = 0; line < lines; line += 2)
+    {
+        // Pair of output columns c, c+1 from the rows a and b
+        int y = y0 + line;
+        int column = mirrorx ? width - 2 - y : y;
+        int a = mirrorx ? line + 1 : line;
+        int b = mirrorx ? line : line + 1;
+        const UINT8* ya = rowsY[a];
+        const UINT8* yb = rowsY[b];
+
+        switch (image.format)
+        {
+        case FTPRO_PIXEL_GRAY8:
+        case FTPRO_PIXEL_I420:
+        case FTPRO_PIXEL_NV12:
+            for (int x = 0; x < height; x++)
+            {
+                UINT8* out = data + (size_t)(mirrory ? height - 1 - x : x) * width + column;
+                out[0] = ya[x];
+                out[1] = yb[x];
+            }
+            if (image.format == FTPRO_PIXEL_GRAY8)
+            {
+                break;
+            }
+            // One chroma sample for source columns 2k and 2k+1 of both rows
+            for (int k = 0; k < height / 2; k++)
+            {
+                size_t crow = (size_t)(mirrory ? height / 2 - 1 - k : k);
+                UINT8 u = (UINT8)((rowsU[a][k] + rowsU[b][k] + 1) >> 1);
+                UINT8 v = (UINT8)((rowsV[a][k] + rowsV[b][k] + 1) >> 1);
+                if (image.format == FTPRO_PIXEL_I420)
+                {
+                    data[lumasize + crow * cwidth + column / 2] = u;
+                    data[lumasize + lumasize / 4 + crow * cwidth + column / 2] = v;
+                }
+                else
+                {
+                    UINT8* out = data + lumasize + crow * width + column;
+                    out[0] = u;
+                    out[1] = v;
+                }
+            }
+            break;
+
+        case FTPRO_PIXEL_YUYV:
+            for (int x = 0; x < height; x++)
+            {
+                UINT8* out = data + ((size_t)(mirrory ? height - 1 - x : x) * width + column) * 2;
+                out[0] = ya[x];
+                out[1] = (UINT8)((rowsU[a][x >> 1] + rowsU[b][x >> 1] + 1) >> 1);
+                out[2] = yb[x];
+                out[3] = (UINT8)((rowsV[a][x >> 1] + rowsV[b][x >> 1] + 1) >> 1);
+            }
+            break;
+
+        case FTPRO_PIXEL_RGB24:
+        case FTPRO_PIXEL_BGRA:
+        {
+            UINT8* rgba = rgb.data();
+            UINT8* rgbb = rgba + (size_t)height * bytes;
+            if (bytes == 3)
+            {
+                kernels.rgb24(ya, rowsU[a], rowsV[a], rgba, 0, height);
+                kernels.rgb24(yb, rowsU[b], rowsV[b], rgbb, 0, height);
+            }
+            else
+            {
+                kernels.bgra(ya, rowsU[a], rowsV[a], rgba, 0, height);
+                kernels.bgra(yb, rowsU[b], rowsV[b], rgbb, 0, height);
+            }
+            for (int x = 0; x < height; x++)
+            {
+                UINT8* out = data + ((size_t)(mirrory ? height - 1 - x : x) * width + column) * bytes;
+                memcpy(out, rgba + (size_t)x * bytes, bytes);
+                memcpy(out + bytes, rgbb + (size_t)x * bytes, bytes);
+            }
+            break;
+        }
+        }
+    }
+}
+
+void ftProPackStrip(const ftProImage& image, int y0, int lines,
+    unsigned char* const* rowsY, unsigned char* const* rowsU, unsigned char* const* rowsV)
+{
+    const ftProPackKernels& kernels = GetPackKernels();
+
+    // The chroma of I420/NV12 and of the transposed orientations is read
+    // from line pairs, an odd strip would be read beyond its last row
+    if ((lines & 1) || (y0 & 1))
+    {
+        return;
+    }
+
+    if (ftProOrientationTransposes(image.orientation))
+    {
+        PackStripTransposed(image, y0, lines, rowsY, rowsU, rowsV);
+        return;
+    }
+
+    int width = image.width;
+    int height = image.height;
+    int cwidth = width / 2;
+    size_t lumasize = (size_t)width * height;
+    UINT8* data = image.data;
+    bool fliprows = image.orientation == FTPRO_ORIENT_FLIP_H || image.orientation == FTPRO_ORIENT_ROT180;
+    bool flipcolumns = image.orientation == FTPRO_ORIENT_FLIP_V || image.orientation == FTPRO_ORIENT_ROT180;
+
+    // Reversed rows of the strip
+    static thread_local std::vector<UINT8> reversed;
+    static thread_local std::vector<unsigned char*> reversedrows;
+    if (fliprows)
+    {
+        reversed.resize((size_t)lines * width * 2);
+        reversedrows.resize((size_t)lines * 3);
+        UINT8* pos = reversed.data();
+        for (int line = 0; line < lines; line++)
+        {
+            reversedrows[line] = pos;
+            kernels.reverse(rowsY[line], pos, 0, width);
+            pos += width;
+            reversedrows[lines + line] = pos;
+            kernels.reverse(rowsU[line], pos, 0, cwidth);
+            pos += cwidth;
+            reversedrows[2 * lines + line] = pos;
+            kernels.reverse(rowsV[line], pos, 0, cwidth);
+            pos += cwidth;
+        }
+        rowsY = reversedrows.data();
+        rowsU = rowsY + lines;
+        rowsV = rowsU + lines;
+    }
+
+    // Output row of a strip line and output chroma row of a line pair
+    int row0 = flipcolumns ? height - 1 - y0 : y0;
+    int rowstep = flipcolumns ? -1 : 1;
+    int crow0 = flipcolumns ? (height - 2 - y0) / 2 : y0 / 2;
+
+    switch (image.format)
+    {
+    case FTPRO_PIXEL_YUYV:
+        for (int line = 0; line < lines; line++)
+        {
+            kernels.yuyv(rowsY[line], rowsU[line], rowsV[line], data + (size_t)(row0 + rowstep * line) * width * 2, 0, width);
+        }
+        break;
+
+    case FTPRO_PIXEL_GRAY8:
+        for (int line = 0; line < lines; line++)
+        {
+            memcpy(data + (size_t)(row0 + rowstep * line) * width, rowsY[line], width);
+        }
+        break;
+
+    case FTPRO_PIXEL_I420:
+        for (int line = 0; line < lines; line++)
+        {
+            memcpy(data + (size_t)(row0 + rowstep * line) * width, rowsY[line], width);
+        }
+        for (int line = 0; line < lines; line += 2)
+        {
+            size_t offset = (size_t)(crow0 + rowstep * line / 2) * cwidth;
+            kernels.avg(rowsU[line], rowsU[line + 1], data + lumasize + offset, 0, cwidth);
+            kernels.avg(rowsV[line], rowsV[line + 1], data + lumasize + lumasize / 4 + offset, 0, cwidth);
+        }
+        break;
+
+    case FTPRO_PIXEL_NV12:
+        for (int line = 0; line < lines; line++)
+        {
+            memcpy(data + (size_t)(row0 + rowstep * line) * width, rowsY[line], width);
+        }
+        for (int line = 0; line < lines; line += 2)
+        {
+            size_t offset = (size_t)(crow0 + rowstep * line / 2) * width;
+            kernels.avginterleave(rowsU[line], rowsU[line + 1], rowsV[line], rowsV[line + 1], data + lumasize + offset, 0, cwidth);
+        }
+        break;
+
+    case FTPRO_PIXEL_RGB24:
+        for (int line = 0; line < lines; line++)
+        {
+            kernels.rgb24(rowsY[line], rowsU[line], rowsV[line], data + (size_t)(row0 + rowstep * line) * width * 3, 0, width);
+        }
+        break;
+
+    case FTPRO_PIXEL_BGRA:
+        for (int line = 0; line < lines; line++)
+        {
+            kernels.bgra(rowsY[line], rowsU[line], rowsV[line], data + (size_t)(row0 + rowstep * line) * width * 4, 0, width);
+        }
+        break;
+    }
+}
@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013PixelFormat.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  Output pixel formats of the JPEG decoder and SIMD packers
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013PixelFormat
+//
+// The decoder delivers strips of Y, U and V rows (4:2:2, U and V with half
+// width) as libjpeg raw data. ftProPackStrip writes such a strip directly
+// into the selected output format, so no second pass over the frame is needed.
+//
+// Layout of the formats (W x H pixels, W and H must be even):
+//   FTPRO_PIXEL_YUYV   Y0 U0 Y1 V0 ..., 2*W bytes per row
+//   FTPRO_PIXEL_I420   Y plane W*H, U plane W/2*H/2, V plane W/2*H/2
+//   FTPRO_PIXEL_NV12   Y plane W*H, UV plane (U0 V0 U1 V1 ...) W*H/2
+//   FTPRO_PIXEL_RGB24  R G B, 3*W bytes per row
+//   FTPRO_PIXEL_BGRA   B G R 255, 4*W bytes per row (Windows DIB order)
+//   FTPRO_PIXEL_GRAY8  Y plane W*H
+//                      (luma only: the decoder skips IDCT and output of Cb and Cr,
+//                      use it for line following and brightness tracking)
+// For I420/NV12 the chroma of two rows is averaged.
+// RGB uses the JFIF equations in 14 bit fixed point, the result differs from
+// libjpeg's own color conversion by at most 1 for R and B and 2 for G.
+// libjpeg's color conversion and upsampling (jdcolor.c, jdsample.c) are not
+// used: the decoder gets raw data, the packers do both.
+//
+// The kernels are selected once at run time: AVX2, SSE2 or plain C.
+//
+// Orientation (mounted camera): ftProPackStrip writes each row of the strip
+// directly to its place in the rotated or flipped image, there is no second
+// pass over the frame. The image size is the size after the orientation,
+// i.e. width and height of the frame are swapped for the transposing ones
+// (TRANSPOSE, TRANSVERSE, ROT90, ROT270). For these the chroma of two source
+// rows is averaged for YUYV, I420 and NV12, because it becomes horizontal.
+// The order of ftProOrientation is that of JXFORM_CODE in transupp.h.
+//
+// see also: ftProJpegDecoder::Decode
+//
+// Changes: 2026-10-19
+//          First version
+//          Orientation (rotate and flip) while packing
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection 
+#if(!defined(ftProInterface2013PixelFormat_H))
+#define ftProInterface2013PixelFormat_H
+
+#include <stddef.h>
+
+enum ftProPixelFormat
+{
+	FTPRO_PIXEL_YUYV = 0,
+	FTPRO_PIXEL_I420,
+	FTPRO_PIXEL_NV12,
+	FTPRO_PIXEL_RGB24,
+	FTPRO_PIXEL_BGRA,
+	FTPRO_PIXEL_GRAY8
+};
+
+enum ftProOrientation
+{
+	FTPRO_ORIENT_NONE = 0,
+	FTPRO_ORIENT_FLIP_H,      // mirror left - right
+	FTPRO_ORIENT_FLIP_V,      // mirror top - bottom
+	FTPRO_ORIENT_TRANSPOSE,   // mirror at the top left to bottom right diagonal
+	FTPRO_ORIENT_TRANSVERSE,  // mirror at the top right to bottom left diagonal
+	FTPRO_ORIENT_ROT90,       // rotate clockwise
+	FTPRO_ORIENT_ROT180,
+	FTPRO_ORIENT_ROT270
+};
+
+// Width and height are swapped by the orientation
+inline bool ftProOrientationTransposes(int orientation)
+{
+	return orientation == FTPRO_ORIENT_TRANSPOSE || orientation == FTPRO_ORIENT_TRANSVERSE ||
+		orientation == FTPRO_ORIENT_ROT90 || orientation == FTPRO_ORIENT_ROT270;
+}
+
+// CPU features, see ftProGetCpuFeatures
+#define FTPRO_CPU_SSE2   0x01
+#define FTPRO_CPU_SSSE3  0x02
+#define FTPRO_CPU_SSE41  0x04
+#define FTPRO_CPU_AVX2   0x08
+
+// Features of the CPU which are used by the SIMD kernels
+int ftProGetCpuFeatures();
+// Restrict the used features, e.g. 0 to compare with the plain C kernels.
+// Must be called before the first decode.
+void ftProLimitCpuFeatures(int mask);
+
+// Size of an image in bytes, 0 for an unknown format or odd sizes
+size_t ftProPixelFormatSize(int format, int width, int height);
+
+// Description of the output image
+struct ftProImage
+{
+	int format;           // ftProPixelFormat
+	int width;
+	int height;
+	unsigned char* data;  // ftProPixelFormatSize bytes
+	int orientation;      // ftProOrientation of the strips given to ftProPackStrip
+};
+
+// Write rows y0 .. y0+lines-1 of an image from a strip of raw rows
+// (y0 and lines even, otherwise nothing is written; rowsU/rowsV have
+// width/2 samples). The rows are those of the frame before the
+// orientation is applied.
+void ftProPackStrip(const ftProImage& image, int y0, int lines,
+	unsigned char* const* rowsY, unsigned char* const* rowsU, unsigned char* const* rowsV);
+
+#endif // ftProInterface2013PixelFormat_H
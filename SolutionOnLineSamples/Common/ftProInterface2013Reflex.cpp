@@ -0,0 +1,202 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013Reflex.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  In-cycle reflex rules (input to output reactions)
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013Reflex
+//
+// All compare operators are compiled into an inclusive range [lo, hi] and a
+// flag whether the value must be inside or outside, e.g. LT v is [-32768, v-1]
+// and NE v is outside [v, v]. The outputs are resolved into one or two duty
+// pointers with their values, so a rule costs a compare and two stores per cycle.
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C" {
+#include "common.h"
+
+#ifdef WIN32
+    typedef unsigned long       UINT32;
+#endif
+
+#include "FtShmemTxt.h"
+}
+
+#include "ftProInterface2013Reflex.h"
+
+ftIF2013ReflexEngine::ftIF2013ReflexEngine() :
+    m_count(0)
+{
+    for (int i = 0; i < MaxTables; i++)
+    {
+        m_tables[i].active = false;
+        m_tables[i].latched = 0;
+        m_tables[i].triggered = 0;
+    }
+}
+
+bool ftIF2013ReflexEngine::Compile(const ftIF2013ReflexRule& rule, UINT32 bit, FISH_X1_TRANSFER* transferarea, int nAreas, Op* op)
+{
+    if (rule.area < 0 || rule.area >= nAreas || rule.outarea < 0 || rule.outarea >= nAreas)
+    {
+        return false;
+    }
+
+    FTX1_INPUT* in = &transferarea[rule.area].ftX1in;
+    switch (rule.source)
+    {
+    case FTIF2013_REFLEX_UNI:
+        if (rule.input < 0 || rule.input >= IZ_UNI_INPUT) return false;
+        op->input = &in->uni[rule.input];
+        break;
+    case FTIF2013_REFLEX_CNT_IN:
+        if (rule.input < 0 || rule.input >= IZ_COUNTER) return false;
+        op->input = &in->cnt_in[rule.input];
+        break;
+    case FTIF2013_REFLEX_COUNTER:
+        if (rule.input < 0 || rule.input >= IZ_COUNTER) return false;
+        op->input = &in->counter[rule.input];
+        break;
+    default:
+        return false;
+    }
+
+    INT32 value = rule.value;
+    op->inside = true;
+    switch (rule.compare)
+    {
+    case FTIF2013_REFLEX_EQ: op->lo = value;  op->hi = value; break;
+    case FTIF2013_REFLEX_NE: op->lo = value;  op->hi = value; op->inside = false; break;
+    case FTIF2013_REFLEX_LT: op->lo = -32768; op->hi = value - 1; break;
+    case FTIF2013_REFLEX_LE: op->lo = -32768; op->hi = value; break;
+    case FTIF2013_REFLEX_GT: op->lo = value + 1; op->hi = 32767; break;
+    case FTIF2013_REFLEX_GE: op->lo = value;  op->hi = 32767; break;
+    default:
+        return false;
+    }
+
+    FTX1_OUTPUT* out = &transferarea[rule.outarea].ftX1out;
+    switch (rule.action)
+    {
+    case FTIF2013_REFLEX_SET_OUTPUT:
+        if (rule.output < 0 || rule.output >= IZ_PWM_CHAN || rule.outvalue < 0 || rule.outvalue > 512) return false;
+        op->nout = 1;
+        op->out[0] = &out->duty[rule.output];
+        op->value[0] = rule.outvalue;
+        op->out[1] = nullptr;
+        op->value[1] = 0;
+        break;
+    case FTIF2013_REFLEX_SET_MOTOR:
+        if (rule.output < 0 || rule.output >= IZ_MOTOR || rule.outvalue < -512 || rule.outvalue > 512) return false;
+        op->nout = 2;
+        op->out[0] = &out->duty[2 * rule.output];
+        op->value[0] = (rule.outvalue > 0) ? rule.outvalue : 0;
+        op->out[1] = &out->duty[2 * rule.output + 1];
+        op->value[1] = (rule.outvalue < 0) ? -rule.outvalue : 0;
+        break;
+    default:
+        return false;
+    }
+
+    op->latch = rule.latch;
+    op->bit = bit;
+    return true;
+}
+
+int ftIF2013ReflexEngine::Add(const ftIF2013ReflexRule* rules, int count, FISH_X1_TRANSFER* transferarea, int nAreas)
+{
+    if (rules == nullptr || count <= 0 || count > MaxRules)
+    {
+        return -1;
+    }
+
+    // Compile outside of the lock, the TA communication thread isn't blocked
+    std::vector<Op> program(count);
+    for (int i = 0; i < count; i++)
+    {
+        if (!Compile(rules[i], 1UL << i, transferarea, nAreas, &program[i])) return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int id = 0; id < MaxTables; id++)
+    {
+        Table* table = &m_tables[id];
+        if (!table->active)
+        {
+            table->program.swap(program);
+            table->latched = 0;
+            table->triggered = 0;
+            table->active = true;
+            m_count++;
+            return id;
+        }
+    }
+    return -1;
+}
+
+bool ftIF2013ReflexEngine::Remove(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxTables || !m_tables[id].active) return false;
+
+    m_tables[id].active = false;
+    m_tables[id].program.clear();
+    m_count--;
+    return true;
+}
+
+bool ftIF2013ReflexEngine::Reset(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxTables || !m_tables[id].active) return false;
+
+    m_tables[id].latched = 0;
+    return true;
+}
+
+UINT32 ftIF2013ReflexEngine::GetTriggered(int id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (id < 0 || id >= MaxTables || !m_tables[id].active) return 0;
+
+    return m_tables[id].triggered | m_tables[id].latched;
+}
+
+void ftIF2013ReflexEngine::Process()
+{
+    if (m_count == 0) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int id = 0; id < MaxTables; id++)
+    {
+        Table* table = &m_tables[id];
+        if (!table->active) continue;
+
+        UINT32 triggered = 0;
+        const Op* end = table->program.data() + table->program.size();
+        for (const Op* op = table->program.data(); op < end; op++)
+        {
+            INT32 value = *op->input;
+            bool match = ((value >= op->lo && value <= op->hi) == op->inside);
+            if (match)
+            {
+                triggered |= op->bit;
+                if (op->latch) table->latched |= op->bit;
+            }
+            else if (!(table->latched & op->bit))
+            {
+                continue;
+            }
+            *op->out[0] = op->value[0];
+            if (op->nout > 1) *op->out[1] = op->value[1];
+        }
+        table->triggered = triggered;
+    }
+}
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013Reflex.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  In-cycle reflex rules (input to output reactions)
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013Reflex
+//
+// A reflex rule is "if input <compare> value then set output", e.g.
+//
+//   { ShmIfId_TXT::LOCAL_IO, FTIF2013_REFLEX_UNI, 0, FTIF2013_REFLEX_EQ, 1,
+//     ShmIfId_TXT::LOCAL_IO, FTIF2013_REFLEX_SET_MOTOR, 0, 0, true }
+//
+// stops M1 as soon as the switch on I1 closes. A table of rules is compiled
+// once, when it is added, into a flat program with pointers into the
+// transfer area and an inclusive value range per condition. The TA
+// communication thread runs the program after input decode, after the PID
+// controllers and motion profiles, so a reaction overrides their duty and is
+// sent with the very next transfer.
+//
+// A rule without latch acts while its condition is true. A latched rule keeps
+// its output after the first match until ResetReflexRules is called.
+//
+// see also: ftIF2013TransferAreaComHandlerEx::AddReflexRules
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection 
+#if(!defined(ftProInterface2013Reflex_H))
+#define ftProInterface2013Reflex_H
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+extern "C" {
+#include "common.h"
+}
+// The transfer area, see FtShmemTxt.h
+// (not included here, because it needs UINT32 from windows.h)
+typedef struct shm_if_s FISH_X1_TRANSFER;
+
+/*!
+ * @brief Input of a condition
+ */
+enum ftIF2013ReflexSource
+{
+	FTIF2013_REFLEX_UNI = 0,  // universal input I1..I8 (input=0..7)
+	FTIF2013_REFLEX_CNT_IN,   // logic state of counter input C1..C4 (input=0..3)
+	FTIF2013_REFLEX_COUNTER   // counter value C1..C4 (input=0..3)
+};
+
+enum ftIF2013ReflexCompare
+{
+	FTIF2013_REFLEX_EQ = 0,
+	FTIF2013_REFLEX_NE,
+	FTIF2013_REFLEX_LT,
+	FTIF2013_REFLEX_LE,
+	FTIF2013_REFLEX_GT,
+	FTIF2013_REFLEX_GE
+};
+
+enum ftIF2013ReflexAction
+{
+	FTIF2013_REFLEX_SET_OUTPUT = 0, // duty[output] = outvalue, output O1..O8 (0..7), 0..512
+	FTIF2013_REFLEX_SET_MOTOR       // motor M1..M4 (output=0..3), outvalue -512..512, 0 = stop
+};
+
+/*!
+ * @brief One rule: if input <compare> value then action
+ */
+struct ftIF2013ReflexRule
+{
+	int   area;     // ShmIfId_TXT of the input
+	int   source;   // ftIF2013ReflexSource
+	int   input;
+	int   compare;  // ftIF2013ReflexCompare
+	INT16 value;
+	int   outarea;  // ShmIfId_TXT of the output
+	int   action;   // ftIF2013ReflexAction
+	int   output;
+	INT16 outvalue;
+	bool  latch;    // keep the output after the first match
+};
+
+/*!
+ * @brief Fixed number of compiled rule tables, see the module description
+ */
+class ftIF2013ReflexEngine
+{
+public:
+	enum { MaxTables = 8, MaxRules = 32 };
+
+	ftIF2013ReflexEngine();
+
+	/*!
+	 * @brief Compile and add a table of rules
+	 * @return id of the table, -1 if a rule is wrong or all tables are in use
+	 */
+	int Add(const ftIF2013ReflexRule* rules, int count, FISH_X1_TRANSFER* transferarea, int nAreas);
+	bool Remove(int id);
+	/*!
+	 * @brief Release the latched rules of a table
+	 */
+	bool Reset(int id);
+	/*!
+	 * @return bit n is set if rule n matched in the last cycle or is latched
+	 */
+	UINT32 GetTriggered(int id);
+
+	/*!
+	 * @brief Run the program, called by the TA communication thread after decode
+	 */
+	void Process();
+
+protected:
+	// A compiled rule
+	struct Op
+	{
+		const INT16* input;
+		INT32  lo, hi;      // condition: (lo <= *input <= hi) == inside
+		bool   inside;
+		INT16* out[2];
+		INT16  value[2];
+		int    nout;
+		bool   latch;
+		UINT32 bit;
+	};
+	struct Table
+	{
+		bool   active;
+		UINT32 latched;
+		UINT32 triggered;
+		std::vector<Op> program;
+	};
+	bool Compile(const ftIF2013ReflexRule& rule, UINT32 bit, FISH_X1_TRANSFER* transferarea, int nAreas, Op* op);
+
+	std::mutex m_mutex;
+	std::atomic<int> m_count; // number of active tables, so an idle engine costs nothing
+	Table m_tables[MaxTables];
+};
+
+#endif // ftProInterface2013Reflex_H
@@ -39,6 +39,17 @@
 //          Add check in destructor to avoid double EndTransver
 // Changes: 2020-06-28 C.van Leeuwen, Copyright (C) 2020
 //          Add TA communication Thread          
+// Changes: 2026-10-19
+//          Add command helpers and cycle waiters (awaitables) which are
+//          resumed by the TA communication thread after each transfer
+//          Add cycle synchronous waits (WaitForNextCycle, WaitForInputChange, WaitForAny)
+//          Run the PID controller engine in the TA communication thread
+//          Run the motion profile engine in the TA communication thread
+//          Run the reflex rules in the TA communication thread
+//          Add GetCameraFrame with pooled, reference counted frame buffers
+//          Add camera frame info and camera link statistics (GetCameraStats)
+//          StopCamera shuts the camera socket down and waits for a receive in
+//          another thread before the socket is closed and the buffer freed
 ///////////////////////////////////////////////////////////////////////////////
 
 #define _CRT_SECURE_NO_WARNINGS
@@ -49,6 +60,7 @@
 #include <ws2tcpip.h>
 #include <memory.h>
 #include <time.h>
+#include <math.h>
 #include <thread>
 #include <type_traits>
 #include <chrono>
@@ -207,7 +219,13 @@ ftIF2013TransferAreaComHandler::ftIF2013TransferAreaComHandler( FISH_X1_TRANSFER
     m_camerastarted( false ),
     m_camerasocket( INVALID_SOCKET ),
     m_camerabuffersize( 0 ),
-    m_camerabuffer( 0 )
+    m_camerabuffer( 0 ),
+    m_framepool( 0 ),
+    m_framepoolcount( 4 ),
+    m_cameraframecount( 0 ),
+    m_cameradropped( 0 ),
+    m_camerasamplecount( 0 ),
+    m_cameraserverdropped( 0 )
 {
 #ifdef TEST
     cout << "ftIF2013TransferAreaComHandler start" << endl;
@@ -232,6 +250,7 @@ ftIF2013TransferAreaComHandler::~ftIF2013TransferAreaComHandler()
 {
     cout << "ftIF2013TransferAreaComHandler: destructor " << endl;
     if (m_online) EndTransfer();
+    delete m_framepool;
     int tt= WSACleanup();
     cout << "ftIF2013TransferAreaComHandler: destructor clean up socket2 ="<<tt << endl;
 }
@@ -832,8 +851,21 @@ bool ftIF2013TransferAreaComHandler::StartCamera( int width, int height, int fra
         return false;
     }
 
-    m_camerabuffersize = width*height+1024;
-    m_camerabuffer = new unsigned char[m_camerabuffersize];
+    {
+        std::lock_guard<std::mutex> lock( m_camerareceivemutex );
+        delete [] m_camerabuffer;
+        m_camerabuffersize = width*height+1024;
+        m_camerabuffer = new unsigned char[m_camerabuffersize];
+    }
+    m_cameraframecount = 0;
+    m_cameradropped = 0;
+    m_camerainfo.Reset();
+    {
+        std::lock_guard<std::mutex> lock( m_camerastatsmutex );
+        m_camerasamplecount = 0;
+        m_cameraserverdropped = 0;
+        m_cameraacktime = std::chrono::steady_clock::time_point();
+    }
     if( !m_camerabuffer )
     {
         m_camerabuffersize = 0;
@@ -859,8 +891,12 @@ bool ftIF2013TransferAreaComHandler::StartCamera( int width, int height, int fra
     }
 
     // Open camera socket
-    m_camerasocket = OpenSocket( port );
-    if( m_camerasocket == INVALID_SOCKET )
+    SOCKET camerasocket = OpenSocket( port );
+    {
+        std::lock_guard<std::mutex> lock( m_camerareceivemutex );
+        m_camerasocket = camerasocket;
+    }
+    if( camerasocket == INVALID_SOCKET )
     {
         cerr << "StartCamera: Cannot open camera socket" << endl;
         return false;
@@ -880,8 +916,17 @@ void ftIF2013TransferAreaComHandler::StopCamera()
 
     m_camerastarted = false;
 
-    closesocket(m_camerasocket);
-    m_camerasocket = INVALID_SOCKET;
+    // A receive in another thread (e.g. ftIF2013CameraPipeline) fails after the
+    // shutdown, wait until it has left before the socket and buffer are freed
+    shutdown( m_camerasocket, SD_BOTH );
+    {
+        std::lock_guard<std::mutex> lock( m_camerareceivemutex );
+        closesocket(m_camerasocket);
+        m_camerasocket = INVALID_SOCKET;
+        delete [] m_camerabuffer;
+        m_camerabuffer = 0;
+        m_camerabuffersize = 0;
+    }
 
     ftIF2013Command_StopCameraOnline command;
     memset( &command, 0, sizeof(command) );
@@ -889,21 +934,15 @@ void ftIF2013TransferAreaComHandler::StopCamera()
 	cerr << "Before SendCommand: ftIF2013CommandId_StopCameraOnline" << endl;
 
     ftIF2013Response_StopCameraOnline response;
-    if( !SendCommand( m_socket, &command, sizeof(command), ftIF2013ResponseId::ftIF2013ResponseId_StopCameraOnline, &response, sizeof(response) ) )
-    {
-        return;
-    }
-
-    delete [] m_camerabuffer;
-    m_camerabuffersize = 0;
+    SendCommand( m_socket, &command, sizeof(command), ftIF2013ResponseId::ftIF2013ResponseId_StopCameraOnline, &response, sizeof(response) );
 }
 
-bool ftIF2013TransferAreaComHandler::GetCameraFrameJpeg( unsigned char **buffer, size_t *buffersize )
+// Receive the header of the next camera frame
+bool ftIF2013TransferAreaComHandler::ReceiveCameraFrameHeader( size_t *framesize )
 {
     int result;
 
-    *buffer = 0;
-    *buffersize = 0;
+    *framesize = 0;
 
     // Read frame header
     ftIF2013Response_CameraOnlineFrame response;
@@ -920,38 +959,39 @@ bool ftIF2013TransferAreaComHandler::GetCameraFrameJpeg( unsigned char **buffer,
         return false;
     }
 
-    // Read frame body
-    {
-        // Check compressed buffers size and reallocate if needed
-        if( m_camerabuffersize<(size_t)response.m_framesizecompressed )
-        {
-            delete [] m_camerabuffer;
-            m_camerabuffersize = 2*response.m_framesizecompressed;
-            m_camerabuffer = new unsigned char[m_camerabuffersize];
-            if( !m_camerabuffer )
-            {
-                m_camerabuffersize = 0;
-                cerr << "GetCameraFrameJpeg: Cannot enlarge camera buffer" << endl;
-                return false;
-            }
-        }
+    *framesize = response.m_framesizecompressed;
+
+    m_camerainfo.m_sequence = m_cameraframecount;
+    m_camerainfo.m_framenumber = response.m_numframeready;
+    m_camerainfo.m_width = response.m_framewidth;
+    m_camerainfo.m_height = response.m_frameheight;
+    m_camerainfo.m_sizeraw = response.m_framesizeraw;
+    m_camerainfo.m_sizecompressed = response.m_framesizecompressed;
+    m_camerainfo.m_headertime = std::chrono::steady_clock::now();
+    m_camerainfo.m_received = m_camerainfo.m_headertime;
+    return true;
+}
 
-        // Read compressed frame
-        size_t nRead=0;
-        size_t framesize = response.m_framesizecompressed;
-        unsigned char *pos = m_camerabuffer;
-        while( nRead < framesize )
+// Receive the body of a camera frame and acknowledge it
+bool ftIF2013TransferAreaComHandler::ReceiveCameraFrameData( unsigned char *buffer, size_t framesize, bool dropped )
+{
+    int result;
+
+    // Read compressed frame
+    size_t nRead=0;
+    unsigned char *pos = buffer;
+    while( nRead < framesize )
+    {
+        result = recv( m_camerasocket, (char*)pos, framesize-nRead, 0);
+        if( result <=0 )
         {
-            result = recv( m_camerasocket, (char*)pos, framesize-nRead, 0);
-            if( result <=0 )
-            {
-                cerr << "GetCameraFrameJpeg: Error reading frame data" << endl;
-                return false;
-            }
-            nRead += result;
-            pos += result;
+            cerr << "GetCameraFrameJpeg: Error reading frame data" << endl;
+            return false;
         }
+        nRead += result;
+        pos += result;
     }
+    m_camerainfo.m_received = std::chrono::steady_clock::now();
 
     // Send Acknowledge
     ftIF2013Acknowledge_CameraOnlineFrame ack;
@@ -964,9 +1004,223 @@ bool ftIF2013TransferAreaComHandler::GetCameraFrameJpeg( unsigned char **buffer,
         return false;
     }
 
+    m_cameraframecount++;
+    AddCameraSample( dropped );
+    return true;
+}
+
+// Add the last frame (m_camerainfo) to the camera statistics
+void ftIF2013TransferAreaComHandler::AddCameraSample( bool dropped )
+{
+    std::chrono::steady_clock::time_point acktime = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock( m_camerastatsmutex );
+
+    if( m_camerasamplecount > 0 )
+    {
+        // m_numframeready counts the frames of the camera server
+        const CameraSample &prev = m_camerasamples[(m_camerasamplecount-1) % CameraStatsWindow];
+        INT32 gap = m_camerainfo.m_framenumber - prev.m_framenumber;
+        if( gap > 1 )
+        {
+            m_cameraserverdropped += gap-1;
+        }
+    }
+
+    if( dropped )
+    {
+        m_cameradropped++;
+    }
+
+    CameraSample &sample = m_camerasamples[m_camerasamplecount % CameraStatsWindow];
+    sample.m_headertime = m_camerainfo.m_headertime;
+    sample.m_bytes = m_camerainfo.m_sizecompressed;
+    sample.m_framenumber = m_camerainfo.m_framenumber;
+    sample.m_dropped = dropped;
+    sample.m_receivetime = std::chrono::duration_cast<std::chrono::microseconds>( m_camerainfo.m_received - m_camerainfo.m_headertime ).count();
+    sample.m_ackroundtrip = -1;
+    if( m_camerasamplecount > 0 )
+    {
+        sample.m_ackroundtrip = std::chrono::duration_cast<std::chrono::microseconds>( m_camerainfo.m_headertime - m_cameraacktime ).count();
+    }
+    m_cameraacktime = acktime;
+    m_camerasamplecount++;
+}
+
+void ftIF2013TransferAreaComHandler::GetCameraStats( ftIF2013CameraStats *stats )
+{
+    memset( stats, 0, sizeof(*stats) );
+
+    std::lock_guard<std::mutex> lock( m_camerastatsmutex );
+    stats->m_frames = m_camerasamplecount;
+    stats->m_pooldropped = m_cameradropped;
+    stats->m_serverdropped = m_cameraserverdropped;
+
+    int count = m_camerasamplecount < CameraStatsWindow ? m_camerasamplecount : CameraStatsWindow;
+    if( count == 0 )
+    {
+        return;
+    }
+    int first = m_camerasamplecount - count;
+
+    // Sums over the window, intervals and gaps are counted from the second sample on
+    double bytes = 0, receivetime = 0, ackroundtrip = 0, interval = 0, interval2 = 0, intervalmax = 0;
+    int acks = 0, dropped = 0, gaps = 0;
+    for( int i=first; i<m_camerasamplecount; i++ )
+    {
+        const CameraSample &sample = m_camerasamples[i % CameraStatsWindow];
+        receivetime += sample.m_receivetime;
+        if( sample.m_dropped )
+        {
+            dropped++;
+        }
+        if( i == first )
+        {
+            continue;
+        }
+
+        const CameraSample &prev = m_camerasamples[(i-1) % CameraStatsWindow];
+        double gap = std::chrono::duration<double, std::milli>( sample.m_headertime - prev.m_headertime ).count();
+        interval += gap;
+        interval2 += gap*gap;
+        if( gap > intervalmax )
+        {
+            intervalmax = gap;
+        }
+        bytes += sample.m_bytes;
+        if( sample.m_framenumber - prev.m_framenumber > 1 )
+        {
+            gaps += sample.m_framenumber - prev.m_framenumber - 1;
+        }
+        if( sample.m_ackroundtrip >= 0 )
+        {
+            ackroundtrip += sample.m_ackroundtrip;
+            acks++;
+        }
+    }
+
+    stats->m_receivetime = receivetime / 1000.0 / count;
+    stats->m_droprate = (double)(dropped + gaps) / (count + gaps);
+    if( acks )
+    {
+        stats->m_ackroundtrip = ackroundtrip / 1000.0 / acks;
+    }
+    if( count > 1 && interval > 0 )
+    {
+        double mean = interval / (count-1);
+        double variance = interval2 / (count-1) - mean*mean;
+        stats->m_fps = 1000.0 / mean;
+        stats->m_bytespersec = bytes * 1000.0 / interval;
+        stats->m_interval = mean;
+        stats->m_jitter = variance > 0 ? sqrt( variance ) : 0;
+        stats->m_intervalmax = intervalmax;
+    }
+}
+
+// Make sure m_camerabuffer can hold framesize bytes
+bool ftIF2013TransferAreaComHandler::ReserveCameraBuffer( size_t framesize )
+{
+    // Check compressed buffers size and reallocate if needed
+    if( m_camerabuffersize<framesize )
+    {
+        delete [] m_camerabuffer;
+        m_camerabuffersize = 2*framesize;
+        m_camerabuffer = new unsigned char[m_camerabuffersize];
+        if( !m_camerabuffer )
+        {
+            m_camerabuffersize = 0;
+            cerr << "GetCameraFrameJpeg: Cannot enlarge camera buffer" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ftIF2013TransferAreaComHandler::GetCameraFrameJpeg( unsigned char **buffer, size_t *buffersize )
+{
+    *buffer = 0;
+    *buffersize = 0;
+
+    std::lock_guard<std::mutex> lock( m_camerareceivemutex );
+    if( m_camerasocket == INVALID_SOCKET )
+    {
+        return false;
+    }
+
+    size_t framesize;
+    if( !ReceiveCameraFrameHeader( &framesize ) )
+    {
+        return false;
+    }
+
+    // Read frame body
+    if( !ReserveCameraBuffer( framesize ) || !ReceiveCameraFrameData( m_camerabuffer, framesize ) )
+    {
+        return false;
+    }
+
     // return results
     *buffer = m_camerabuffer;
-    *buffersize = response.m_framesizecompressed;
+    *buffersize = framesize;
+    return true;
+}
+
+bool ftIF2013TransferAreaComHandler::GetCameraFrame( ftIF2013FrameHandle *frame )
+{
+    frame->Reset();
+
+    std::lock_guard<std::mutex> lock( m_camerareceivemutex );
+    if( m_camerasocket == INVALID_SOCKET )
+    {
+        return false;
+    }
+
+    size_t framesize;
+    if( !ReceiveCameraFrameHeader( &framesize ) )
+    {
+        return false;
+    }
+
+    if( !m_framepool )
+    {
+        // The frames grow if needed, so the pool is kept for the next StartCamera
+        m_framepool = new ftIF2013FramePool( m_framepoolcount, m_camerabuffersize );
+    }
+    ftIF2013FrameHandle received = m_framepool->Acquire( framesize );
+    if( !received )
+    {
+        // All frames are in use: the frame must still be read from the socket
+        // (counted in m_cameradropped)
+        return ReserveCameraBuffer( framesize ) && ReceiveCameraFrameData( m_camerabuffer, framesize, true );
+    }
+
+    if( !ReceiveCameraFrameData( received.GetData(), framesize ) )
+    {
+        return false;
+    }
+
+    received.GetFrame()->m_info = m_camerainfo;
+    *frame = std::move( received );
+    return true;
+}
+
+bool ftIF2013TransferAreaComHandler::SetCameraFramePool( int count )
+{
+    if( count < 1 )
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock( m_camerareceivemutex );
+    if( m_framepool )
+    {
+        if( m_framepool->GetFreeCount() != m_framepool->GetCount() )
+        {
+            cerr << "SetCameraFramePool: Frames are still in use" << endl;
+            return false;
+        }
+        delete m_framepool;
+        m_framepool = 0;
+    }
+    m_framepoolcount = count;
     return true;
 }
 
@@ -1136,16 +1390,23 @@ void ftIF2013TransferAreaComHandlerEx::thread_TAcommunication(std::future<void>
 #endif	
     while (!stop && futureObj.wait_for(std::chrono::milliseconds(1)) == std::future_status::timeout)
     {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
         if (!this->DoTransfer())
         {
             cerr << "thread_TAcommunication: Error DoTransfer break" << endl;	stop = true;
         }
+        else
+        {
 #ifdef TEST
-        else cout << "thread_TAcommunication:Transfer " << stop << endl;
+            cout << "thread_TAcommunication:Transfer " << stop << endl;
 #endif	
+            AddCycleSample(start);
+            ProcessCycle();
+        }
         //DoTransfer will wait for 10 msec between two transfers.
         std::this_thread::sleep_for(std::chrono::milliseconds(7)); // Sleep for a little to prevent blocking
     }
+    SignalCycle(true);
     std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 
     this->EndTransfer();
 #ifdef TEST	
@@ -1162,6 +1423,15 @@ int ftIF2013TransferAreaComHandlerEx::TaComThreadStart() {
         std::cout << "TaComThreadStart: TA communication thread is already running." << std::endl;
         return 1; }; 
    this->futureObj = (this->exitSignal.get_future());
+   {
+       std::lock_guard<std::mutex> lock(m_cyclemutex);
+       m_cyclestopped = false;
+   }
+   m_lastcycle = std::chrono::steady_clock::time_point();
+   {
+       std::lock_guard<std::mutex> lock(m_cyclestatsmutex);
+       m_cyclesamplecount = 0;
+   }
  
     // Starting Thread & move the future object in lambda function by reference
     //https://stackoverflow.com/questions/10673585/start-thread-with-member-function
@@ -1189,6 +1459,411 @@ int ftIF2013TransferAreaComHandlerEx::TaComThreadStop() {
 bool ftIF2013TransferAreaComHandlerEx::TaComThreadIsRunning() {
     return this->thread1.joinable();
 };
+
+void ftIF2013TransferAreaComHandlerEx::AddCycleSample(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(m_cyclestatsmutex);
+
+    CycleSample& sample = m_cyclesamples[m_cyclesamplecount % CycleStatsWindow];
+    sample.m_exchange = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    sample.m_interval = -1;
+    if (m_cyclesamplecount > 0)
+    {
+        sample.m_interval = std::chrono::duration_cast<std::chrono::microseconds>(start - m_cyclestart).count();
+    }
+    m_cyclestart = start;
+    m_cyclesamplecount++;
+}
+
+void ftIF2013TransferAreaComHandlerEx::GetCycleStats(ftIF2013CycleStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    std::lock_guard<std::mutex> lock(m_cyclestatsmutex);
+    stats->m_cycles = m_cyclesamplecount;
+
+    int count = m_cyclesamplecount < CycleStatsWindow ? m_cyclesamplecount : CycleStatsWindow;
+    double exchange = 0, exchangemax = 0, interval = 0;
+    int intervals = 0;
+    for (int i = m_cyclesamplecount - count; i < m_cyclesamplecount; i++)
+    {
+        const CycleSample& sample = m_cyclesamples[i % CycleStatsWindow];
+        exchange += sample.m_exchange;
+        if (sample.m_exchange > exchangemax)
+        {
+            exchangemax = (double)sample.m_exchange;
+        }
+        if (sample.m_interval >= 0)
+        {
+            interval += sample.m_interval;
+            intervals++;
+        }
+    }
+    if (count)
+    {
+        stats->m_exchange = exchange / 1000.0 / count;
+        stats->m_exchangemax = exchangemax / 1000.0;
+    }
+    if (intervals)
+    {
+        stats->m_interval = interval / 1000.0 / intervals;
+    }
+}
+/****************************************************************************/
+/*   ftIF2013TransferAreaComHandlerEx::   Cycle processing                    */
+/****************************************************************************/
+// Runs in the TA communication thread, directly after the inputs of a transfer
+// have been decoded and before the outputs of the next transfer are encoded.
+void ftIF2013TransferAreaComHandlerEx::ProcessCycle()
+{
+    // Time since the previous transfer for the motion profiles, limited so
+    // that a delayed transfer doesn't cause a jump of the set-points
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    float dt = 0.01f;
+    if (m_lastcycle.time_since_epoch().count() != 0)
+    {
+        dt = std::chrono::duration<float>(now - m_lastcycle).count();
+        if (dt < 0.001f) dt = 0.001f;
+        if (dt > 0.05f) dt = 0.05f;
+    }
+    m_lastcycle = now;
+
+    m_pid.Process(m_transferarea);
+    m_motion.Process(m_transferarea, dt);
+    // Last, so a reaction overrides the outputs of the engines above
+    m_reflex.Process();
+    ResumeCycleWaiters();
+    SignalCycle(false);
+}
+
+/****************************************************************************/
+/*   ftIF2013TransferAreaComHandlerEx::   PID controller engine             */
+/****************************************************************************/
+int ftIF2013TransferAreaComHandlerEx::AddPidController(const ftIF2013PidConfig& config)
+{
+    return m_pid.Add(config, m_transferarea, m_nAreas);
+}
+
+bool ftIF2013TransferAreaComHandlerEx::RemovePidController(int id)
+{
+    return m_pid.Remove(id, m_transferarea);
+}
+
+bool ftIF2013TransferAreaComHandlerEx::SetPidSetpoint(int id, INT32 setpoint)
+{
+    return m_pid.SetSetpoint(id, setpoint);
+}
+
+INT32 ftIF2013TransferAreaComHandlerEx::GetPidValue(int id)
+{
+    return m_pid.GetValue(id);
+}
+
+/****************************************************************************/
+/*   ftIF2013TransferAreaComHandlerEx::   Motion profiles                   */
+/****************************************************************************/
+int ftIF2013TransferAreaComHandlerEx::StartMotionProfile(const ftIF2013MotionConfig& config, INT32 distance)
+{
+    return m_motion.Start(config, distance, m_transferarea, m_nAreas);
+}
+
+bool ftIF2013TransferAreaComHandlerEx::IsMotionProfileDone(int id)
+{
+    return m_motion.IsDone(id);
+}
+
+bool ftIF2013TransferAreaComHandlerEx::StopMotionProfile(int id)
+{
+    return m_motion.Stop(id, m_transferarea);
+}
+
+INT32 ftIF2013TransferAreaComHandlerEx::GetMotionProfilePosition(int id)
+{
+    return m_motion.GetPosition(id);
+}
+
+/****************************************************************************/
+/*   ftIF2013TransferAreaComHandlerEx::   Reflex rules                      */
+/****************************************************************************/
+int ftIF2013TransferAreaComHandlerEx::AddReflexRules(const ftIF2013ReflexRule* rules, int count)
+{
+    return m_reflex.Add(rules, count, m_transferarea, m_nAreas);
+}
+
+bool ftIF2013TransferAreaComHandlerEx::RemoveReflexRules(int id)
+{
+    return m_reflex.Remove(id);
+}
+
+bool ftIF2013TransferAreaComHandlerEx::ResetReflexRules(int id)
+{
+    return m_reflex.Reset(id);
+}
+
+UINT32 ftIF2013TransferAreaComHandlerEx::GetReflexTriggered(int id)
+{
+    return m_reflex.GetTriggered(id);
+}
+
+/****************************************************************************/
+/*   ftIF2013TransferAreaComHandlerEx::   Cycle synchronous waits           */
+/****************************************************************************/
+void ftIF2013TransferAreaComHandlerEx::SignalCycle(bool stopped)
+{
+    std::lock_guard<std::mutex> lock(m_cyclemutex);
+    if (!stopped)
+    {
+        // Called by the communication thread between two transfers, so the
+        // inputs don't change while they are copied
+        m_cycleinputs.resize((size_t)m_nAreas * 16);
+        for (int area = 0; area < m_nAreas; area++)
+        {
+            GetInputSnapshot(area, &m_cycleinputs[(size_t)area * 16]);
+        }
+        m_cyclecount++;
+    }
+    m_cyclestopped = stopped;
+    m_cyclecv.notify_all();
+    for (auto& event : m_cycleevents)
+    {
+        if (stopped) break; // only real cycles
+        std::lock_guard<std::mutex> eventlock(event.first->m_mutex);
+        if (event.first->m_signaled < 0) event.first->m_signaled = event.second;
+        event.first->m_cv.notify_all();
+    }
+}
+
+bool ftIF2013TransferAreaComHandlerEx::WaitForNextCycle(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_cyclemutex);
+    UINT32 count = m_cyclecount;
+    m_cyclecv.wait_for(lock, timeout, [&] { return m_cyclecount != count || m_cyclestopped; });
+    return m_cyclecount != count;
+}
+
+void ftIF2013TransferAreaComHandlerEx::GetInputSnapshot(int area, INT16 snapshot[16])
+{
+    FTX1_INPUT* in = &m_transferarea[area].ftX1in;
+    for (int i = 0; i < IZ_UNI_INPUT; i++) snapshot[i] = in->uni[i];
+    for (int i = 0; i < IZ_COUNTER; i++) snapshot[8 + i] = in->cnt_in[i];
+    for (int i = 0; i < IZ_COUNTER; i++) snapshot[12 + i] = in->counter[i];
+}
+
+UINT32 ftIF2013TransferAreaComHandlerEx::WaitForInputChange(UINT32 mask, std::chrono::milliseconds timeout, int area)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::unique_lock<std::mutex> lock(m_cyclemutex);
+    // Compare the copies which SignalCycle takes between two transfers, the
+    // transfer area itself is written by the next transfer without the lock.
+    // Before the first cycle the first one is the reference.
+    bool valid = m_cyclecount != 0;
+    INT16 before[16];
+    if (valid) memcpy(before, &m_cycleinputs[(size_t)area * 16], sizeof(before));
+    while (!m_cyclestopped)
+    {
+        UINT32 count = m_cyclecount;
+        if (!m_cyclecv.wait_until(lock, deadline, [&] { return m_cyclecount != count || m_cyclestopped; }))
+        {
+            break; // timeout
+        }
+        if (m_cyclestopped)
+        {
+            break;
+        }
+        const INT16* after = &m_cycleinputs[(size_t)area * 16];
+        if (!valid)
+        {
+            memcpy(before, after, sizeof(before));
+            valid = true;
+            continue;
+        }
+        UINT32 changed = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            if (before[i] != after[i]) changed |= (1UL << i);
+        }
+        if (changed & mask) return changed & mask;
+    }
+    return 0;
+}
+
+int ftIF2013TransferAreaComHandlerEx::WaitForAny(std::initializer_list<ftIF2013TransferAreaComHandlerEx*> handlers, std::chrono::milliseconds timeout)
+{
+    ftIF2013CycleEvent event;
+    int index = 0;
+    for (auto handler : handlers)
+    {
+        std::lock_guard<std::mutex> lock(handler->m_cyclemutex);
+        handler->m_cycleevents.push_back(std::make_pair(&event, index++));
+    }
+    {
+        std::unique_lock<std::mutex> lock(event.m_mutex);
+        event.m_cv.wait_for(lock, timeout, [&] { return event.m_signaled >= 0; });
+    }
+    for (auto handler : handlers)
+    {
+        std::lock_guard<std::mutex> lock(handler->m_cyclemutex);
+        auto& events = handler->m_cycleevents;
+        for (auto pos = events.begin(); pos != events.end(); ++pos)
+        {
+            if (pos->first == &event) { events.erase(pos); break; }
+        }
+    }
+    // No lock needed any more, the event is not registered anymore
+    return event.m_signaled;
+}
+
+/****************************************************************************/
+/*   ftIF2013TransferAreaComHandlerEx::   Commands and cycle waiters        */
+/****************************************************************************/
+UINT16 ftIF2013TransferAreaComHandlerEx::StartMotorExCmd(int motor, int duty, UINT16 distance, int master, int area)
+{
+    FTX1_OUTPUT* out = &m_transferarea[area].ftX1out;
+    out->duty[2 * motor] = (duty > 0) ? duty : 0;
+    out->duty[2 * motor + 1] = (duty < 0) ? -duty : 0;
+    out->distance[motor] = distance;
+    out->master[motor] = master;
+    m_transferarea[area].ftX1in.motor_ex_reached[motor] = 0;
+    // The command id as last, this starts the command
+    return ++out->motor_ex_cmd_id[motor];
+}
+
+bool ftIF2013TransferAreaComHandlerEx::IsMotorExReady(int motor, int area)
+{
+    return m_transferarea[area].ftX1in.motor_ex_cmd_id[motor] == m_transferarea[area].ftX1out.motor_ex_cmd_id[motor];
+}
+
+UINT16 ftIF2013TransferAreaComHandlerEx::StartCntReset(int counter, int area)
+{
+    m_transferarea[area].ftX1in.cnt_resetted[counter] = 0;
+    return ++m_transferarea[area].ftX1out.cnt_reset_cmd_id[counter];
+}
+
+bool ftIF2013TransferAreaComHandlerEx::IsCntResetReady(int counter, int area)
+{
+    return m_transferarea[area].ftX1in.cnt_reset_cmd_id[counter] == m_transferarea[area].ftX1out.cnt_reset_cmd_id[counter];
+}
+
+UINT16 ftIF2013TransferAreaComHandlerEx::SetSound(int index, int repeat)
+{
+    TXT_SPECIAL_OUTPUTS* out = &m_transferarea[ShmIfId_TXT::LOCAL_IO].sTxtOutputs;
+    out->u16SoundIndex = index;
+    out->u16SoundRepeat = repeat;
+    return ++out->u16SoundCmdId;
+}
+
+bool ftIF2013TransferAreaComHandlerEx::IsSoundReady()
+{
+    return m_transferarea[ShmIfId_TXT::LOCAL_IO].sTxtInputs.u16SoundCmdId == m_transferarea[ShmIfId_TXT::LOCAL_IO].sTxtOutputs.u16SoundCmdId;
+}
+
+static ftIF2013CycleAwaiter MakeAwaiter(ftIF2013TransferAreaComHandlerEx* handler, ftIF2013CycleWaiter::Kind kind, int area, int index, UINT16 cmdid)
+{
+    ftIF2013CycleAwaiter awaiter;
+    memset(&awaiter.m_waiter, 0, sizeof(awaiter.m_waiter));
+    awaiter.m_handler = handler;
+    awaiter.m_waiter.m_kind = kind;
+    awaiter.m_waiter.m_area = area;
+    awaiter.m_waiter.m_index = index;
+    awaiter.m_waiter.m_cmdid = cmdid;
+    return awaiter;
+}
+
+ftIF2013CycleAwaiter ftIF2013TransferAreaComHandlerEx::MotorExAsync(int motor, int duty, UINT16 distance, int master, int area)
+{
+    UINT16 cmdid = StartMotorExCmd(motor, duty, distance, master, area);
+    return MakeAwaiter(this, ftIF2013CycleWaiter::MotorEx, area, motor, cmdid);
+}
+
+ftIF2013CycleAwaiter ftIF2013TransferAreaComHandlerEx::CounterResetAsync(int counter, int area)
+{
+    UINT16 cmdid = StartCntReset(counter, area);
+    return MakeAwaiter(this, ftIF2013CycleWaiter::CounterReset, area, counter, cmdid);
+}
+
+ftIF2013CycleAwaiter ftIF2013TransferAreaComHandlerEx::SoundAsync(int index, int repeat)
+{
+    UINT16 cmdid = SetSound(index, repeat);
+    return MakeAwaiter(this, ftIF2013CycleWaiter::Sound, ShmIfId_TXT::LOCAL_IO, 0, cmdid);
+}
+
+ftIF2013CycleAwaiter ftIF2013TransferAreaComHandlerEx::NextCycle()
+{
+    return MakeAwaiter(this, ftIF2013CycleWaiter::NextCycle, ShmIfId_TXT::LOCAL_IO, 0, 0);
+}
+
+void ftIF2013TransferAreaComHandlerEx::AddCycleWaiter(ftIF2013CycleWaiter* waiter)
+{
+    std::lock_guard<std::mutex> lock(m_waitermutex);
+    waiter->m_next = m_waiters;
+    m_waiters = waiter;
+}
+
+bool ftIF2013TransferAreaComHandlerEx::RemoveCycleWaiter(ftIF2013CycleWaiter* waiter)
+{
+    std::lock_guard<std::mutex> lock(m_waitermutex);
+    for (ftIF2013CycleWaiter** pos = &m_waiters; *pos; pos = &(*pos)->m_next)
+    {
+        if (*pos == waiter)
+        {
+            *pos = waiter->m_next;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ftIF2013TransferAreaComHandlerEx::IsCycleWaiterDone(const ftIF2013CycleWaiter* waiter)
+{
+    FISH_X1_TRANSFER* area = &m_transferarea[waiter->m_area];
+    switch (waiter->m_kind)
+    {
+    case ftIF2013CycleWaiter::MotorEx:      return area->ftX1in.motor_ex_cmd_id[waiter->m_index] == waiter->m_cmdid;
+    case ftIF2013CycleWaiter::CounterReset: return area->ftX1in.cnt_reset_cmd_id[waiter->m_index] == waiter->m_cmdid;
+    case ftIF2013CycleWaiter::Sound:        return area->sTxtInputs.u16SoundCmdId == waiter->m_cmdid;
+    default:                                return false; // NextCycle: only after a transfer
+    }
+}
+
+void ftIF2013TransferAreaComHandlerEx::ResumeCycleWaiters()
+{
+    // Unlink the finished waiters under the lock, resume them without the lock,
+    // so a resumed coroutine can register its next waiter.
+    ftIF2013CycleWaiter* ready = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_waitermutex);
+        ftIF2013CycleWaiter** pos = &m_waiters;
+        while (*pos)
+        {
+            ftIF2013CycleWaiter* waiter = *pos;
+            if (waiter->m_kind == ftIF2013CycleWaiter::NextCycle || IsCycleWaiterDone(waiter))
+            {
+                *pos = waiter->m_next;
+                waiter->m_next = ready;
+                ready = waiter;
+            }
+            else pos = &waiter->m_next;
+        }
+    }
+    while (ready)
+    {
+        // The waiter is gone after the resume, so take the next one first
+        ftIF2013CycleWaiter* waiter = ready;
+        ready = ready->m_next;
+        waiter->m_resume(waiter->m_context);
+    }
+}
+
+bool ftIF2013CycleAwaiter::await_ready() const
+{
+    return m_handler->IsCycleWaiterDone(&m_waiter);
+}
+
+void ftIF2013CycleAwaiter::AddWaiter()
+{
+    m_handler->AddCycleWaiter(&m_waiter);
+}
 /****************************************************************************/
 /*   ftIF2013TransferAreaComHandlerEx::   I2C section                       */
 /****************************************************************************/
@@ -36,6 +36,18 @@
 //          int TaComThreadStart();
 //          int TaComThreadStop();
 //          bool TaComThreadIsRunning();
+// Changes: 2026-10-19
+//          Add StartMotorExCmd/IsMotorExReady, StartCntReset/IsCntResetReady,
+//          SetSound/IsSoundReady and awaitable variants which are resumed by the
+//          TA communication thread (C++20 co_await, see ftIF2013CycleAwaiter)
+//          Add WaitForNextCycle, WaitForInputChange and WaitForAny
+//          Add PID controller engine (AddPidController), see ftProInterface2013PidControl
+//          Add motion profiles (StartMotionProfile), see ftProInterface2013MotionProfile
+//          Add reflex rules (AddReflexRules), see ftProInterface2013Reflex
+//          Add GetCameraFrame with pooled frame buffers, see ftProInterface2013FramePool
+//          Add camera frame info (header, arrival time) and GetCameraStats
+//          Add GetCycleStats (duration of the transfers of the TA communication thread)
+//          StopCamera waits for a camera receive in another thread before it frees the buffer
 ///////////////////////////////////////////////////////////////////////////////
 // Usage details for module ftProInterface2013TransferAreaCom
 //
@@ -45,13 +57,15 @@
 // It is recommended to run the data transfer in a separate thread.
 // See TaComThread in class ftIF2013TransferAreaComHandlerEx
 //
-// There is one exception: GetCameraFrameJpeg uses a separate socket and can be
-// called from a separate thread. So if the camera is used, it makes sense to
+// There is one exception: GetCameraFrameJpeg/GetCameraFrame use a separate socket
+// and can be called from a separate thread. So if the camera is used, it makes sense to
 // decouple the camera and I/O transfer by using separate threads. If I/O and
 // camera transfers are done from one thread, the I/O will be slow.
 //
 // ATTENTION: Start/StopCamera must be called from the main thread because they
 // start the camera server by communicating over the main socket.
+// StopCamera shuts the camera socket down, which ends a receive in another thread,
+// and waits for it before the socket is closed and the camera buffer is freed.
 //
 // ===== JPEG images don't have EOI and other camera bugs =====
 //
@@ -67,15 +81,43 @@
 #include <winsock2.h>
 
 #include <future>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <initializer_list>
 extern "C" {
 #include "common.h"
 #include "FtShmemTxt.h"
 }
+#include "ftProInterface2013PidControl.h"
+#include "ftProInterface2013MotionProfile.h"
+#include "ftProInterface2013Reflex.h"
+#include "ftProInterface2013FramePool.h"
 using namespace std;
 // Double inclusion protection 
 #if(!defined(ftProInterface2013TransferAreaCom_H))
 #define ftProInterface2013TransferAreaCom_H
 
+/*!
+ * @brief Camera link statistics, see ftIF2013TransferAreaComHandler::GetCameraStats
+ * The rolling values are computed over the last CameraStatsWindow frames.
+ */
+struct ftIF2013CameraStats
+{
+	INT32  m_frames;          // frames received since StartCamera
+	INT32  m_pooldropped;     // dropped by GetCameraFrame (no free frame) since StartCamera
+	INT32  m_serverdropped;   // gaps in m_numframeready since StartCamera
+	double m_fps;             // rolling
+	double m_bytespersec;     // rolling, JPEG data
+	double m_droprate;        // rolling, dropped by the server or the pool / frames of the camera
+	double m_interval;        // rolling average time between two frame headers [ms]
+	double m_jitter;          // rolling standard deviation of this time [ms]
+	double m_intervalmax;     // rolling [ms]
+	double m_receivetime;     // rolling average time from header to last byte [ms]
+	double m_ackroundtrip;    // rolling average time from acknowledge to next header [ms]
+};
+
 //******************************************************************************
 //*
 //* Class for handling transfer area based communication over a TCP/IP
@@ -83,6 +125,18 @@ using namespace std;
 //*
 //******************************************************************************
 
+/*!
+ * @brief Timing of the TA communication thread, see ftIF2013TransferAreaComHandlerEx::GetCycleStats
+ * The rolling values are computed over the last CycleStatsWindow transfers.
+ */
+struct ftIF2013CycleStats
+{
+	INT32  m_cycles;          // transfers since TaComThreadStart
+	double m_exchange;        // rolling average duration of a transfer (DoTransfer) [ms]
+	double m_exchangemax;     // rolling [ms]
+	double m_interval;        // rolling average time between two transfers [ms]
+};
+
 class ftIF2013TransferAreaComHandler
 {
 public:
@@ -174,8 +228,32 @@ public:
 	// Receive a JPG frame from the camera server
 	// buffer = pointer to pointer to output buffer
 	// buffersize = pointer to size of output buffer
+	// The buffer is overwritten by the next call and freed by StopCamera
 	bool GetCameraFrameJpeg(unsigned char** buffer, size_t* buffersize);
 
+	// Receive a JPG frame from the camera server into a frame of the pool
+	// frame = handle to the received frame, the frame stays valid until the last
+	//         copy of the handle is released, so it can be decoded by another
+	//         thread while the next frame is received.
+	//         If all frames are in use, the frame is dropped and frame is empty
+	//         (the function still returns true).
+	bool GetCameraFrame(ftIF2013FrameHandle* frame);
+
+	// Number of frames in the pool used by GetCameraFrame (default 4)
+	// Must be called while no frames are in use, e.g. before StartCamera
+	bool SetCameraFramePool(int count);
+
+	// Number of frames dropped by GetCameraFrame since StartCamera
+	INT32 GetCameraFramesDropped() const { return m_cameradropped; }
+
+	// Header and arrival time of the last frame received by GetCameraFrameJpeg
+	// or GetCameraFrame, call from the same thread. GetCameraFrame also stores
+	// it in the frame, see ftIF2013FrameHandle::GetInfo.
+	const ftIF2013FrameInfo& GetCameraFrameInfo() const { return m_camerainfo; }
+
+	// Camera link statistics, can be called from any thread
+	void GetCameraStats(ftIF2013CameraStats* stats);
+
 protected:
 	// Open a socket
 	SOCKET OpenSocket(const char* port);
@@ -192,6 +270,15 @@ protected:
 	// Stop all motors
 	void StopMotors();
 
+	// Receive a camera frame in two steps: header and body (+acknowledge),
+	// both update m_camerainfo, the body also the statistics
+	// dropped = the frame is only read to skip it
+	bool ReceiveCameraFrameHeader(size_t* framesize);
+	bool ReceiveCameraFrameData(unsigned char* buffer, size_t framesize, bool dropped = false);
+	void AddCameraSample(bool dropped);
+	// Enlarge m_camerabuffer if needed
+	bool ReserveCameraBuffer(size_t framesize);
+
 	// Do a transfer (uncompressed MASTER ONLY mode)
   // This function is mostly to illustrate the use of the simple uncompressed transfer mode e.g. for use in other languages.
   // It is recommended to use the compressed transfer mode.
@@ -237,6 +324,31 @@ protected:
 	SOCKET m_camerasocket;
 	size_t m_camerabuffersize;
 	unsigned char* m_camerabuffer;
+	ftIF2013FramePool* m_framepool;
+	int m_framepoolcount;
+	INT32 m_cameraframecount;
+	INT32 m_cameradropped;
+	ftIF2013FrameInfo m_camerainfo;  // last frame
+
+	// Camera statistics: ring of the last frames
+	enum { CameraStatsWindow = 64 };
+	struct CameraSample
+	{
+		std::chrono::steady_clock::time_point m_headertime;
+		INT32 m_bytes;
+		INT32 m_framenumber;
+		bool m_dropped;
+		long long m_receivetime;   // [us]
+		long long m_ackroundtrip;  // [us], <0 for the first frame
+	};
+	CameraSample m_camerasamples[CameraStatsWindow];
+	INT32 m_camerasamplecount;       // since StartCamera
+	INT32 m_cameraserverdropped;
+	std::chrono::steady_clock::time_point m_cameraacktime;  // last acknowledge sent
+	std::mutex m_camerastatsmutex;
+	// Held while a camera frame is received, StopCamera takes it to free the
+	// camera socket and buffer (m_camerasocket, m_camerabuffer, m_framepool)
+	std::mutex m_camerareceivemutex;
 };
 
 /*!
@@ -246,6 +358,80 @@ protected:
 #define I2C_SPEED_100_KHZ       0  /*!< I2C bus clock speed */
 #define I2C_SPEED_400_KHZ       1  /*!< I2C bus clock speed */
 
+class ftIF2013TransferAreaComHandlerEx;
+
+/*!
+ * @brief Input mask bits for WaitForInputChange
+ */
+#define FTIF2013_INPUT_UNI(i)      (1UL << (i))        /*!< universal input I1..I8 (i=0..7) */
+#define FTIF2013_INPUT_CNT_IN(i)   (1UL << (8 + (i)))  /*!< counter input C1..C4 logic state (i=0..3) */
+#define FTIF2013_INPUT_COUNTER(i)  (1UL << (12 + (i))) /*!< counter value C1..C4 (i=0..3) */
+#define FTIF2013_INPUT_ALL         0xFFFFUL
+
+/*!
+ * @brief Event which is shared by several handlers, see WaitForAny
+ */
+struct ftIF2013CycleEvent
+{
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	int m_signaled = -1; // index of the first handler with a new cycle
+};
+
+/*!
+ * @brief An operation which waits for the TXT, e.g. until a motor command is finished.
+ * The node is owned by the caller (usually an ftIF2013CycleAwaiter in a coroutine frame)
+ * and must stay alive until it has been resumed or removed again.
+ * The TA communication thread checks all registered waiters after each transfer and
+ * calls m_resume(m_context) once for each waiter that is finished.
+ */
+struct ftIF2013CycleWaiter
+{
+	enum Kind
+	{
+		NextCycle,     // finished after the next transfer
+		MotorEx,       // finished when ftX1in.motor_ex_cmd_id[m_index]==m_cmdid
+		CounterReset,  // finished when ftX1in.cnt_reset_cmd_id[m_index]==m_cmdid
+		Sound          // finished when sTxtInputs.u16SoundCmdId==m_cmdid
+	};
+	Kind   m_kind;
+	int    m_area;   // ShmIfId_TXT
+	int    m_index;  // motor or counter index
+	UINT16 m_cmdid;  // command id to wait for
+	void (*m_resume)(void* context);
+	void*  m_context;
+	ftIF2013CycleWaiter* m_next;
+};
+
+/*!
+ * @brief Awaitable for C++20 coroutines: co_await handler.MotorExAsync(...)
+ * The coroutine is resumed by the TA communication thread, so the code after the
+ * co_await runs in that thread and must not block.
+ * The awaiter itself doesn't need <coroutine>, so this header is still C++14.
+ */
+struct ftIF2013CycleAwaiter
+{
+	ftIF2013TransferAreaComHandlerEx* m_handler;
+	ftIF2013CycleWaiter m_waiter;
+
+	bool await_ready() const;
+	template<class Handle> void await_suspend(Handle handle)
+	{
+		m_waiter.m_resume = &ResumeHandle<Handle>;
+		m_waiter.m_context = handle.address();
+		// Must be the last action, the coroutine might be resumed immediately
+		AddWaiter();
+	}
+	void await_resume() const {}
+
+private:
+	template<class Handle> static void ResumeHandle(void* address)
+	{
+		Handle::from_address(address).resume();
+	}
+	void AddWaiter();
+};
+
 class ftIF2013TransferAreaComHandlerEx : public ftIF2013TransferAreaComHandler
 {
 protected:
@@ -259,6 +445,47 @@ protected:
 	std::future<void>  futureObj; // = exitSignal.get_future();
 	std::thread thread1= thread();
 
+	/* Called by the communication thread after each successful transfer
+	*/
+	void ProcessCycle();
+	/* Resume all registered waiters which are finished
+	*/
+	void ResumeCycleWaiters();
+	std::mutex m_waitermutex;
+	ftIF2013CycleWaiter* m_waiters = nullptr;
+
+	/* Wake up all threads which wait for a cycle, stopped: the thread ends
+	*/
+	void SignalCycle(bool stopped);
+	/* Snapshot of the inputs in the order of the FTIF2013_INPUT_ mask bits
+	*/
+	void GetInputSnapshot(int area, INT16 snapshot[16]);
+	std::mutex m_cyclemutex;
+	std::condition_variable m_cyclecv;
+	UINT32 m_cyclecount = 0;
+	bool m_cyclestopped = true;     // no communication thread, the waits return at once
+	std::vector<INT16> m_cycleinputs;  // snapshots of all areas of the last cycle, 16 per area
+	std::vector<std::pair<ftIF2013CycleEvent*, int> > m_cycleevents;
+
+	ftIF2013PidEngine m_pid;
+	ftIF2013MotionEngine m_motion;
+	ftIF2013ReflexEngine m_reflex;
+	std::chrono::steady_clock::time_point m_lastcycle;
+
+	/* Cycle statistics: ring of the last transfers, start = begin of the transfer
+	*/
+	void AddCycleSample(std::chrono::steady_clock::time_point start);
+	enum { CycleStatsWindow = 64 };
+	struct CycleSample
+	{
+		long long m_exchange;   // [us]
+		long long m_interval;   // [us], <0 for the first transfer
+	};
+	CycleSample m_cyclesamples[CycleStatsWindow];
+	INT32 m_cyclesamplecount = 0;  // since TaComThreadStart
+	std::chrono::steady_clock::time_point m_cyclestart;  // begin of the last transfer
+	std::mutex m_cyclestatsmutex;
+
 public:
 	ftIF2013TransferAreaComHandlerEx(FISH_X1_TRANSFER* transferarea, int nAreas = 1, const char* name = "192.168.7.2", const char* port = "65000") :
 		ftIF2013TransferAreaComHandler(transferarea, nAreas, name, port){
@@ -281,6 +508,178 @@ public:
 	* @return 0=successful, 1=thread is already not running
 	 */
 	bool TaComThreadIsRunning(); 
+	/*!
+	 * @brief Timing of the transfers of the TA communication thread, can be called from any thread
+	 */
+	void GetCycleStats(ftIF2013CycleStats* stats);
+
+	/*!
+	 * @brief Start an enhanced motor command (motor_ex_cmd_id is incremented)
+	 * @param motor    motor index 0..3 (M1..M4)
+	 * @param duty     -512..512, the sign gives the direction
+	 * @param distance counter value at which the motor stops
+	 * @param master   0 or 1..4: synchronize with this motor (M1..M4)
+	 * @param area     ShmIfId_TXT
+	 * @return the command id, finished when IsMotorExReady() is true
+	 */
+	UINT16 StartMotorExCmd(int motor, int duty, UINT16 distance, int master = 0, int area = ShmIfId_TXT::LOCAL_IO);
+	/*!
+	 * @return The last enhanced motor command of this motor is finished
+	 */
+	bool IsMotorExReady(int motor, int area = ShmIfId_TXT::LOCAL_IO);
+	/*!
+	 * @brief Start a counter reset (cnt_reset_cmd_id is incremented)
+	 * @return the command id, finished when IsCntResetReady() is true
+	 */
+	UINT16 StartCntReset(int counter, int area = ShmIfId_TXT::LOCAL_IO);
+	/*!
+	 * @return The last counter reset of this counter is finished
+	 */
+	bool IsCntResetReady(int counter, int area = ShmIfId_TXT::LOCAL_IO);
+	/*!
+	 * @brief Play a sound of the TXT (u16SoundCmdId is incremented)
+	 * @param index  sound index, 0 means stop sound
+	 * @param repeat repeat count
+	 * @return the command id, finished when IsSoundReady() is true
+	 */
+	UINT16 SetSound(int index, int repeat = 1);
+	/*!
+	 * @return The last sound command is finished
+	 */
+	bool IsSoundReady();
+
+	/*!
+	 * @brief Awaitable versions of the commands above, for use with co_await.
+	 * The command is started immediately, the coroutine is resumed by the TA
+	 * communication thread when the TXT reports the command as finished.
+	 */
+	ftIF2013CycleAwaiter MotorExAsync(int motor, int duty, UINT16 distance, int master = 0, int area = ShmIfId_TXT::LOCAL_IO);
+	ftIF2013CycleAwaiter CounterResetAsync(int counter, int area = ShmIfId_TXT::LOCAL_IO);
+	ftIF2013CycleAwaiter SoundAsync(int index, int repeat = 1);
+	/*!
+	 * @brief Awaitable which is resumed after the next transfer with the TXT
+	 */
+	ftIF2013CycleAwaiter NextCycle();
+
+	/*!
+	 * @brief Register a waiter, see ftIF2013CycleWaiter
+	 * Waiters which are still registered when the thread stops are not resumed.
+	 */
+	void AddCycleWaiter(ftIF2013CycleWaiter* waiter);
+	/*!
+	 * @brief Remove a waiter which has not been resumed yet
+	 * @return the waiter was still registered
+	 */
+	bool RemoveCycleWaiter(ftIF2013CycleWaiter* waiter);
+	/*!
+	 * @return The operation of this waiter is finished
+	 */
+	bool IsCycleWaiterDone(const ftIF2013CycleWaiter* waiter);
+
+	/*!
+	 * @brief Block until the TA communication thread has received the next input frame.
+	 * The calling thread wakes up directly after the inputs are decoded.
+	 * @return false on timeout or when the thread is not running
+	 */
+	bool WaitForNextCycle(std::chrono::milliseconds timeout);
+	/*!
+	 * @brief Block until one of the inputs selected by mask changes.
+	 * @param mask FTIF2013_INPUT_UNI(i) | FTIF2013_INPUT_CNT_IN(i) | FTIF2013_INPUT_COUNTER(i)
+	 * @param area ShmIfId_TXT
+	 * @return the mask of the changed inputs, 0 on timeout or when the thread is not running
+	 */
+	UINT32 WaitForInputChange(UINT32 mask, std::chrono::milliseconds timeout, int area = ShmIfId_TXT::LOCAL_IO);
+	/*!
+	 * @brief Block until one of the handlers has received the next input frame.
+	 * @return index of the first handler with a new cycle, -1 on timeout
+	 */
+	static int WaitForAny(std::initializer_list<ftIF2013TransferAreaComHandlerEx*> handlers, std::chrono::milliseconds timeout);
+	template<class... Handlers> static int WaitForAny(std::chrono::milliseconds timeout, Handlers*... handlers)
+	{
+		return WaitForAny({ handlers... }, timeout);
+	}
 
+	/*!
+	 * @brief Add a closed loop (PID) controller which runs in the TA communication thread
+	 * at cycle rate, between input decode and output encode.
+	 * The setpoint is initialized with the current process value.
+	 * @return id of the controller, -1 if the configuration is wrong or all are in use
+	 */
+	int AddPidController(const ftIF2013PidConfig& config);
+	/*!
+	 * @brief Remove a controller, its motor output is set to 0
+	 */
+	bool RemovePidController(int id);
+	/*!
+	 * @brief Set the setpoint, e.g. the position in counter steps
+	 */
+	bool SetPidSetpoint(int id, INT32 setpoint);
+	/*!
+	 * @return the process value of the last cycle, e.g. the signed position
+	 */
+	INT32 GetPidValue(int id);
+
+	/*!
+	 * @brief Move an encoder motor with a trapezoidal (jmax=0) or S-curve velocity profile.
+	 * The duty is recalculated in the TA communication thread with each transfer,
+	 * the TXT stops the motor at the exact distance (enhanced motor command).
+	 * @param distance signed distance in counter steps
+	 * @return id of the motion, -1 if the configuration is wrong or all axes are in use
+	 */
+	int StartMotionProfile(const ftIF2013MotionConfig& config, INT32 distance);
+	/*!
+	 * @return the motion is finished
+	 */
+	bool IsMotionProfileDone(int id);
+	/*!
+	 * @brief Stop a motion immediately, the motor output is set to 0
+	 */
+	bool StopMotionProfile(int id);
+	/*!
+	 * @return the signed counter steps done so far
+	 */
+	INT32 GetMotionProfilePosition(int id);
+
+	/*!
+	 * @brief Add a table of reflex rules which are evaluated in the TA communication
+	 * thread after each transfer. A reaction is sent with the next transfer and
+	 * overrides the duty of the PID controllers and motion profiles.
+	 * @return id of the table, -1 if a rule is wrong or all tables are in use
+	 */
+	int AddReflexRules(const ftIF2013ReflexRule* rules, int count);
+	bool RemoveReflexRules(int id);
+	/*!
+	 * @brief Release the latched rules of a table
+	 */
+	bool ResetReflexRules(int id);
+	/*!
+	 * @return bit n is set if rule n matched in the last cycle or is latched
+	 */
+	UINT32 GetReflexTriggered(int id);
 };
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <exception>
+/*!
+ * @brief Minimal fire and forget coroutine type for motion sequences:
+ *   ftIF2013Task Sequence(ftIF2013TransferAreaComHandlerEx* h) {
+ *       co_await h->MotorExAsync(0, 512, 100);
+ *       co_await h->SoundAsync(3); }
+ * The coroutine runs until the first co_await in the calling thread and after
+ * that in the TA communication thread. The frame is freed when it finishes.
+ */
+struct ftIF2013Task
+{
+	struct promise_type
+	{
+		ftIF2013Task get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+#endif // __cpp_impl_coroutine
+
 #endif // ftProInterface2013TransferAreaCom_H
\ No newline at end of file
@@ -0,0 +1,764 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013Vision.cpp
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  SIMD vision primitives on the decoder output for control loops
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Implementation details for module ftProInterface2013Vision
+//
+// Process takes one row after the other: Y, U and V rows (U and V with half
+// width, split from YUYV and NV12 into own rows), the histogram, the
+// difference to the same row of the previous image, one mask row per color
+// class and the scan rows. The mask rows become runs, runs which touch a run
+// of the previous row (8-connected) are joined in a union-find, after the
+// last row the runs are summed up per root.
+//
+// A value a is within [lo, hi] if subs(a, hi) | subs(lo, a) == 0 (unsigned
+// saturating subtraction), so each range check is 2 subtractions for 16 or
+// 32 pixels. The absolute difference is subs(a, b) | subs(b, a), summed with
+// psadbw.
+//
+// The AVX2 kernels clear the upper halves of the YMM registers before the
+// SSE2 code for the rest of the row, GCC doesn't do this for functions with
+// a target attribute and the mixed code runs much slower.
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+#include <algorithm>
+
+#include "ftProInterface2013Vision.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define FTPRO_SIMD_X86
+#endif
+
+#if defined(FTPRO_SIMD_X86)
+#if defined(_MSC_VER)
+#define FTPRO_TARGET_SSE2
+#define FTPRO_TARGET_AVX2
+#else
+#define FTPRO_TARGET_SSE2 __attribute__((target("sse2")))
+#define FTPRO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#include <immintrin.h>
+#endif
+
+//******************************************************************************
+//****
+//**** Row kernels, plain C
+//****
+//******************************************************************************
+
+// YUYV row (x, width in pixels, even) to Y, U and V rows
+static void SplitYuyvC(const UINT8* src, UINT8* y, UINT8* u, UINT8* v, int x, int width)
+{
+    for (; x < width; x += 2)
+    {
+        y[x] = src[2 * x];
+        u[x / 2] = src[2 * x + 1];
+        y[x + 1] = src[2 * x + 2];
+        v[x / 2] = src[2 * x + 3];
+    }
+}
+
+// NV12 chroma row (count U/V pairs) to U and V rows
+static void SplitUvC(const UINT8* src, UINT8* u, UINT8* v, int x, int count)
+{
+    for (; x < count; x++)
+    {
+        u[x] = src[2 * x];
+        v[x] = src[2 * x + 1];
+    }
+}
+
+// 255 for each pixel within the color class, else 0
+static void ColorMaskC(const UINT8* y, const UINT8* u, const UINT8* v, const ftProVisionColor& c, UINT8* dst, int x, int width)
+{
+    for (; x < width; x++)
+    {
+        int cu = u[x / 2], cv = v[x / 2];
+        bool in = y[x] >= c.ymin && y[x] <= c.ymax && cu >= c.umin && cu <= c.umax && cv >= c.vmin && cv <= c.vmax;
+        dst[x] = in ? 255 : 0;
+    }
+}
+
+// 255 for each value within [lo, hi], else 0
+static void RangeMaskC(const UINT8* y, UINT8 lo, UINT8 hi, UINT8* dst, int x, int width)
+{
+    for (; x < width; x++)
+    {
+        dst[x] = (y[x] >= lo && y[x] <= hi) ? 255 : 0;
+    }
+}
+
+static void MinMaxC(const UINT8* y, int x, int width, int* min, int* max)
+{
+    for (; x < width; x++)
+    {
+        if (y[x] < *min) *min = y[x];
+        if (y[x] > *max) *max = y[x];
+    }
+}
+
+// Sum of |a-b|, 255 in dst for |a-b| > threshold, count of these pixels added to *count
+static INT32 DiffMaskC(const UINT8* a, const UINT8* b, UINT8 threshold, UINT8* dst, int x, int width, INT32* count)
+{
+    INT32 sum = 0;
+    for (; x < width; x++)
+    {
+        int d = a[x] > b[x] ? a[x] - b[x] : b[x] - a[x];
+        sum += d;
+        dst[x] = d > threshold ? 255 : 0;
+        *count += d > threshold;
+    }
+    return sum;
+}
+
+//******************************************************************************
+//****
+//**** Row kernels, SSE2 (16 pixels per step) and AVX2 (32 pixels per step)
+//****
+//******************************************************************************
+
+#if defined(FTPRO_SIMD_X86)
+
+FTPRO_TARGET_SSE2 static void SplitYuyvSse2(const UINT8* src, UINT8* y, UINT8* u, UINT8* v, int x, int width)
+{
+    const __m128i low = _mm_set1_epi16(0x00FF);
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + 2 * x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 2 * x + 16));
+        _mm_storeu_si128((__m128i*)(y + x), _mm_packus_epi16(_mm_and_si128(a, low), _mm_and_si128(b, low)));
+        __m128i uv = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));  // U0 V0 U1 V1 ...
+        _mm_storel_epi64((__m128i*)(u + x / 2), _mm_packus_epi16(_mm_and_si128(uv, low), _mm_setzero_si128()));
+        _mm_storel_epi64((__m128i*)(v + x / 2), _mm_packus_epi16(_mm_srli_epi16(uv, 8), _mm_setzero_si128()));
+    }
+    SplitYuyvC(src, y, u, v, x, width);
+}
+
+FTPRO_TARGET_SSE2 static void SplitUvSse2(const UINT8* src, UINT8* u, UINT8* v, int x, int count)
+{
+    const __m128i low = _mm_set1_epi16(0x00FF);
+    for (; x + 16 <= count; x += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src + 2 * x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + 2 * x + 16));
+        _mm_storeu_si128((__m128i*)(u + x), _mm_packus_epi16(_mm_and_si128(a, low), _mm_and_si128(b, low)));
+        _mm_storeu_si128((__m128i*)(v + x), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    }
+    SplitUvC(src, u, v, x, count);
+}
+
+FTPRO_TARGET_SSE2 static inline __m128i OutsideSse2(__m128i a, __m128i lo, __m128i hi)
+{
+    // != 0 for values outside [lo, hi]
+    return _mm_or_si128(_mm_subs_epu8(a, hi), _mm_subs_epu8(lo, a));
+}
+
+FTPRO_TARGET_SSE2 static void ColorMaskSse2(const UINT8* y, const UINT8* u, const UINT8* v, const ftProVisionColor& c, UINT8* dst, int x, int width)
+{
+    const __m128i ylo = _mm_set1_epi8((char)c.ymin), yhi = _mm_set1_epi8((char)c.ymax);
+    const __m128i ulo = _mm_set1_epi8((char)c.umin), uhi = _mm_set1_epi8((char)c.umax);
+    const __m128i vlo = _mm_set1_epi8((char)c.vmin), vhi = _mm_set1_epi8((char)c.vmax);
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i yy = _mm_loadu_si128((const __m128i*)(y + x));
+        __m128i uu = _mm_loadl_epi64((const __m128i*)(u + x / 2));
+        __m128i vv = _mm_loadl_epi64((const __m128i*)(v + x / 2));
+        uu = _mm_unpacklo_epi8(uu, uu);
+        vv = _mm_unpacklo_epi8(vv, vv);
+        __m128i out = _mm_or_si128(OutsideSse2(yy, ylo, yhi), _mm_or_si128(OutsideSse2(uu, ulo, uhi), OutsideSse2(vv, vlo, vhi)));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_cmpeq_epi8(out, _mm_setzero_si128()));
+    }
+    ColorMaskC(y, u, v, c, dst, x, width);
+}
+
+FTPRO_TARGET_SSE2 static void RangeMaskSse2(const UINT8* y, UINT8 lo, UINT8 hi, UINT8* dst, int x, int width)
+{
+    const __m128i vlo = _mm_set1_epi8((char)lo), vhi = _mm_set1_epi8((char)hi);
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i yy = _mm_loadu_si128((const __m128i*)(y + x));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_cmpeq_epi8(OutsideSse2(yy, vlo, vhi), _mm_setzero_si128()));
+    }
+    RangeMaskC(y, lo, hi, dst, x, width);
+}
+
+FTPRO_TARGET_SSE2 static void MinMaxSse2(const UINT8* y, int x, int width, int* min, int* max)
+{
+    if (x + 16 <= width)
+    {
+        __m128i vmin = _mm_set1_epi8((char)*min), vmax = _mm_set1_epi8((char)*max);
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i yy = _mm_loadu_si128((const __m128i*)(y + x));
+            vmin = _mm_min_epu8(vmin, yy);
+            vmax = _mm_max_epu8(vmax, yy);
+        }
+        UINT8 lo[16], hi[16];
+        _mm_storeu_si128((__m128i*)lo, vmin);
+        _mm_storeu_si128((__m128i*)hi, vmax);
+        MinMaxC(lo, 0, 16, min, max);
+        MinMaxC(hi, 0, 16, min, max);
+    }
+    MinMaxC(y, x, width, min, max);
+}
+
+FTPRO_TARGET_SSE2 static INT32 DiffMaskSse2(const UINT8* a, const UINT8* b, UINT8 threshold, UINT8* dst, int x, int width, INT32* count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i thr = _mm_set1_epi8((char)threshold);
+    __m128i sum = zero, changed = zero;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i aa = _mm_loadu_si128((const __m128i*)(a + x));
+        __m128i bb = _mm_loadu_si128((const __m128i*)(b + x));
+        __m128i d = _mm_or_si128(_mm_subs_epu8(aa, bb), _mm_subs_epu8(bb, aa));
+        __m128i mask = _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(d, thr), zero), _mm_set1_epi8(-1));
+        _mm_storeu_si128((__m128i*)(dst + x), mask);
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(d, zero));
+        changed = _mm_add_epi64(changed, _mm_sad_epu8(_mm_and_si128(mask, one), zero));
+    }
+    sum = _mm_add_epi64(sum, _mm_srli_si128(sum, 8));
+    changed = _mm_add_epi64(changed, _mm_srli_si128(changed, 8));
+    *count += _mm_cvtsi128_si32(changed);
+    return _mm_cvtsi128_si32(sum) + DiffMaskC(a, b, threshold, dst, x, width, count);
+}
+
+FTPRO_TARGET_AVX2 static inline __m256i OutsideAvx2(__m256i a, __m256i lo, __m256i hi)
+{
+    return _mm256_or_si256(_mm256_subs_epu8(a, hi), _mm256_subs_epu8(lo, a));
+}
+
+// 16 chroma samples to 32 (each twice)
+FTPRO_TARGET_AVX2 static inline __m256i WidenAvx2(const UINT8* c)
+{
+    __m256i w = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)c));
+    return _mm256_or_si256(w, _mm256_slli_epi16(w, 8));
+}
+
+FTPRO_TARGET_AVX2 static void ColorMaskAvx2(const UINT8* y, const UINT8* u, const UINT8* v, const ftProVisionColor& c, UINT8* dst, int x, int width)
+{
+    const __m256i ylo = _mm256_set1_epi8((char)c.ymin), yhi = _mm256_set1_epi8((char)c.ymax);
+    const __m256i ulo = _mm256_set1_epi8((char)c.umin), uhi = _mm256_set1_epi8((char)c.umax);
+    const __m256i vlo = _mm256_set1_epi8((char)c.vmin), vhi = _mm256_set1_epi8((char)c.vmax);
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i yy = _mm256_loadu_si256((const __m256i*)(y + x));
+        __m256i uu = WidenAvx2(u + x / 2);
+        __m256i vv = WidenAvx2(v + x / 2);
+        __m256i out = _mm256_or_si256(OutsideAvx2(yy, ylo, yhi), _mm256_or_si256(OutsideAvx2(uu, ulo, uhi), OutsideAvx2(vv, vlo, vhi)));
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_cmpeq_epi8(out, _mm256_setzero_si256()));
+    }
+    _mm256_zeroupper();
+    ColorMaskSse2(y, u, v, c, dst, x, width);
+}
+
+FTPRO_TARGET_AVX2 static void RangeMaskAvx2(const UINT8* y, UINT8 lo, UINT8 hi, UINT8* dst, int x, int width)
+{
+    const __m256i vlo = _mm256_set1_epi8((char)lo), vhi = _mm256_set1_epi8((char)hi);
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i yy = _mm256_loadu_si256((const __m256i*)(y + x));
+        _mm256_storeu_si256((__m256i*)(dst + x), _mm256_cmpeq_epi8(OutsideAvx2(yy, vlo, vhi), _mm256_setzero_si256()));
+    }
+    _mm256_zeroupper();
+    RangeMaskSse2(y, lo, hi, dst, x, width);
+}
+
+FTPRO_TARGET_AVX2 static INT32 DiffMaskAvx2(const UINT8* a, const UINT8* b, UINT8 threshold, UINT8* dst, int x, int width, INT32* count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i thr = _mm256_set1_epi8((char)threshold);
+    __m256i sum = zero, changed = zero;
+    for (; x + 32 <= width; x += 32)
+    {
+        __m256i aa = _mm256_loadu_si256((const __m256i*)(a + x));
+        __m256i bb = _mm256_loadu_si256((const __m256i*)(b + x));
+        __m256i d = _mm256_or_si256(_mm256_subs_epu8(aa, bb), _mm256_subs_epu8(bb, aa));
+        __m256i mask = _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(d, thr), zero), _mm256_set1_epi8(-1));
+        _mm256_storeu_si256((__m256i*)(dst + x), mask);
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(d, zero));
+        changed = _mm256_add_epi64(changed, _mm256_sad_epu8(_mm256_and_si256(mask, one), zero));
+    }
+    __m128i s = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    __m128i n = _mm_add_epi64(_mm256_castsi256_si128(changed), _mm256_extracti128_si256(changed, 1));
+    s = _mm_add_epi64(s, _mm_srli_si128(s, 8));
+    n = _mm_add_epi64(n, _mm_srli_si128(n, 8));
+    *count += _mm_cvtsi128_si32(n);
+    _mm256_zeroupper();
+    return _mm_cvtsi128_si32(s) + DiffMaskSse2(a, b, threshold, dst, x, width, count);
+}
+
+#endif // FTPRO_SIMD_X86
+
+//******************************************************************************
+//****
+//**** Kernel selection
+//****
+//******************************************************************************
+
+struct ftProVisionKernels
+{
+    void (*splityuyv)(const UINT8* src, UINT8* y, UINT8* u, UINT8* v, int x, int width);
+    void (*splituv)(const UINT8* src, UINT8* u, UINT8* v, int x, int count);
+    void (*colormask)(const UINT8* y, const UINT8* u, const UINT8* v, const ftProVisionColor& c, UINT8* dst, int x, int width);
+    void (*rangemask)(const UINT8* y, UINT8 lo, UINT8 hi, UINT8* dst, int x, int width);
+    void (*minmax)(const UINT8* y, int x, int width, int* min, int* max);
+    INT32 (*diffmask)(const UINT8* a, const UINT8* b, UINT8 threshold, UINT8* dst, int x, int width, INT32* count);
+};
+
+static ftProVisionKernels SelectKernels()
+{
+    ftProVisionKernels kernels = { SplitYuyvC, SplitUvC, ColorMaskC, RangeMaskC, MinMaxC, DiffMaskC };
+#if defined(FTPRO_SIMD_X86)
+    int features = ftProGetCpuFeatures();
+    if (features & FTPRO_CPU_AVX2)
+    {
+        // Splitting and min/max are limited by the memory, SSE2 is enough
+        ftProVisionKernels avx2 = { SplitYuyvSse2, SplitUvSse2, ColorMaskAvx2, RangeMaskAvx2, MinMaxSse2, DiffMaskAvx2 };
+        kernels = avx2;
+    }
+    else if (features & FTPRO_CPU_SSE2)
+    {
+        ftProVisionKernels sse2 = { SplitYuyvSse2, SplitUvSse2, ColorMaskSse2, RangeMaskSse2, MinMaxSse2, DiffMaskSse2 };
+        kernels = sse2;
+    }
+#endif
+    return kernels;
+}
+
+static const ftProVisionKernels& GetKernels()
+{
+    static const ftProVisionKernels kernels = SelectKernels();
+    return kernels;
+}
+
+// 8 mask bytes at once
+static inline unsigned long long LoadMask8(const UINT8* p)
+{
+    unsigned long long word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+//******************************************************************************
+//****
+//**** ftProVision
+//****
+//******************************************************************************
+
+ftProVision::ftProVision(const ftProVisionConfig& config) :
+    m_previousvalid(false),
+    m_previouswidth(0),
+    m_previousheight(0),
+    m_haslatest(false)
+{
+    SetConfig(config);
+}
+
+void ftProVision::SetConfig(const ftProVisionConfig& config)
+{
+    m_config = config;
+    if (m_config.colors < 0) m_config.colors = 0;
+    if (m_config.colors > FTPRO_VISION_MAXCOLORS) m_config.colors = FTPRO_VISION_MAXCOLORS;
+    if (m_config.lines < 0) m_config.lines = 0;
+    if (m_config.lines > FTPRO_VISION_MAXLINES) m_config.lines = FTPRO_VISION_MAXLINES;
+    if (m_config.minarea < 1) m_config.minarea = 1;
+    if (m_config.diffthreshold < 0) m_config.diffthreshold = 0;
+    if (m_config.diffthreshold > 255) m_config.diffthreshold = 255;
+}
+
+int ftProVision::FindRoot(std::vector<int>& parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void ftProVision::AddRuns(ColorState& state, const UINT8* mask, int width, int y)
+{
+    size_t first = state.runs.size();
+    size_t above = state.prevstart;  // first run of the previous row which may touch
+    int x = 0;
+    while (x < width)
+    {
+        // Skip 8 pixels at once outside and inside of a run
+        while (x + 8 <= width && LoadMask8(mask + x) == 0) x += 8;
+        while (x < width && !mask[x]) x++;
+        if (x >= width) break;
+        int start = x;
+        while (x + 8 <= width && LoadMask8(mask + x) == ~0ull) x += 8;
+        while (x < width && mask[x]) x++;
+
+        Run run = { start, x, y };
+        int index = (int)state.runs.size();
+        state.runs.push_back(run);
+        state.parent.push_back(index);
+
+        // Join with the runs of the previous row which touch this one (also diagonal)
+        while (above < state.prevend && state.runs[above].x1 < start) above++;
+        for (size_t prev = above; prev < state.prevend && state.runs[prev].x0 <= x; prev++)
+        {
+            int a = FindRoot(state.parent, (int)prev);
+            int b = FindRoot(state.parent, index);
+            if (a != b)
+            {
+                // The lower index stays root
+                if (a < b) state.parent[b] = a;
+                else state.parent[a] = b;
+            }
+        }
+    }
+    state.prevstart = first;
+    state.prevend = state.runs.size();
+}
+
+void ftProVision::CollectBlobs(int color, ColorState& state, std::vector<ftProVisionBlob>& blobs)
+{
+    // Sums per root
+    struct Sum
+    {
+        long long area, sumx2, sumy;
+        int left, top, right, bottom;
+    };
+    std::vector<int> slot(state.runs.size(), -1);
+    std::vector<Sum> sums;
+    for (size_t i = 0; i < state.runs.size(); i++)
+    {
+        const Run& run = state.runs[i];
+        int root = FindRoot(state.parent, (int)i);
+        if (slot[root] < 0)
+        {
+            slot[root] = (int)sums.size();
+            Sum sum = { 0, 0, 0, run.x0, run.y, run.x1 - 1, run.y };
+            sums.push_back(sum);
+        }
+        Sum& sum = sums[slot[root]];
+        long long length = run.x1 - run.x0;
+        sum.area += length;
+        sum.sumx2 += length * (run.x0 + run.x1 - 1);  // 2 * sum of x
+        sum.sumy += length * run.y;
+        sum.left = std::min(sum.left, run.x0);
+        sum.right = std::max(sum.right, run.x1 - 1);
+        sum.bottom = std::max(sum.bottom, run.y);
+    }
+    for (size_t i = 0; i < sums.size(); i++)
+    {
+        const Sum& sum = sums[i];
+        if (sum.area < m_config.minarea) continue;
+        ftProVisionBlob blob;
+        blob.m_color = color;
+        blob.m_area = (INT32)sum.area;
+        blob.m_x = (double)sum.sumx2 / (2.0 * sum.area);
+        blob.m_y = (double)sum.sumy / sum.area;
+        blob.m_left = sum.left;
+        blob.m_top = sum.top;
+        blob.m_right = sum.right;
+        blob.m_bottom = sum.bottom;
+        blobs.push_back(blob);
+    }
+}
+
+void ftProVision::ScanLine(const UINT8* y, int width, int row, ftProVisionLine* line)
+{
+    const ftProVisionKernels& kernels = GetKernels();
+
+    line->m_row = row;
+    line->m_found = false;
+    line->m_x = 0;
+    line->m_width = 0;
+
+    int threshold = m_config.linethreshold;
+    if (threshold <= 0)
+    {
+        int min = 255, max = 0;
+        kernels.minmax(y, 0, width, &min, &max);
+        line->m_threshold = (min + max) / 2;
+        if (max - min < m_config.linecontrast)
+        {
+            return;
+        }
+        threshold = line->m_threshold;
+    }
+    line->m_threshold = threshold;
+    if (threshold > 255) threshold = 255;
+
+    // Dark line: values up to the threshold, bright line: above
+    if (m_config.darkline)
+        kernels.rangemask(y, 0, (UINT8)threshold, m_mask.data(), 0, width);
+    else if (threshold < 255)
+        kernels.rangemask(y, (UINT8)(threshold + 1), 255, m_mask.data(), 0, width);
+    else
+        return;
+
+    // Widest run
+    const UINT8* mask = m_mask.data();
+    int x = 0;
+    while (x < width)
+    {
+        while (x + 8 <= width && LoadMask8(mask + x) == 0) x += 8;
+        while (x < width && !mask[x]) x++;
+        if (x >= width) break;
+        int start = x;
+        while (x + 8 <= width && LoadMask8(mask + x) == ~0ull) x += 8;
+        while (x < width && mask[x]) x++;
+        if (x - start > line->m_width)
+        {
+            line->m_width = x - start;
+            line->m_x = (start + x - 1) / 2.0;
+        }
+    }
+    line->m_found = line->m_width >= m_config.minlinewidth;
+}
+
+bool ftProVision::Process(const ftProImage& image, ftProVisionResult* result,
+    INT32 sequence, INT32 framenumber, std::chrono::steady_clock::time_point received)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const ftProVisionKernels& kernels = GetKernels();
+
+    int width = image.width;
+    int height = image.height;
+    if (!image.data || width <= 0 || height <= 0 || (width & 1) || (height & 1))
+    {
+        return false;
+    }
+    if (image.format != FTPRO_PIXEL_YUYV && image.format != FTPRO_PIXEL_I420 &&
+        image.format != FTPRO_PIXEL_NV12 && image.format != FTPRO_PIXEL_GRAY8)
+    {
+        return false;
+    }
+
+    result->m_sequence = sequence;
+    result->m_framenumber = framenumber;
+    result->m_received = received;
+    result->m_width = width;
+    result->m_height = height;
+    result->m_blobcount = 0;
+    result->m_blobtotal = 0;
+    result->m_linecount = m_config.lines;
+    memset(result->m_histogram, 0, sizeof(result->m_histogram));
+    result->m_mean = 0;
+    result->m_min = 0;
+    result->m_max = 0;
+    result->m_diffvalid = false;
+    result->m_changed = 0;
+    result->m_diffmean = 0;
+    result->m_diffleft = result->m_difftop = result->m_diffright = result->m_diffbottom = -1;
+
+    int cwidth = width / 2;
+    m_rowy.resize(width);
+    m_rowu.resize(cwidth);
+    m_rowv.resize(cwidth);
+    m_mask.resize(width);
+    if (image.format == FTPRO_PIXEL_GRAY8)
+    {
+        memset(m_rowu.data(), 128, cwidth);
+        memset(m_rowv.data(), 128, cwidth);
+    }
+
+    // Scan rows
+    int linerows[FTPRO_VISION_MAXLINES];
+    for (int i = 0; i < m_config.lines; i++)
+    {
+        double position = m_config.linetop;
+        if (m_config.lines > 1)
+        {
+            position += (m_config.linebottom - m_config.linetop) * i / (m_config.lines - 1);
+        }
+        int row = (int)(position * (height - 1) + 0.5);
+        linerows[i] = std::min(std::max(row, 0), height - 1);
+    }
+
+    // Difference: only with a previous image of the same size
+    bool difference = m_config.difference;
+    bool comparable = difference && m_previousvalid && m_previouswidth == width && m_previousheight == height;
+    if (difference)
+    {
+        m_previous.resize((size_t)width * height);
+    }
+    long long diffsum = 0;
+
+    for (int c = 0; c < m_config.colors; c++)
+    {
+        m_colors[c].runs.clear();
+        m_colors[c].parent.clear();
+        m_colors[c].prevstart = m_colors[c].prevend = 0;
+    }
+
+    // Histogram in 4 parts, so repeated values don't wait for each other
+    INT32 histogram[4][256];
+    if (m_config.histogram)
+    {
+        memset(histogram, 0, sizeof(histogram));
+    }
+
+    size_t lumasize = (size_t)width * height;
+    for (int row = 0; row < height; row++)
+    {
+        const UINT8* y;
+        const UINT8* u = m_rowu.data();
+        const UINT8* v = m_rowv.data();
+        switch (image.format)
+        {
+        case FTPRO_PIXEL_YUYV:
+            kernels.splityuyv(image.data + (size_t)row * width * 2, m_rowy.data(), m_rowu.data(), m_rowv.data(), 0, width);
+            y = m_rowy.data();
+            break;
+        case FTPRO_PIXEL_I420:
+            y = image.data + (size_t)row * width;
+            u = image.data + lumasize + (size_t)(row / 2) * cwidth;
+            v = image.data + lumasize + lumasize / 4 + (size_t)(row / 2) * cwidth;
+            break;
+        case FTPRO_PIXEL_NV12:
+            y = image.data + (size_t)row * width;
+            if (m_config.colors && (row & 1) == 0)
+            {
+                kernels.splituv(image.data + lumasize + (size_t)(row / 2) * width, m_rowu.data(), m_rowv.data(), 0, cwidth);
+            }
+            break;
+        default:
+            y = image.data + (size_t)row * width;
+            break;
+        }
+
+        if (m_config.histogram)
+        {
+            int x = 0;
+            for (; x + 4 <= width; x += 4)
+            {
+                histogram[0][y[x]]++;
+                histogram[1][y[x + 1]]++;
+                histogram[2][y[x + 2]]++;
+                histogram[3][y[x + 3]]++;
+            }
+            for (; x < width; x++)
+            {
+                histogram[0][y[x]]++;
+            }
+        }
+
+        if (difference)
+        {
+            UINT8* previous = m_previous.data() + (size_t)row * width;
+            if (comparable)
+            {
+                INT32 changed = 0;
+                diffsum += kernels.diffmask(y, previous, (UINT8)m_config.diffthreshold, m_mask.data(), 0, width, &changed);
+                if (changed)
+                {
+                    int left = 0, right = width - 1;
+                    while (!m_mask[left]) left++;
+                    while (!m_mask[right]) right--;
+                    if (result->m_changed == 0)
+                    {
+                        result->m_difftop = row;
+                        result->m_diffleft = left;
+                        result->m_diffright = right;
+                    }
+                    result->m_diffleft = std::min(result->m_diffleft, left);
+                    result->m_diffright = std::max(result->m_diffright, right);
+                    result->m_diffbottom = row;
+                    result->m_changed += changed;
+                }
+            }
+            memcpy(previous, y, width);
+        }
+
+        for (int c = 0; c < m_config.colors; c++)
+        {
+            kernels.colormask(y, u, v, m_config.color[c], m_mask.data(), 0, width);
+            AddRuns(m_colors[c], m_mask.data(), width, row);
+        }
+
+        for (int i = 0; i < m_config.lines; i++)
+        {
+            if (linerows[i] == row)
+            {
+                ScanLine(y, width, row, &result->m_lines[i]);
+            }
+        }
+    }
+
+    if (m_config.histogram)
+    {
+        long long sum = 0;
+        result->m_min = -1;
+        for (int i = 0; i < 256; i++)
+        {
+            INT32 count = histogram[0][i] + histogram[1][i] + histogram[2][i] + histogram[3][i];
+            result->m_histogram[i] = count;
+            sum += (long long)count * i;
+            if (count)
+            {
+                if (result->m_min < 0) result->m_min = i;
+                result->m_max = i;
+            }
+        }
+        result->m_mean = (double)sum / lumasize;
+    }
+
+    if (difference)
+    {
+        result->m_diffvalid = comparable;
+        result->m_diffmean = comparable ? (double)diffsum / lumasize : 0;
+        m_previousvalid = true;
+        m_previouswidth = width;
+        m_previousheight = height;
+    }
+
+    // Largest blobs of all color classes
+    m_blobs.clear();
+    for (int c = 0; c < m_config.colors; c++)
+    {
+        CollectBlobs(c, m_colors[c], m_blobs);
+    }
+    result->m_blobtotal = (int)m_blobs.size();
+    result->m_blobcount = std::min((int)m_blobs.size(), FTPRO_VISION_MAXBLOBS);
+    std::partial_sort(m_blobs.begin(), m_blobs.begin() + result->m_blobcount, m_blobs.end(),
+        [](const ftProVisionBlob& a, const ftProVisionBlob& b) { return a.m_area > b.m_area; });
+    std::copy(m_blobs.begin(), m_blobs.begin() + result->m_blobcount, result->m_blobs);
+
+    result->m_done = std::chrono::steady_clock::now();
+    result->m_processtime = std::chrono::duration<double, std::milli>(result->m_done - start).count();
+
+    std::lock_guard<std::mutex> lock(m_latestmutex);
+    m_latest = *result;
+    m_haslatest = true;
+    return true;
+}
+
+bool ftProVision::Process(const ftProImage& image, const ftIF2013FrameInfo& info, ftProVisionResult* result)
+{
+    return Process(image, result, info.m_sequence, info.m_framenumber, info.m_received);
+}
+
+bool ftProVision::Process(const ftProImage& image, const ftIF2013PipelineFrame& frame, ftProVisionResult* result)
+{
+    return Process(image, result, frame.m_sequence, frame.m_framenumber, frame.m_received);
+}
+
+bool ftProVision::GetLatest(ftProVisionResult* result)
+{
+    std::lock_guard<std::mutex> lock(m_latestmutex);
+    if (!m_haslatest)
+    {
+        return false;
+    }
+    *result = m_latest;
+    return true;
+}
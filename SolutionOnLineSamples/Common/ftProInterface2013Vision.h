@@ -0,0 +1,223 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// File:    ftProInterface2013Vision.h
+//
+// Project: ftPro - fischertechnik Control Graphical Programming System
+//
+// Module:  SIMD vision primitives on the decoder output for control loops
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+// Usage details for module ftProInterface2013Vision
+//
+// ftProVision analyzes a decoded image (YUYV, I420, NV12 or GRAY8) in one pass
+// over the rows and fills a ftProVisionResult:
+// - blobs: pixels within a Y/U/V range of a color class, 8-connected, with
+//   area, centroid and bounding box (largest first)
+// - lines: position of a dark (or bright) line on some scan rows, e.g. for a
+//   line follower. The threshold is the middle between the darkest and the
+//   brightest pixel of the row unless linethreshold is given.
+// - histogram of the brightness (Y) with mean, minimum and maximum
+// - difference to the previous image: changed pixels, mean difference and
+//   the bounding box of the change
+// The result carries the frame number and the arrival time of the frame, so
+// the control code knows how old the information is (m_received .. m_done).
+//
+//   ftProVisionConfig config;
+//   config.colors = 1;
+//   config.color[0] = { 30, 200, 80, 120, 160, 255 };  // red
+//   config.lines = 3;
+//   ftProVision vision( config );
+//   ...
+//   pipeline.GetFrame( &frame );
+//   ftProImage image = { FTPRO_PIXEL_YUYV, width, height, frame.m_image.GetData() };
+//   vision.Process( image, frame, &result );
+//   if( result.m_blobcount ) ComHandlerEx->SetPidSetpoint( id, (INT32)result.m_blobs[0].m_x );
+//
+// Process must only be called by one thread. Another thread (e.g. the
+// control loop) can take the result of the last frame with GetLatest.
+// For GRAY8 U and V are 128, the color classes should allow this.
+// Mask, compare and difference kernels are selected at run time: AVX2, SSE2
+// or plain C (see ftProGetCpuFeatures), all give the same results.
+//
+// see also: ftIF2013CameraPipeline, ftProJpegDecoder, ftProPixelFormat
+//
+// Changes: 2026-10-19
+//          First version
+///////////////////////////////////////////////////////////////////////////////
+
+// Double inclusion protection
+#if(!defined(ftProInterface2013Vision_H))
+#define ftProInterface2013Vision_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "ftProInterface2013PixelFormat.h"
+#include "ftProInterface2013FramePool.h"
+#include "ftProInterface2013CameraPipeline.h"
+
+#define FTPRO_VISION_MAXCOLORS 4
+#define FTPRO_VISION_MAXBLOBS  8
+#define FTPRO_VISION_MAXLINES  8
+
+/*!
+ * @brief A color class: ranges of Y, U (Cb) and V (Cr), limits included
+ */
+struct ftProVisionColor
+{
+	UINT8 ymin, ymax;
+	UINT8 umin, umax;
+	UINT8 vmin, vmax;
+};
+
+/*!
+ * @brief What is analyzed, see the module description
+ */
+struct ftProVisionConfig
+{
+	int colors = 0;                 // color classes for blobs, 0..FTPRO_VISION_MAXCOLORS
+	ftProVisionColor color[FTPRO_VISION_MAXCOLORS];
+	int minarea = 16;               // smaller blobs are ignored [pixels]
+
+	int lines = 0;                  // scan rows, 0..FTPRO_VISION_MAXLINES
+	double linetop = 0.5;           // first scan row (fraction of the height)
+	double linebottom = 0.95;       // last scan row
+	bool darkline = true;           // false: bright line on dark ground
+	int linethreshold = 0;          // 0 = automatic per row
+	int linecontrast = 32;          // automatic: minimum difference of brightest and darkest pixel
+	int minlinewidth = 3;           // [pixels]
+
+	bool histogram = true;
+	bool difference = true;
+	int diffthreshold = 24;         // a pixel changed by more is counted
+};
+
+struct ftProVisionBlob
+{
+	int    m_color;                 // index of the color class
+	INT32  m_area;                  // [pixels]
+	double m_x;                     // centroid
+	double m_y;
+	int    m_left, m_top, m_right, m_bottom;  // bounding box, limits included
+};
+
+struct ftProVisionLine
+{
+	int    m_row;                   // y of the scan row
+	bool   m_found;
+	double m_x;                     // center of the widest run
+	int    m_width;                 // [pixels]
+	int    m_threshold;             // used brightness threshold
+};
+
+/*!
+ * @brief Results of one image
+ */
+struct ftProVisionResult
+{
+	INT32  m_sequence;              // as in ftIF2013FrameInfo / ftIF2013PipelineFrame, -1 = unknown
+	INT32  m_framenumber;
+	std::chrono::steady_clock::time_point m_received;  // frame received
+	std::chrono::steady_clock::time_point m_done;      // results ready
+	double m_processtime;           // time of Process [ms]
+	int    m_width;
+	int    m_height;
+
+	int    m_blobcount;             // valid entries of m_blobs
+	int    m_blobtotal;             // blobs found (with minarea), can be more
+	ftProVisionBlob m_blobs[FTPRO_VISION_MAXBLOBS];
+
+	int    m_linecount;
+	ftProVisionLine m_lines[FTPRO_VISION_MAXLINES];
+
+	INT32  m_histogram[256];        // config.histogram
+	double m_mean;
+	int    m_min;
+	int    m_max;
+
+	bool   m_diffvalid;             // config.difference and a previous image of the same size
+	INT32  m_changed;               // pixels changed more than diffthreshold
+	double m_diffmean;              // mean absolute difference
+	int    m_diffleft, m_difftop, m_diffright, m_diffbottom;  // box of the changed pixels
+
+	// Age of the information at m_done [ms]
+	double GetLatency() const
+	{
+		return m_received.time_since_epoch().count() ? std::chrono::duration<double, std::milli>(m_done - m_received).count() : 0;
+	}
+};
+
+/*!
+ * @brief Image analysis for control loops, see the module description
+ */
+class ftProVision
+{
+public:
+	explicit ftProVision(const ftProVisionConfig& config = ftProVisionConfig());
+
+	/*!
+	 * @brief Change the configuration, not while Process runs
+	 */
+	void SetConfig(const ftProVisionConfig& config);
+	const ftProVisionConfig& GetConfig() const { return m_config; }
+
+	/*!
+	 * @brief Analyze an image
+	 * @return false for an unsupported format or size
+	 */
+	bool Process(const ftProImage& image, ftProVisionResult* result,
+		INT32 sequence = -1, INT32 framenumber = -1,
+		std::chrono::steady_clock::time_point received = std::chrono::steady_clock::time_point());
+	// With the frame number and time of a received frame
+	bool Process(const ftProImage& image, const ftIF2013FrameInfo& info, ftProVisionResult* result);
+	bool Process(const ftProImage& image, const ftIF2013PipelineFrame& frame, ftProVisionResult* result);
+
+	/*!
+	 * @brief Copy of the result of the last Process, may be called from any thread
+	 * @return false if there is none yet
+	 */
+	bool GetLatest(ftProVisionResult* result);
+
+	/*!
+	 * @brief The next image is not compared with the previous one
+	 */
+	void ResetDifference() { m_previousvalid = false; }
+
+protected:
+	// A run of mask pixels in a row, x1 excluded
+	struct Run
+	{
+		int x0, x1, y;
+	};
+	// Connected runs of one color class
+	struct ColorState
+	{
+		std::vector<Run> runs;
+		std::vector<int> parent;   // union-find over the runs
+		size_t prevstart, prevend; // runs of the previous row
+	};
+
+	void AddRuns(ColorState& state, const UINT8* mask, int width, int y);
+	int FindRoot(std::vector<int>& parent, int i);
+	void CollectBlobs(int color, ColorState& state, std::vector<ftProVisionBlob>& blobs);
+	void ScanLine(const UINT8* y, int width, int row, ftProVisionLine* line);
+
+	ftProVisionConfig m_config;
+	ColorState m_colors[FTPRO_VISION_MAXCOLORS];
+	std::vector<ftProVisionBlob> m_blobs;
+	std::vector<UINT8> m_rowy;     // rows split from YUYV / NV12
+	std::vector<UINT8> m_rowu;
+	std::vector<UINT8> m_rowv;
+	std::vector<UINT8> m_mask;
+	std::vector<UINT8> m_previous; // Y plane of the previous image
+	bool m_previousvalid;
+	int m_previouswidth;
+	int m_previousheight;
+
+	std::mutex m_latestmutex;
+	ftProVisionResult m_latest;
+	bool m_haslatest;
+};
+
+#endif // ftProInterface2013Vision_H
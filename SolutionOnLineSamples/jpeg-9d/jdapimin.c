@@ -211,6 +211,11 @@ default_decompress_parms (j_decompress_ptr cinfo)
   cinfo->enable_1pass_quant = FALSE;
   cinfo->enable_external_quant = FALSE;
   cinfo->enable_2pass_quant = FALSE;
+  /* Region of interest: the whole image. */
+  cinfo->roi_iMCU_col_start = 0;
+  cinfo->roi_iMCU_col_end = JPEG_MAX_DIMENSION;
+  cinfo->roi_iMCU_row_start = 0;
+  cinfo->roi_iMCU_row_end = JPEG_MAX_DIMENSION;
 }
 
 
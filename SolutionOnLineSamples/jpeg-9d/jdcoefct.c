@@ -151,12 +151,30 @@ decompress_onepass (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
   JDIMENSION MCU_col_num;	/* index of current MCU within row */
   JDIMENSION last_MCU_col = cinfo->MCUs_per_row - 1;
   JDIMENSION last_iMCU_row = cinfo->total_iMCU_rows - 1;
+  JDIMENSION roi_MCU_col_start, roi_MCU_col_end;
   int blkn, ci, xindex, yindex, yoffset, useful_width;
   JSAMPARRAY output_ptr;
   JDIMENSION start_col, output_col;
   jpeg_component_info *compptr;
   inverse_DCT_method_ptr inverse_DCT;
 
+  /* Region of interest in MCU columns.  In a noninterleaved scan an MCU is
+   * one block, an iMCU column has h_samp_factor of them.  Outside the ROI
+   * rows the range is empty.
+   */
+  roi_MCU_col_start = roi_MCU_col_end = 0;
+  if (cinfo->input_iMCU_row >= cinfo->roi_iMCU_row_start &&
+      cinfo->input_iMCU_row < cinfo->roi_iMCU_row_end) {
+    roi_MCU_col_start = cinfo->roi_iMCU_col_start;
+    roi_MCU_col_end = cinfo->roi_iMCU_col_end;
+    if (cinfo->comps_in_scan == 1) {
+      ci = cinfo->cur_comp_info[0]->h_samp_factor;
+      roi_MCU_col_start *= ci;
+      roi_MCU_col_end = roi_MCU_col_end > cinfo->MCUs_per_row / ci ?
+	cinfo->MCUs_per_row : roi_MCU_col_end * ci;
+    }
+  }
+
   /* Loop to process as much as one whole iMCU row */
   for (yoffset = coef->MCU_vert_offset; yoffset < coef->MCU_rows_per_iMCU_row;
        yoffset++) {
@@ -172,6 +190,9 @@ decompress_onepass (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
 	coef->MCU_ctr = MCU_col_num;
 	return JPEG_SUSPENDED;
       }
+      /* No dequantization and IDCT outside the region of interest */
+      if (MCU_col_num < roi_MCU_col_start || MCU_col_num >= roi_MCU_col_end)
+	continue;
       /* Determine where data should go in output_buf and do the IDCT thing.
        * We skip dummy blocks at the right and bottom edges (but blkn gets
        * incremented past them!).  Note the inner loop relies on having
@@ -318,7 +339,7 @@ decompress_data (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
 {
   my_coef_ptr coef = (my_coef_ptr) cinfo->coef;
   JDIMENSION last_iMCU_row = cinfo->total_iMCU_rows - 1;
-  JDIMENSION block_num;
+  JDIMENSION block_num, roi_block_start, roi_block_end;
   int ci, block_row, block_rows;
   JBLOCKARRAY buffer;
   JBLOCKROW buffer_ptr;
@@ -356,11 +377,23 @@ decompress_data (j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
     }
     inverse_DCT = cinfo->idct->inverse_DCT[ci];
     output_ptr = output_buf[ci];
+    /* Blocks of the region of interest, none outside the ROI rows */
+    roi_block_start = roi_block_end = 0;
+    if (cinfo->output_iMCU_row >= cinfo->roi_iMCU_row_start &&
+	cinfo->output_iMCU_row < cinfo->roi_iMCU_row_end) {
+      roi_block_start = cinfo->roi_iMCU_col_start * compptr->h_samp_factor;
+      roi_block_end = compptr->width_in_blocks;
+      if (cinfo->roi_iMCU_col_end < roi_block_end / compptr->h_samp_factor)
+	roi_block_end = cinfo->roi_iMCU_col_end * compptr->h_samp_factor;
+      if (roi_block_start > roi_block_end)
+	roi_block_start = roi_block_end;
+    }
     /* Loop over all DCT blocks to be processed. */
     for (block_row = 0; block_row < block_rows; block_row++) {
-      buffer_ptr = buffer[block_row];
-      output_col = 0;
-      for (block_num = 0; block_num < compptr->width_in_blocks; block_num++) {
+      buffer_ptr = buffer[block_row] + roi_block_start;
+      output_col = roi_block_start * compptr->DCT_h_scaled_size;
+      for (block_num = roi_block_start; block_num < roi_block_end;
+	   block_num++) {
 	(*inverse_DCT) (cinfo, compptr, (JCOEFPTR) buffer_ptr,
 			output_ptr, output_col);
 	buffer_ptr++;
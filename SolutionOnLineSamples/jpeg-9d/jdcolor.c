@@ -30,6 +30,9 @@ typedef struct {
   int * Cb_b_tab;		/* => table for Cb to B conversion */
   INT32 * Cr_g_tab;		/* => table for Cr to G conversion */
   INT32 * Cb_g_tab;		/* => table for Cb to G conversion */
+#ifdef COLOR_SIMD_SUPPORTED
+  jpeg_ycc_rgb_row_ptr ycc_rgb_row; /* SIMD row conversion, or NULL */
+#endif
 
   /* Private state for RGB->Y conversion */
   INT32 * rgb_y_tab;		/* => table for RGB to Y conversion */
@@ -220,7 +223,16 @@ ycc_rgb_convert (j_decompress_ptr cinfo,
     inptr2 = input_buf[2][input_row];
     input_row++;
     outptr = *output_buf++;
-    for (col = 0; col < num_cols; col++) {
+    col = 0;
+#ifdef COLOR_SIMD_SUPPORTED
+    /* Most of the row in SIMD steps, the C code does the rest */
+    if (cconvert->ycc_rgb_row != NULL) {
+      col = (*cconvert->ycc_rgb_row) (inptr0, inptr1, inptr2, outptr,
+				      num_cols, FALSE);
+      outptr += col * RGB_PIXELSIZE;
+    }
+#endif
+    for (; col < num_cols; col++) {
       y  = GETJSAMPLE(inptr0[col]);
       cb = GETJSAMPLE(inptr1[col]);
       cr = GETJSAMPLE(inptr2[col]);
@@ -238,6 +250,246 @@ ycc_rgb_convert (j_decompress_ptr cinfo,
 }
 
 
+#ifdef COLOR_SIMD_SUPPORTED
+
+/*
+ * SIMD YCbCr->RGB conversion for sYCC, see jpeg_ycc_rgb_row_ptr.
+ *
+ * We compute the same values as the table lookups above, using 16-bit
+ * multiply-adds with 32-bit sums.  The constants don't fit into 16 bits,
+ * so each is split into a multiple of 2^16, which gives a whole multiple
+ * of x, and a 16-bit rest:
+ *
+ *	R = Y + x_r + ((26345 * x_r + ONE_HALF) >> 16)
+ *	G = Y - x_r + ((-22553 * x_b + 18734 * x_r + ONE_HALF) >> 16)
+ *	B = Y + 2 * x_b + ((-14942 * x_b + ONE_HALF) >> 16)
+ *
+ * with FIX(1.402) = 65536 + 26345, FIX(0.714136286) = 65536 - 18734 and
+ * FIX(1.772) = 2 * 65536 - 14942.  ONE_HALF is added by the multiply-add
+ * as 2 * 16384.  The saturating pack to bytes does the range limiting.
+ */
+
+#include <immintrin.h>
+
+#define CR_R_REST	((int) (FIX(1.402) - 65536))
+#define CR_G_REST	((int) (65536 - FIX(0.714136286)))
+#define CB_G_FIX	((int) (- FIX(0.344136286)))
+#define CB_B_REST	((int) (FIX(1.772) - 2 * 65536))
+
+/* Two 16-bit multipliers for _mm_madd_epi16, a for the even lanes */
+#define MADD_PAIR(a,b)	((int) (((unsigned int) (a) & 0xFFFF) | \
+				((unsigned int) (b) << 16)))
+
+/* R, G, B of 8 pixels, all as 16-bit values */
+
+JSIMD_INLINE JSIMD_TARGET_SSE2 void
+ycc_rgb8_sse2 (__m128i y, __m128i cb, __m128i cr,
+	       __m128i * r, __m128i * g, __m128i * b)
+{
+  const __m128i center = _mm_set1_epi16(CENTERJSAMPLE);
+  const __m128i two = _mm_set1_epi16(2);
+  __m128i lo, hi;
+
+  cb = _mm_sub_epi16(cb, center);
+  cr = _mm_sub_epi16(cr, center);
+
+  lo = _mm_madd_epi16(_mm_unpacklo_epi16(cr, two),
+		      _mm_set1_epi32(MADD_PAIR(CR_R_REST, 16384)));
+  hi = _mm_madd_epi16(_mm_unpackhi_epi16(cr, two),
+		      _mm_set1_epi32(MADD_PAIR(CR_R_REST, 16384)));
+  *r = _mm_add_epi16(_mm_add_epi16(y, cr),
+		     _mm_packs_epi32(_mm_srai_epi32(lo, 16),
+				     _mm_srai_epi32(hi, 16)));
+
+  lo = _mm_madd_epi16(_mm_unpacklo_epi16(cb, cr),
+		      _mm_set1_epi32(MADD_PAIR(CB_G_FIX, CR_G_REST)));
+  hi = _mm_madd_epi16(_mm_unpackhi_epi16(cb, cr),
+		      _mm_set1_epi32(MADD_PAIR(CB_G_FIX, CR_G_REST)));
+  lo = _mm_add_epi32(lo, _mm_set1_epi32(ONE_HALF));
+  hi = _mm_add_epi32(hi, _mm_set1_epi32(ONE_HALF));
+  *g = _mm_sub_epi16(_mm_add_epi16(y, _mm_packs_epi32(_mm_srai_epi32(lo, 16),
+						      _mm_srai_epi32(hi, 16))),
+		     cr);
+
+  lo = _mm_madd_epi16(_mm_unpacklo_epi16(cb, two),
+		      _mm_set1_epi32(MADD_PAIR(CB_B_REST, 16384)));
+  hi = _mm_madd_epi16(_mm_unpackhi_epi16(cb, two),
+		      _mm_set1_epi32(MADD_PAIR(CB_B_REST, 16384)));
+  *b = _mm_add_epi16(_mm_add_epi16(y, _mm_add_epi16(cb, cb)),
+		     _mm_packs_epi32(_mm_srai_epi32(lo, 16),
+				     _mm_srai_epi32(hi, 16)));
+}
+
+/* Load Cb or Cr for 16 pixels */
+
+JSIMD_INLINE JSIMD_TARGET_SSE2 __m128i
+load_chroma16_sse2 (JSAMPROW inptr, JDIMENSION col, boolean chroma_h2)
+{
+  __m128i c;
+
+  if (! chroma_h2)
+    return _mm_loadu_si128((const __m128i *) (inptr + col));
+  /* Each chroma sample belongs to two pixels */
+  c = _mm_loadl_epi64((const __m128i *) (inptr + (col >> 1)));
+  return _mm_unpacklo_epi8(c, c);
+}
+
+METHODDEF(JDIMENSION) JSIMD_TARGET_SSE2
+ycc_rgb_row_sse2 (JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+		  JSAMPROW outptr, JDIMENSION num_cols, boolean chroma_h2)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i y, cb, cr, rlo, glo, blo, rhi, ghi, bhi;
+  JDIMENSION col;
+  int i;
+#if defined(_MSC_VER)
+  __declspec(align(16)) JSAMPLE rgb[3][16];
+#else
+  JSAMPLE rgb[3][16] __attribute__((aligned(16)));
+#endif
+
+  for (col = 0; col + 16 <= num_cols; col += 16) {
+    y = _mm_loadu_si128((const __m128i *) (inptr0 + col));
+    cb = load_chroma16_sse2(inptr1, col, chroma_h2);
+    cr = load_chroma16_sse2(inptr2, col, chroma_h2);
+    ycc_rgb8_sse2(_mm_unpacklo_epi8(y, zero), _mm_unpacklo_epi8(cb, zero),
+		  _mm_unpacklo_epi8(cr, zero), &rlo, &glo, &blo);
+    ycc_rgb8_sse2(_mm_unpackhi_epi8(y, zero), _mm_unpackhi_epi8(cb, zero),
+		  _mm_unpackhi_epi8(cr, zero), &rhi, &ghi, &bhi);
+    /* SSE2 has no byte shuffle: interleave in C */
+    _mm_store_si128((__m128i *) rgb[0], _mm_packus_epi16(rlo, rhi));
+    _mm_store_si128((__m128i *) rgb[1], _mm_packus_epi16(glo, ghi));
+    _mm_store_si128((__m128i *) rgb[2], _mm_packus_epi16(blo, bhi));
+    for (i = 0; i < 16; i++) {
+      outptr[RGB_RED]   = rgb[0][i];
+      outptr[RGB_GREEN] = rgb[1][i];
+      outptr[RGB_BLUE]  = rgb[2][i];
+      outptr += RGB_PIXELSIZE;
+    }
+  }
+  return col;
+}
+
+/* Byte positions of R, G, B in the three 16-byte blocks of 16 pixels */
+
+static const signed char rgb_shuffle[3][3][16] = {
+  { {  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1,  5 },
+    { -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1, -1 },
+    { -1, -1,  0, -1, -1,  1, -1, -1,  2, -1, -1,  3, -1, -1,  4, -1 } },
+  { { -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10, -1 },
+    {  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1, 10 },
+    { -1,  5, -1, -1,  6, -1, -1,  7, -1, -1,  8, -1, -1,  9, -1, -1 } },
+  { { -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1 },
+    { -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1 },
+    { 10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15 } }
+};
+
+/* Same as ycc_rgb8_sse2 for 16 pixels; the lanes are processed per
+ * 128-bit half, which keeps the pixel order.
+ */
+
+JSIMD_INLINE JSIMD_TARGET_AVX2 void
+ycc_rgb16_avx2 (__m256i y, __m256i cb, __m256i cr,
+		__m256i * r, __m256i * g, __m256i * b)
+{
+  const __m256i center = _mm256_set1_epi16(CENTERJSAMPLE);
+  const __m256i two = _mm256_set1_epi16(2);
+  __m256i lo, hi;
+
+  cb = _mm256_sub_epi16(cb, center);
+  cr = _mm256_sub_epi16(cr, center);
+
+  lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(cr, two),
+			 _mm256_set1_epi32(MADD_PAIR(CR_R_REST, 16384)));
+  hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(cr, two),
+			 _mm256_set1_epi32(MADD_PAIR(CR_R_REST, 16384)));
+  *r = _mm256_add_epi16(_mm256_add_epi16(y, cr),
+			_mm256_packs_epi32(_mm256_srai_epi32(lo, 16),
+					   _mm256_srai_epi32(hi, 16)));
+
+  lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(cb, cr),
+			 _mm256_set1_epi32(MADD_PAIR(CB_G_FIX, CR_G_REST)));
+  hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(cb, cr),
+			 _mm256_set1_epi32(MADD_PAIR(CB_G_FIX, CR_G_REST)));
+  lo = _mm256_add_epi32(lo, _mm256_set1_epi32(ONE_HALF));
+  hi = _mm256_add_epi32(hi, _mm256_set1_epi32(ONE_HALF));
+  *g = _mm256_sub_epi16(_mm256_add_epi16(y,
+			  _mm256_packs_epi32(_mm256_srai_epi32(lo, 16),
+					     _mm256_srai_epi32(hi, 16))),
+			cr);
+
+  lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(cb, two),
+			 _mm256_set1_epi32(MADD_PAIR(CB_B_REST, 16384)));
+  hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(cb, two),
+			 _mm256_set1_epi32(MADD_PAIR(CB_B_REST, 16384)));
+  *b = _mm256_add_epi16(_mm256_add_epi16(y, _mm256_add_epi16(cb, cb)),
+			_mm256_packs_epi32(_mm256_srai_epi32(lo, 16),
+					   _mm256_srai_epi32(hi, 16)));
+}
+
+/* Pack 16 16-bit values to bytes */
+
+JSIMD_INLINE JSIMD_TARGET_AVX2 __m128i
+pack16_avx2 (__m256i v)
+{
+  /* packus works per 128-bit half: bring the two 8-byte results together */
+  return _mm256_castsi256_si128(
+    _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xD8));
+}
+
+METHODDEF(JDIMENSION) JSIMD_TARGET_AVX2
+ycc_rgb_row_avx2 (JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+		  JSAMPROW outptr, JDIMENSION num_cols, boolean chroma_h2)
+{
+  __m128i mask[3][3], r8, g8, b8;
+  __m256i y, cb, cr, r, g, b;
+  JDIMENSION col;
+  int k;
+
+  for (k = 0; k < 9; k++)
+    mask[k / 3][k % 3] =
+      _mm_loadu_si128((const __m128i *) rgb_shuffle[k / 3][k % 3]);
+
+  for (col = 0; col + 16 <= num_cols; col += 16) {
+    y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (inptr0 + col)));
+    if (chroma_h2) {
+      __m128i c;
+      c = _mm_loadl_epi64((const __m128i *) (inptr1 + (col >> 1)));
+      cb = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(c, c));
+      c = _mm_loadl_epi64((const __m128i *) (inptr2 + (col >> 1)));
+      cr = _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(c, c));
+    } else {
+      cb = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (inptr1 + col)));
+      cr = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (inptr2 + col)));
+    }
+    ycc_rgb16_avx2(y, cb, cr, &r, &g, &b);
+    r8 = pack16_avx2(r);
+    g8 = pack16_avx2(g);
+    b8 = pack16_avx2(b);
+    for (k = 0; k < 3; k++) {
+      _mm_storeu_si128((__m128i *) outptr,
+		       _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r8, mask[k][0]),
+						 _mm_shuffle_epi8(g8, mask[k][1])),
+				    _mm_shuffle_epi8(b8, mask[k][2])));
+      outptr += 16;
+    }
+  }
+  return col;
+}
+
+GLOBAL(jpeg_ycc_rgb_row_ptr)
+jpeg_ycc_rgb_row_simd (void)
+{
+  if (jpeg_simd_support() & JSIMD_AVX2)
+    return ycc_rgb_row_avx2;
+  if (jpeg_simd_support() & JSIMD_SSE2)
+    return ycc_rgb_row_sse2;
+  return NULL;
+}
+
+#endif /* COLOR_SIMD_SUPPORTED */
+
+
 /**************** Cases other than YCC -> RGB ****************/
 
 
@@ -574,6 +826,9 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
     ((j_common_ptr) cinfo, JPOOL_IMAGE, SIZEOF(my_color_deconverter));
   cinfo->cconvert = &cconvert->pub;
   cconvert->pub.start_pass = start_pass_dcolor;
+#ifdef COLOR_SIMD_SUPPORTED
+  cconvert->ycc_rgb_row = NULL;
+#endif
 
   /* Make sure num_components agrees with jpeg_color_space */
   switch (cinfo->jpeg_color_space) {
@@ -651,6 +906,10 @@ jinit_color_deconverter (j_decompress_ptr cinfo)
     case JCS_YCbCr:
       cconvert->pub.color_convert = ycc_rgb_convert;
       build_ycc_rgb_table(cinfo);
+#ifdef COLOR_SIMD_SUPPORTED
+      /* The SIMD code has the sYCC constants built in */
+      cconvert->ycc_rgb_row = jpeg_ycc_rgb_row_simd();
+#endif
       break;
     case JCS_BG_YCC:
       cconvert->pub.color_convert = ycc_rgb_convert;
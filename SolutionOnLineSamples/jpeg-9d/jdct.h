@@ -338,6 +338,42 @@ EXTERN(void) jpeg_idct_1x2
 	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
 
 
+/*
+ * SIMD versions of the 8x8 islow and ifast IDCTs for x86/x64 (SSE2, AVX2).
+ * They compute exactly the same output as the C versions and are selected
+ * at run time by jddctmgr.c, depending on the CPU (see JSIMD_SUPPORTED in
+ * jpegint.h).  Define NO_IDCT_SIMD to use the C versions only.
+ */
+
+#if defined(JSIMD_SUPPORTED) && !defined(NO_IDCT_SIMD) && DCTSIZE == 8
+#define IDCT_SIMD_SUPPORTED
+#endif
+
+#ifdef IDCT_SIMD_SUPPORTED
+
+#ifdef NEED_SHORT_EXTERNAL_NAMES
+#define jpeg_idct_islow_sse2	jRDislowS
+#define jpeg_idct_islow_avx2	jRDislowA
+#define jpeg_idct_ifast_sse2	jRDifastS
+#define jpeg_idct_ifast_avx2	jRDifastA
+#endif /* NEED_SHORT_EXTERNAL_NAMES */
+
+EXTERN(void) jpeg_idct_islow_sse2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jpeg_idct_islow_avx2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jpeg_idct_ifast_sse2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+EXTERN(void) jpeg_idct_ifast_avx2
+    JPP((j_decompress_ptr cinfo, jpeg_component_info * compptr,
+	 JCOEFPTR coef_block, JSAMPARRAY output_buf, JDIMENSION output_col));
+
+#endif /* IDCT_SIMD_SUPPORTED */
+
+
 /*
  * Macros for handling fixed-point arithmetic; these are used by many
  * but not all of the DCT/IDCT modules.
@@ -407,3 +443,269 @@ EXTERN(void) jpeg_idct_1x2
 #define ISHIFT_TEMPS
 #define IRIGHT_SHIFT(x,shft)	((x) >> (shft))
 #endif
+
+
+#ifdef IDCT_SIMD_SUPPORTED
+
+/*
+ * Helpers for the SIMD IDCTs.
+ * The 1-D passes work on 32-bit lanes, so they can use the same arithmetic
+ * as the C code: one vector holds one row of 4 (SSE2) or 8 (AVX2) columns.
+ * The functions for AVX2 are compiled for that instruction set only;
+ * jddctmgr.c checks the CPU before they are used.
+ */
+
+#define IDCT_SIMD_INLINE  JSIMD_INLINE
+#define IDCT_TARGET_SSE2  JSIMD_TARGET_SSE2
+#define IDCT_TARGET_AVX2  JSIMD_TARGET_AVX2
+
+#include <immintrin.h>
+
+/* 32 x 32 -> 32 bit multiply, SSE2 has only the unsigned 32 -> 64 bit one.
+ * The low 32 bits of the product are the same for signed values.
+ */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 __m128i
+idct_mullo_sse2 (__m128i a, __m128i b)
+{
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+			    _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+/* Test whether all AC coefficients of the block are zero */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 int
+idct_ac_zero_sse2 (JCOEFPTR coef_block)
+{
+  const __m128i * in = (const __m128i *) coef_block;
+  __m128i acc;
+
+  /* Row 0 without the DC coefficient */
+  acc = _mm_srli_si128(_mm_loadu_si128(in), 2);
+  acc = _mm_or_si128(acc, _mm_loadu_si128(in + 1));
+  acc = _mm_or_si128(acc, _mm_loadu_si128(in + 2));
+  acc = _mm_or_si128(acc, _mm_loadu_si128(in + 3));
+  acc = _mm_or_si128(acc, _mm_loadu_si128(in + 4));
+  acc = _mm_or_si128(acc, _mm_loadu_si128(in + 5));
+  acc = _mm_or_si128(acc, _mm_loadu_si128(in + 6));
+  acc = _mm_or_si128(acc, _mm_loadu_si128(in + 7));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) == 0xFFFF;
+}
+
+/* Test whether all count vectors are within -limit..limit */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 int
+idct_in_range_sse2 (const __m128i * v, int count, int limit)
+{
+  __m128i max = _mm_set1_epi32(limit);
+  __m128i min = _mm_set1_epi32(-limit);
+  __m128i acc = _mm_setzero_si128();
+  int i;
+
+  for (i = 0; i < count; i++)
+    acc = _mm_or_si128(acc, _mm_or_si128(_mm_cmpgt_epi32(v[i], max),
+					 _mm_cmplt_epi32(v[i], min)));
+  return _mm_movemask_epi8(acc) == 0;
+}
+
+/* Load and dequantize one row of coefficients: columns 0-3 and 4-7 */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 void
+idct_load_sse2 (JCOEFPTR inptr, MULTIPLIER * quantptr, __m128i * lo, __m128i * hi)
+{
+  __m128i coef = _mm_loadu_si128((const __m128i *) inptr);
+
+  *lo = idct_mullo_sse2(_mm_srai_epi32(_mm_unpacklo_epi16(coef, coef), 16),
+			_mm_loadu_si128((const __m128i *) quantptr));
+  *hi = idct_mullo_sse2(_mm_srai_epi32(_mm_unpackhi_epi16(coef, coef), 16),
+			_mm_loadu_si128((const __m128i *) (quantptr + 4)));
+}
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 void
+idct_transpose4x4_sse2 (__m128i * r)
+{
+  __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+  __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+  __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+  __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+
+  r[0] = _mm_unpacklo_epi64(t0, t1);
+  r[1] = _mm_unpackhi_epi64(t0, t1);
+  r[2] = _mm_unpacklo_epi64(t2, t3);
+  r[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* Transpose the work array: lo/hi[row] (columns 0-3/4-7) become
+ * lo/hi[column] (rows 0-3/4-7).
+ */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 void
+idct_transpose8x8_sse2 (__m128i * lo, __m128i * hi)
+{
+  int i;
+  __m128i t;
+
+  idct_transpose4x4_sse2(lo);
+  idct_transpose4x4_sse2(lo + 4);
+  idct_transpose4x4_sse2(hi);
+  idct_transpose4x4_sse2(hi + 4);
+  for (i = 0; i < 4; i++) {
+    t = lo[4 + i];
+    lo[4 + i] = hi[i];
+    hi[i] = t;
+  }
+}
+
+/* Final descale and range limit: the same as the table lookup
+ * range_limit[(int) RIGHT_SHIFT(x, shift) & RANGE_MASK] of the C code,
+ * the result still needs the unsigned saturation to 0..MAXJSAMPLE.
+ */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 __m128i
+idct_range_sse2 (__m128i x, int shift)
+{
+  x = _mm_sra_epi32(x, _mm_cvtsi32_si128(shift));
+  x = _mm_and_si128(x, _mm_set1_epi32(RANGE_MASK));
+  return _mm_sub_epi32(x, _mm_set1_epi32(RANGE_SUBSET));
+}
+
+/* Store the 8x8 block, col[column] holds the 16-bit samples of rows 0-7 */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 void
+idct_store_sse2 (__m128i * col, JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m128i a0, a1, a2, a3, a4, a5, a6, a7;
+  __m128i b0, b1, b2, b3, b4, b5, b6, b7;
+  __m128i r01, r23, r45, r67;
+
+  a0 = _mm_unpacklo_epi16(col[0], col[1]);
+  a1 = _mm_unpackhi_epi16(col[0], col[1]);
+  a2 = _mm_unpacklo_epi16(col[2], col[3]);
+  a3 = _mm_unpackhi_epi16(col[2], col[3]);
+  a4 = _mm_unpacklo_epi16(col[4], col[5]);
+  a5 = _mm_unpackhi_epi16(col[4], col[5]);
+  a6 = _mm_unpacklo_epi16(col[6], col[7]);
+  a7 = _mm_unpackhi_epi16(col[6], col[7]);
+  b0 = _mm_unpacklo_epi32(a0, a2);	/* rows 0, 1 of columns 0-3 */
+  b1 = _mm_unpackhi_epi32(a0, a2);	/* rows 2, 3 */
+  b2 = _mm_unpacklo_epi32(a4, a6);	/* rows 0, 1 of columns 4-7 */
+  b3 = _mm_unpackhi_epi32(a4, a6);
+  b4 = _mm_unpacklo_epi32(a1, a3);	/* rows 4, 5 of columns 0-3 */
+  b5 = _mm_unpackhi_epi32(a1, a3);
+  b6 = _mm_unpacklo_epi32(a5, a7);
+  b7 = _mm_unpackhi_epi32(a5, a7);
+  r01 = _mm_packus_epi16(_mm_unpacklo_epi64(b0, b2), _mm_unpackhi_epi64(b0, b2));
+  r23 = _mm_packus_epi16(_mm_unpacklo_epi64(b1, b3), _mm_unpackhi_epi64(b1, b3));
+  r45 = _mm_packus_epi16(_mm_unpacklo_epi64(b4, b6), _mm_unpackhi_epi64(b4, b6));
+  r67 = _mm_packus_epi16(_mm_unpacklo_epi64(b5, b7), _mm_unpackhi_epi64(b5, b7));
+  _mm_storel_epi64((__m128i *) (output_buf[0] + output_col), r01);
+  _mm_storel_epi64((__m128i *) (output_buf[1] + output_col), _mm_srli_si128(r01, 8));
+  _mm_storel_epi64((__m128i *) (output_buf[2] + output_col), r23);
+  _mm_storel_epi64((__m128i *) (output_buf[3] + output_col), _mm_srli_si128(r23, 8));
+  _mm_storel_epi64((__m128i *) (output_buf[4] + output_col), r45);
+  _mm_storel_epi64((__m128i *) (output_buf[5] + output_col), _mm_srli_si128(r45, 8));
+  _mm_storel_epi64((__m128i *) (output_buf[6] + output_col), r67);
+  _mm_storel_epi64((__m128i *) (output_buf[7] + output_col), _mm_srli_si128(r67, 8));
+}
+
+/* Block with only a DC coefficient: all samples are the same */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 void
+idct_fill_sse2 (JSAMPLE value, JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m128i fill = _mm_set1_epi8((char) value);
+  int ctr;
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    _mm_storel_epi64((__m128i *) (output_buf[ctr] + output_col), fill);
+}
+
+/* Test whether all count vectors are within -limit..limit */
+
+IDCT_SIMD_INLINE IDCT_TARGET_AVX2 int
+idct_in_range_avx2 (const __m256i * v, int count, int limit)
+{
+  __m256i max = _mm256_set1_epi32(limit);
+  __m256i min = _mm256_set1_epi32(-limit);
+  __m256i acc = _mm256_setzero_si256();
+  int i;
+
+  for (i = 0; i < count; i++)
+    acc = _mm256_or_si256(acc, _mm256_or_si256(_mm256_cmpgt_epi32(v[i], max),
+					       _mm256_cmpgt_epi32(min, v[i])));
+  return _mm256_testz_si256(acc, acc);
+}
+
+/* Load and dequantize one row of coefficients */
+
+IDCT_SIMD_INLINE IDCT_TARGET_AVX2 __m256i
+idct_load_avx2 (JCOEFPTR inptr, MULTIPLIER * quantptr)
+{
+  return _mm256_mullo_epi32(
+    _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) inptr)),
+    _mm256_loadu_si256((const __m256i *) quantptr));
+}
+
+IDCT_SIMD_INLINE IDCT_TARGET_AVX2 void
+idct_transpose8x8_avx2 (__m256i * r)
+{
+  __m256i t0, t1, t2, t3, t4, t5, t6, t7;
+  __m256i u0, u1, u2, u3, u4, u5, u6, u7;
+
+  t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+  t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+  t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+  t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+  t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+  t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+  t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+  t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+  u0 = _mm256_unpacklo_epi64(t0, t2);	/* columns 0, 4 of rows 0-3 */
+  u1 = _mm256_unpackhi_epi64(t0, t2);	/* columns 1, 5 */
+  u2 = _mm256_unpacklo_epi64(t1, t3);	/* columns 2, 6 */
+  u3 = _mm256_unpackhi_epi64(t1, t3);	/* columns 3, 7 */
+  u4 = _mm256_unpacklo_epi64(t4, t6);	/* the same for rows 4-7 */
+  u5 = _mm256_unpackhi_epi64(t4, t6);
+  u6 = _mm256_unpacklo_epi64(t5, t7);
+  u7 = _mm256_unpackhi_epi64(t5, t7);
+  r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+  r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+  r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+  r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+  r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+  r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+  r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+  r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/* Final descale and range limit of the columns and store, see above.
+ * The store uses 128-bit instructions only, so clear the upper halves
+ * first to avoid the AVX to SSE transition penalty.
+ */
+
+IDCT_SIMD_INLINE IDCT_TARGET_AVX2 void
+idct_store_avx2 (__m256i * col, int shift,
+		 JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  __m256i mask = _mm256_set1_epi32(RANGE_MASK);
+  __m256i subset = _mm256_set1_epi32(RANGE_SUBSET);
+  __m128i lo[DCTSIZE], hi[DCTSIZE];
+  __m256i x;
+  int ctr;
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    x = _mm256_sra_epi32(col[ctr], _mm_cvtsi32_si128(shift));
+    x = _mm256_sub_epi32(_mm256_and_si256(x, mask), subset);
+    lo[ctr] = _mm256_castsi256_si128(x);
+    hi[ctr] = _mm256_extracti128_si256(x, 1);
+  }
+  _mm256_zeroupper();
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    lo[ctr] = _mm_packs_epi32(lo[ctr], hi[ctr]);
+  idct_store_sse2(lo, output_buf, output_col);
+}
+
+#endif /* IDCT_SIMD_SUPPORTED */
@@ -80,6 +80,27 @@ typedef union {
 #endif
 
 
+#ifdef IDCT_SIMD_SUPPORTED
+
+#define IDCT_SIMD_SSE2  JSIMD_SSE2
+#define IDCT_SIMD_AVX2  JSIMD_AVX2
+
+/*
+ * Determine which SIMD IDCTs can be used, see jpeg_simd_support.
+ * The SIMD IDCTs read the multiplier tables as 32-bit values.
+ */
+
+LOCAL(int)
+idct_simd_support (void)
+{
+  if (SIZEOF(ISLOW_MULT_TYPE) == 4 && SIZEOF(IFAST_MULT_TYPE) == 4)
+    return jpeg_simd_support();
+  return 0;
+}
+
+#endif /* IDCT_SIMD_SUPPORTED */
+
+
 /*
  * Prepare for an output pass.
  * Here we select the proper IDCT routine for each component and build
@@ -231,12 +252,24 @@ start_pass (j_decompress_ptr cinfo)
 #ifdef DCT_ISLOW_SUPPORTED
       case JDCT_ISLOW:
 	method_ptr = jpeg_idct_islow;
+#ifdef IDCT_SIMD_SUPPORTED
+	if (idct_simd_support() & IDCT_SIMD_AVX2)
+	  method_ptr = jpeg_idct_islow_avx2;
+	else if (idct_simd_support() & IDCT_SIMD_SSE2)
+	  method_ptr = jpeg_idct_islow_sse2;
+#endif
 	method = JDCT_ISLOW;
 	break;
 #endif
 #ifdef DCT_IFAST_SUPPORTED
       case JDCT_IFAST:
 	method_ptr = jpeg_idct_ifast;
+#ifdef IDCT_SIMD_SUPPORTED
+	if (idct_simd_support() & IDCT_SIMD_AVX2)
+	  method_ptr = jpeg_idct_ifast_avx2;
+	else if (idct_simd_support() & IDCT_SIMD_SSE2)
+	  method_ptr = jpeg_idct_ifast_sse2;
+#endif
 	method = JDCT_IFAST;
 	break;
 #endif
@@ -24,6 +24,18 @@
 /* Derived data constructed for each Huffman table */
 
 #define HUFF_LOOKAHEAD	8	/* # of bits of lookahead */
+#define HUFF_FAST_BITS	10	/* # of bits of lookahead in decode_mcu_fast */
+
+/* decode_mcu_fast, with a 64-bit bit buffer on the 64-bit targets we know */
+#ifndef NO_HUFF_FAST_DECODE
+#define HUFF_FAST_DECODE
+#if defined(_WIN64) || defined(__x86_64__) || defined(__aarch64__)
+#define HUFF_FAST_BIT_BUF_64
+#endif
+#endif
+
+#define FAST_NBITS	0x1F	/* fast_look: # bits to drop */
+#define FAST_VALUE	0x20	/* fast_look: magnitude bits are included */
 
 typedef struct {
   /* Basic tables: (element [0] of each array is unused) */
@@ -45,6 +57,17 @@ typedef struct {
    */
   int look_nbits[1<<HUFF_LOOKAHEAD]; /* # bits, or 0 if too long */
   UINT8 look_sym[1<<HUFF_LOOKAHEAD]; /* symbol, or unused */
+
+#ifdef HUFF_FAST_DECODE
+  /* Wide lookahead table for decode_mcu_fast: indexed by the next
+   * HUFF_FAST_BITS bits.  If the code and its magnitude bits together are
+   * no more than HUFF_FAST_BITS bits long, the entry has the FAST_VALUE
+   * flag and holds the extended coefficient value too; else if just the
+   * code fits, we get its length and symbol only.
+   */
+  INT32 fast_look[1<<HUFF_FAST_BITS]; /* value << 16 | symbol << 8 |
+				       * flag | # bits, or 0 if too long */
+#endif
 } d_derived_tbl;
 
 
@@ -66,16 +89,22 @@ typedef struct {
  * necessary.
  */
 
-typedef INT32 bit_buf_type;	/* type of bit-extraction buffer */
-#define BIT_BUF_SIZE  32	/* size of buffer in bits */
-
 /* If long is > 32 bits on your machine, and shifting/masking longs is
  * reasonably fast, making bit_buf_type be long and setting BIT_BUF_SIZE
  * appropriately should be a win.  Unfortunately we can't define the size
  * with something like  #define BIT_BUF_SIZE (sizeof(bit_buf_type)*8)
  * because not all machines measure sizeof in 8-bit bytes.
+ * With HUFF_FAST_BIT_BUF_64 we use a 64-bit buffer (size_t is 64 bits there).
  */
 
+#ifdef HUFF_FAST_BIT_BUF_64
+typedef size_t bit_buf_type;	/* type of bit-extraction buffer */
+#define BIT_BUF_SIZE  64	/* size of buffer in bits */
+#else
+typedef INT32 bit_buf_type;	/* type of bit-extraction buffer */
+#define BIT_BUF_SIZE  32	/* size of buffer in bits */
+#endif
+
 typedef struct {		/* Bitreading state saved across MCUs */
   bit_buf_type get_buffer;	/* current bit-extraction buffer */
   int bits_left;		/* # of unused bits in it */
@@ -423,6 +452,45 @@ jpeg_make_d_derived_tbl (j_decompress_ptr cinfo, boolean isDC, int tblno,
     }
   }
 
+#ifdef HUFF_FAST_DECODE
+  /* Same for the wide lookahead table, but if the magnitude bits which
+   * follow the code fit as well, we also store the extended value.
+   * The symbol's low 4 bits are the # of magnitude bits (DC symbols are
+   * 0..15, see below).  This is done for every scan, so the loops only
+   * fill runs of equal entries.
+   */
+
+  MEMZERO(dtbl->fast_look, SIZEOF(dtbl->fast_look));
+
+  p = 0;
+  for (l = 1; l <= HUFF_FAST_BITS; l++) {
+    for (i = 1; i <= (int) htbl->bits[l]; i++, p++) {
+      int sym = htbl->huffval[p];
+      int s = sym & 15;
+      INT32 * look = dtbl->fast_look + (huffcode[p] << (HUFF_FAST_BITS-l));
+      INT32 entry;
+      if (l + s <= HUFF_FAST_BITS) {
+	/* Each of the 2^s magnitude values repeats for all bit sequences
+	 * following it.
+	 */
+	int m, v;
+	for (m = 0; m < (1 << s); m++) {
+	  v = m;
+	  if (s && v < (1 << (s-1)))
+	    v -= (1 << s) - 1;
+	  entry = (INT32) v * 65536 + ((sym << 8) | FAST_VALUE | (l + s));
+	  for (ctr = 1 << (HUFF_FAST_BITS-l-s); ctr > 0; ctr--)
+	    *look++ = entry;
+	}
+      } else {
+	entry = (INT32) ((sym << 8) | l);
+	for (ctr = 1 << (HUFF_FAST_BITS-l); ctr > 0; ctr--)
+	  *look++ = entry;
+      }
+    }
+  }
+#endif
+
   /* Validate symbols as being reasonable.
    * For AC tables, we make no check, but accept all byte values 0..255.
    * For DC tables, we require the symbols to be in range 0..15.
@@ -1195,6 +1263,185 @@ decode_mcu_sub (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 }
 
 
+#ifdef HUFF_FAST_DECODE
+
+/*
+ * Fast path of decode_mcu for the common case, an MCU in the middle of the
+ * compressed data.  Before each symbol we make sure that get_buffer holds
+ * FAST_MIN_BITS bits.  With the 64-bit buffer that is enough for the
+ * longest code and its magnitude bits; the 32-bit buffer only holds the
+ * longest code for sure, so it may be refilled once more for the magnitude
+ * bits (FAST_FILL_MAGNITUDE).
+ * The refill needs no calls and no checks per byte: it reads whole bytes
+ * until get_buffer is full, which is at most FAST_MAX_BYTES bytes
+ * including stuffed zeroes and the byte after an FF.  A symbol is decoded
+ * with one lookup in the wide lookahead table, mostly including its value.
+ *
+ * If we come close to the end of the buffer or find a marker or a bad
+ * code, we give up and return FALSE without saving any state; decode_mcu
+ * then decodes the MCU the normal way.  The coefficients we have already
+ * stored are the same ones that path stores.
+ */
+
+#ifdef HUFF_FAST_BIT_BUF_64
+#define FAST_MIN_BITS	32	/* 16 bits code + 15 magnitude bits */
+#define FAST_MAX_BYTES	16	/* 8 bytes, each may be FF 00 */
+#define FAST_FILL_MAGNITUDE(nb,failaction)
+#else
+#define FAST_MIN_BITS	16	/* 16 bits code */
+#define FAST_MAX_BYTES	8	/* 4 bytes, each may be FF 00 */
+#define FAST_FILL_MAGNITUDE(nb,failaction) \
+{ if (bits_left < (nb)) FAST_FILL_BIT_BUFFER(failaction) }
+#endif
+
+#define FAST_FILL_BIT_BUFFER(failaction) \
+{ if (bits_left < FAST_MIN_BITS) { \
+    if (buffer_end - next_input_byte < FAST_MAX_BYTES) { failaction; } \
+    do { \
+      register int c = GETJOCTET(*next_input_byte++); \
+      if (c == 0xFF) { \
+	if (GETJOCTET(*next_input_byte) != 0) { failaction; } \
+	next_input_byte++; \
+      } \
+      get_buffer = (get_buffer << 8) | c; \
+      bits_left += 8; \
+    } while (bits_left <= BIT_BUF_SIZE - 8); \
+  } \
+}
+
+/* Decode a symbol into sym and its extended value into val
+ * (0 if the symbol has no magnitude bits).
+ */
+
+#define FAST_HUFF_DECODE(sym,val,htbl,failaction) \
+{ register INT32 look; register int nb; \
+  look = htbl->fast_look[PEEK_BITS(HUFF_FAST_BITS)]; \
+  if (look & FAST_VALUE) { \
+    DROP_BITS((int) look & FAST_NBITS); \
+    sym = ((int) look >> 8) & 0xFF; \
+    val = (int) RIGHT_SHIFT(look, 16); \
+  } else { \
+    if (look) { \
+      DROP_BITS((int) look & FAST_NBITS); \
+      sym = (int) look >> 8; \
+    } else { \
+      /* Code is longer than HUFF_FAST_BITS, see jpeg_huff_decode */ \
+      register INT32 code; \
+      nb = HUFF_FAST_BITS+1; \
+      code = GET_BITS(nb); \
+      while (code > htbl->maxcode[nb]) { \
+	code = (code << 1) | GET_BITS(1); \
+	nb++; \
+      } \
+      if (nb > 16) { failaction; } \
+      sym = htbl->pub->huffval[(int) (code + htbl->valoffset[nb])]; \
+    } \
+    if ((nb = sym & 15) != 0) { \
+      FAST_FILL_MAGNITUDE(nb, failaction); \
+      val = GET_BITS(nb); \
+      val = HUFF_EXTEND(val, nb); \
+    } else \
+      val = 0; \
+  } \
+}
+
+LOCAL(boolean)
+decode_mcu_fast (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
+{
+  huff_entropy_ptr entropy = (huff_entropy_ptr) cinfo->entropy;
+  register bit_buf_type get_buffer = entropy->bitstate.get_buffer;
+  register int bits_left = entropy->bitstate.bits_left;
+  register const JOCTET * next_input_byte = cinfo->src->next_input_byte;
+  const JOCTET * buffer_end = next_input_byte + cinfo->src->bytes_in_buffer;
+  int blkn;
+  savable_state state;
+  SHIFT_TEMPS
+
+  if (cinfo->unread_marker != 0)
+    return FALSE;
+
+  ASSIGN_STATE(state, entropy->saved);
+
+  /* Outer loop handles each block in the MCU */
+
+  for (blkn = 0; blkn < cinfo->blocks_in_MCU; blkn++) {
+    JBLOCKROW block = MCU_data[blkn];
+    d_derived_tbl * htbl;
+    register int s, k, r, v;
+    int coef_limit, ci;
+
+    /* Section F.2.2.1: decode the DC coefficient difference */
+    FAST_FILL_BIT_BUFFER(return FALSE);
+    htbl = entropy->dc_cur_tbls[blkn];
+    FAST_HUFF_DECODE(s, v, htbl, return FALSE);
+
+    htbl = entropy->ac_cur_tbls[blkn];
+    k = 1;
+    coef_limit = entropy->coef_limit[blkn];
+    if (coef_limit) {
+      ci = cinfo->MCU_membership[blkn];
+      v += state.last_dc_val[ci];
+      state.last_dc_val[ci] = v;
+      (*block)[0] = (JCOEF) v;
+
+      /* Section F.2.2.2: decode the AC coefficients */
+      for (; k < coef_limit; k++) {
+	FAST_FILL_BIT_BUFFER(return FALSE);
+	FAST_HUFF_DECODE(s, v, htbl, return FALSE);
+
+	r = s >> 4;
+	s &= 15;
+
+	if (s) {
+	  k += r;
+	  (*block)[jpeg_natural_order[k]] = (JCOEF) v;
+	} else {
+	  if (r != 15)
+	    goto EndOfBlock;
+	  k += 15;
+	}
+      }
+    }
+
+    /* In this path we just discard the values */
+    for (; k < DCTSIZE2; k++) {
+      FAST_FILL_BIT_BUFFER(return FALSE);
+      FAST_HUFF_DECODE(s, v, htbl, return FALSE);
+
+      r = s >> 4;
+      s &= 15;
+
+      if (s) {
+	k += r;
+      } else {
+	if (r != 15)
+	  break;
+	k += 15;
+      }
+    }
+
+    EndOfBlock: ;
+  }
+
+  /* Completed MCU, so update state */
+  cinfo->src->next_input_byte = next_input_byte;
+  cinfo->src->bytes_in_buffer = (size_t) (buffer_end - next_input_byte);
+  entropy->bitstate.get_buffer = get_buffer;
+  entropy->bitstate.bits_left = bits_left;
+  ASSIGN_STATE(entropy->saved, state);
+
+  return TRUE;
+}
+
+#define DECODE_MCU_FAST(cinfo,MCU_data)  decode_mcu_fast(cinfo, MCU_data)
+
+#else
+
+#define DECODE_MCU_FAST(cinfo,MCU_data)  FALSE
+
+#endif /* HUFF_FAST_DECODE */
+
+
 /*
  * Decode one MCU's worth of Huffman-compressed coefficients,
  * full-size blocks.
@@ -1217,8 +1464,9 @@ decode_mcu (j_decompress_ptr cinfo, JBLOCKROW *MCU_data)
 
   /* If we've run out of data, just leave the MCU set to zeroes.
    * This way, we return uniform gray for the remainder of the segment.
+   * Most MCUs are done by the fast path, see decode_mcu_fast.
    */
-  if (! entropy->insufficient_data) {
+  if (! entropy->insufficient_data && ! DECODE_MCU_FAST(cinfo, MCU_data)) {
 
     /* Load up working state */
     BITREAD_LOAD_STATE(cinfo, entropy->bitstate);
@@ -61,6 +61,9 @@ typedef struct {
   int * Cb_b_tab;		/* => table for Cb to B conversion */
   INT32 * Cr_g_tab;		/* => table for Cr to G conversion */
   INT32 * Cb_g_tab;		/* => table for Cb to G conversion */
+#ifdef COLOR_SIMD_SUPPORTED
+  jpeg_ycc_rgb_row_ptr ycc_rgb_row; /* SIMD row conversion, or NULL */
+#endif
 
   /* For 2:1 vertical sampling, we produce two output rows at a time.
    * We need a "spare" row buffer to hold the second output row if the
@@ -268,7 +271,7 @@ h2v1_merged_upsample (j_decompress_ptr cinfo,
   int cb, cr;
   register JSAMPROW outptr;
   JSAMPROW inptr0, inptr1, inptr2;
-  JDIMENSION col;
+  JDIMENSION col, done;
   /* copy these pointers into registers if possible */
   register JSAMPLE * range_limit = cinfo->sample_range_limit;
   int * Crrtab = upsample->Cr_r_tab;
@@ -281,8 +284,20 @@ h2v1_merged_upsample (j_decompress_ptr cinfo,
   inptr1 = input_buf[1][in_row_group_ctr];
   inptr2 = input_buf[2][in_row_group_ctr];
   outptr = output_buf[0];
+  done = 0;
+#ifdef COLOR_SIMD_SUPPORTED
+  /* Most of the row in SIMD steps (an even number of pixels) */
+  if (upsample->ycc_rgb_row != NULL) {
+    done = (*upsample->ycc_rgb_row) (inptr0, inptr1, inptr2, outptr,
+				     cinfo->output_width, TRUE);
+    inptr0 += done;
+    inptr1 += done >> 1;
+    inptr2 += done >> 1;
+    outptr += done * RGB_PIXELSIZE;
+  }
+#endif
   /* Loop for each pair of output pixels */
-  for (col = cinfo->output_width >> 1; col > 0; col--) {
+  for (col = (cinfo->output_width - done) >> 1; col > 0; col--) {
     /* Do the chroma part of the calculation */
     cb = GETJSAMPLE(*inptr1++);
     cr = GETJSAMPLE(*inptr2++);
@@ -330,7 +345,7 @@ h2v2_merged_upsample (j_decompress_ptr cinfo,
   int cb, cr;
   register JSAMPROW outptr0, outptr1;
   JSAMPROW inptr00, inptr01, inptr1, inptr2;
-  JDIMENSION col;
+  JDIMENSION col, done;
   /* copy these pointers into registers if possible */
   register JSAMPLE * range_limit = cinfo->sample_range_limit;
   int * Crrtab = upsample->Cr_r_tab;
@@ -345,8 +360,24 @@ h2v2_merged_upsample (j_decompress_ptr cinfo,
   inptr2 = input_buf[2][in_row_group_ctr];
   outptr0 = output_buf[0];
   outptr1 = output_buf[1];
+  done = 0;
+#ifdef COLOR_SIMD_SUPPORTED
+  /* Both rows share the chroma row */
+  if (upsample->ycc_rgb_row != NULL) {
+    done = (*upsample->ycc_rgb_row) (inptr00, inptr1, inptr2, outptr0,
+				     cinfo->output_width, TRUE);
+    (void) (*upsample->ycc_rgb_row) (inptr01, inptr1, inptr2, outptr1,
+				     cinfo->output_width, TRUE);
+    inptr00 += done;
+    inptr01 += done;
+    inptr1 += done >> 1;
+    inptr2 += done >> 1;
+    outptr0 += done * RGB_PIXELSIZE;
+    outptr1 += done * RGB_PIXELSIZE;
+  }
+#endif
   /* Loop for each group of output pixels */
-  for (col = cinfo->output_width >> 1; col > 0; col--) {
+  for (col = (cinfo->output_width - done) >> 1; col > 0; col--) {
     /* Do the chroma part of the calculation */
     cb = GETJSAMPLE(*inptr1++);
     cr = GETJSAMPLE(*inptr2++);
@@ -429,10 +460,17 @@ jinit_merged_upsampler (j_decompress_ptr cinfo)
     upsample->spare_row = NULL;
   }
 
+#ifdef COLOR_SIMD_SUPPORTED
+  upsample->ycc_rgb_row = NULL;
+#endif
   if (cinfo->jpeg_color_space == JCS_BG_YCC)
     build_bg_ycc_rgb_table(cinfo);
-  else
+  else {
     build_ycc_rgb_table(cinfo);
+#ifdef COLOR_SIMD_SUPPORTED
+    upsample->ycc_rgb_row = jpeg_ycc_rgb_row_simd();
+#endif
+  }
 }
 
 #endif /* UPSAMPLE_MERGING_SUPPORTED */
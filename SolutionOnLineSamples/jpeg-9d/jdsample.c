@@ -23,6 +23,11 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 
+#if defined(JSIMD_SUPPORTED) && !defined(NO_COLOR_SIMD)
+#define UPSAMPLE_SIMD_SUPPORTED
+#include <immintrin.h>
+#endif
+
 
 /* Pointer to routine to upsample a single component */
 typedef JMETHOD(void, upsample1_ptr,
@@ -253,6 +258,76 @@ h2v1_upsample (j_decompress_ptr cinfo, jpeg_component_info * compptr,
 }
 
 
+#ifdef UPSAMPLE_SIMD_SUPPORTED
+
+/*
+ * SIMD versions of h2v1_upsample: each input sample is duplicated by
+ * unpacking a register with itself.  Whole steps are done only within
+ * output_width; the rest of the row is done as in the C version.
+ */
+
+METHODDEF(void) JSIMD_TARGET_SSE2
+h2v1_upsample_sse2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		    JSAMPARRAY input_data, JSAMPARRAY * output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  register JSAMPROW inptr, outptr;
+  register JSAMPLE invalue;
+  JSAMPROW outend;
+  __m128i in;
+  int outrow;
+
+  for (outrow = 0; outrow < cinfo->max_v_samp_factor; outrow++) {
+    inptr = input_data[outrow];
+    outptr = output_data[outrow];
+    outend = outptr + cinfo->output_width;
+    for (; outend - outptr >= 32; inptr += 16, outptr += 32) {
+      in = _mm_loadu_si128((const __m128i *) inptr);
+      _mm_storeu_si128((__m128i *) outptr, _mm_unpacklo_epi8(in, in));
+      _mm_storeu_si128((__m128i *) (outptr + 16), _mm_unpackhi_epi8(in, in));
+    }
+    while (outptr < outend) {
+      invalue = *inptr++;	/* don't need GETJSAMPLE() here */
+      *outptr++ = invalue;
+      *outptr++ = invalue;
+    }
+  }
+}
+
+METHODDEF(void) JSIMD_TARGET_AVX2
+h2v1_upsample_avx2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		    JSAMPARRAY input_data, JSAMPARRAY * output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  register JSAMPROW inptr, outptr;
+  register JSAMPLE invalue;
+  JSAMPROW outend;
+  __m256i in;
+  int outrow;
+
+  for (outrow = 0; outrow < cinfo->max_v_samp_factor; outrow++) {
+    inptr = input_data[outrow];
+    outptr = output_data[outrow];
+    outend = outptr + cinfo->output_width;
+    for (; outend - outptr >= 64; inptr += 32, outptr += 64) {
+      /* unpack works per 128-bit half: order the quadwords 0, 2, 1, 3 */
+      in = _mm256_permute4x64_epi64(
+	     _mm256_loadu_si256((const __m256i *) inptr), 0xD8);
+      _mm256_storeu_si256((__m256i *) outptr, _mm256_unpacklo_epi8(in, in));
+      _mm256_storeu_si256((__m256i *) (outptr + 32),
+			  _mm256_unpackhi_epi8(in, in));
+    }
+    while (outptr < outend) {
+      invalue = *inptr++;	/* don't need GETJSAMPLE() here */
+      *outptr++ = invalue;
+      *outptr++ = invalue;
+    }
+  }
+}
+
+#endif /* UPSAMPLE_SIMD_SUPPORTED */
+
+
 /*
  * Fast processing for the common case of 2:1 horizontal and 2:1 vertical.
  * It's still a box filter.
@@ -337,6 +412,12 @@ jinit_upsampler (j_decompress_ptr cinfo)
     if (h_in_group * 2 == h_out_group && v_in_group == v_out_group) {
       /* Special case for 2h1v upsampling */
       upsample->methods[ci] = h2v1_upsample;
+#ifdef UPSAMPLE_SIMD_SUPPORTED
+      if (jpeg_simd_support() & JSIMD_AVX2)
+	upsample->methods[ci] = h2v1_upsample_avx2;
+      else if (jpeg_simd_support() & JSIMD_SSE2)
+	upsample->methods[ci] = h2v1_upsample_sse2;
+#endif
     } else if (h_in_group * 2 == h_out_group &&
 	       v_in_group * 2 == v_out_group) {
       /* Special case for 2h2v upsampling */
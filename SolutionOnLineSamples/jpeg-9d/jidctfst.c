@@ -348,4 +348,227 @@ jpeg_idct_ifast (j_decompress_ptr cinfo, jpeg_component_info * compptr,
   }
 }
 
+
+#ifdef IDCT_SIMD_SUPPORTED
+
+/*
+ * SIMD versions of jpeg_idct_ifast, see jdct.h.
+ *
+ * Pass 1 processes the columns in parallel, one vector per row; pass 2
+ * transposes the work array and processes the rows in the same way.
+ * Each operation is the same as in the C code above, so the results are
+ * identical: the skipped zero columns and rows give the same values as
+ * the full calculation.  Only a block without any AC terms is handled
+ * separately.
+ */
+
+#ifdef USE_ACCURATE_ROUNDING
+#define IFAST_ROUNDING  (ONE << (CONST_BITS-1))
+#else
+#define IFAST_ROUNDING  0
+#endif
+
+/* Fudge factor for final descale and range-limit, see pass 2 above. */
+#define IFAST_PASS2_BIAS  \
+  ((((DCTELEM) RANGE_CENTER) << (PASS1_BITS+3)) + (1 << (PASS1_BITS+2)))
+
+/* Block with only a DC term: each output sample is the DC value. */
+
+LOCAL(JSAMPLE)
+ifast_dc_sample (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		 JCOEFPTR coef_block)
+{
+  JSAMPLE *range_limit = IDCT_range_limit(cinfo);
+  DCTELEM dcval = (DCTELEM) DEQUANTIZE(coef_block[0],
+			((IFAST_MULT_TYPE *) compptr->dct_table)[0]);
+  ISHIFT_TEMPS
+
+  return range_limit[(int) IRIGHT_SHIFT(dcval + IFAST_PASS2_BIAS,
+					PASS1_BITS+3) & RANGE_MASK];
+}
+
+#define MULTIPLY_SSE2(var,const)  \
+  _mm_srai_epi32(_mm_add_epi32(idct_mullo_sse2(var, _mm_set1_epi32(const)), \
+			       _mm_set1_epi32(IFAST_ROUNDING)), CONST_BITS)
+
+/* 1-D IDCT of v[0..7], the results are not descaled. */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 void
+ifast_1d_sse2 (__m128i * v)
+{
+  __m128i tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+  __m128i tmp10, tmp11, tmp12, tmp13;
+  __m128i z5, z10, z11, z12, z13;
+
+  /* Even part */
+
+  tmp10 = _mm_add_epi32(v[0], v[4]);	/* phase 3 */
+  tmp11 = _mm_sub_epi32(v[0], v[4]);
+
+  tmp13 = _mm_add_epi32(v[2], v[6]);	/* phases 5-3 */
+  tmp12 = _mm_sub_epi32(MULTIPLY_SSE2(_mm_sub_epi32(v[2], v[6]),
+				      FIX_1_414213562), tmp13); /* 2*c4 */
+
+  tmp0 = _mm_add_epi32(tmp10, tmp13);	/* phase 2 */
+  tmp3 = _mm_sub_epi32(tmp10, tmp13);
+  tmp1 = _mm_add_epi32(tmp11, tmp12);
+  tmp2 = _mm_sub_epi32(tmp11, tmp12);
+
+  /* Odd part */
+
+  z13 = _mm_add_epi32(v[5], v[3]);	/* phase 6 */
+  z10 = _mm_sub_epi32(v[5], v[3]);
+  z11 = _mm_add_epi32(v[1], v[7]);
+  z12 = _mm_sub_epi32(v[1], v[7]);
+
+  tmp7 = _mm_add_epi32(z11, z13);	/* phase 5 */
+  tmp11 = MULTIPLY_SSE2(_mm_sub_epi32(z11, z13), FIX_1_414213562); /* 2*c4 */
+
+  z5 = MULTIPLY_SSE2(_mm_add_epi32(z10, z12), FIX_1_847759065); /* 2*c2 */
+  tmp10 = _mm_sub_epi32(z5, MULTIPLY_SSE2(z12, FIX_1_082392200)); /* 2*(c2-c6) */
+  tmp12 = _mm_sub_epi32(z5, MULTIPLY_SSE2(z10, FIX_2_613125930)); /* 2*(c2+c6) */
+
+  tmp6 = _mm_sub_epi32(tmp12, tmp7);	/* phase 2 */
+  tmp5 = _mm_sub_epi32(tmp11, tmp6);
+  tmp4 = _mm_sub_epi32(tmp10, tmp5);
+
+  v[0] = _mm_add_epi32(tmp0, tmp7);
+  v[7] = _mm_sub_epi32(tmp0, tmp7);
+  v[1] = _mm_add_epi32(tmp1, tmp6);
+  v[6] = _mm_sub_epi32(tmp1, tmp6);
+  v[2] = _mm_add_epi32(tmp2, tmp5);
+  v[5] = _mm_sub_epi32(tmp2, tmp5);
+  v[3] = _mm_add_epi32(tmp3, tmp4);
+  v[4] = _mm_sub_epi32(tmp3, tmp4);
+}
+
+GLOBAL(void) IDCT_TARGET_SSE2
+jpeg_idct_ifast_sse2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		      JCOEFPTR coef_block,
+		      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  IFAST_MULT_TYPE * quantptr = (IFAST_MULT_TYPE *) compptr->dct_table;
+  __m128i lo[DCTSIZE], hi[DCTSIZE];	/* columns 0-3 and 4-7 */
+  __m128i bias;
+  int ctr;
+
+  if (idct_ac_zero_sse2(coef_block)) {
+    idct_fill_sse2(ifast_dc_sample(cinfo, compptr, coef_block),
+		   output_buf, output_col);
+    return;
+  }
+
+  /* Pass 1: process columns from input, one vector per row. */
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    idct_load_sse2(coef_block + DCTSIZE*ctr, quantptr + DCTSIZE*ctr,
+		   &lo[ctr], &hi[ctr]);
+  ifast_1d_sse2(lo);
+  ifast_1d_sse2(hi);
+
+  /* Pass 2: process rows, one vector per column. */
+
+  idct_transpose8x8_sse2(lo, hi);
+  bias = _mm_set1_epi32(IFAST_PASS2_BIAS);
+  lo[0] = _mm_add_epi32(lo[0], bias);
+  hi[0] = _mm_add_epi32(hi[0], bias);
+  ifast_1d_sse2(lo);
+  ifast_1d_sse2(hi);
+
+  /* Final output stage: scale down by a factor of 8 and range-limit */
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    lo[ctr] = _mm_packs_epi32(idct_range_sse2(lo[ctr], PASS1_BITS+3),
+			      idct_range_sse2(hi[ctr], PASS1_BITS+3));
+  idct_store_sse2(lo, output_buf, output_col);
+}
+
+#define MULTIPLY_AVX2(var,const)  \
+  _mm256_srai_epi32(_mm256_add_epi32( \
+    _mm256_mullo_epi32(var, _mm256_set1_epi32(const)), \
+    _mm256_set1_epi32(IFAST_ROUNDING)), CONST_BITS)
+
+IDCT_SIMD_INLINE IDCT_TARGET_AVX2 void
+ifast_1d_avx2 (__m256i * v)
+{
+  __m256i tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+  __m256i tmp10, tmp11, tmp12, tmp13;
+  __m256i z5, z10, z11, z12, z13;
+
+  /* Even part */
+
+  tmp10 = _mm256_add_epi32(v[0], v[4]);	/* phase 3 */
+  tmp11 = _mm256_sub_epi32(v[0], v[4]);
+
+  tmp13 = _mm256_add_epi32(v[2], v[6]);	/* phases 5-3 */
+  tmp12 = _mm256_sub_epi32(MULTIPLY_AVX2(_mm256_sub_epi32(v[2], v[6]),
+					 FIX_1_414213562), tmp13); /* 2*c4 */
+
+  tmp0 = _mm256_add_epi32(tmp10, tmp13);	/* phase 2 */
+  tmp3 = _mm256_sub_epi32(tmp10, tmp13);
+  tmp1 = _mm256_add_epi32(tmp11, tmp12);
+  tmp2 = _mm256_sub_epi32(tmp11, tmp12);
+
+  /* Odd part */
+
+  z13 = _mm256_add_epi32(v[5], v[3]);	/* phase 6 */
+  z10 = _mm256_sub_epi32(v[5], v[3]);
+  z11 = _mm256_add_epi32(v[1], v[7]);
+  z12 = _mm256_sub_epi32(v[1], v[7]);
+
+  tmp7 = _mm256_add_epi32(z11, z13);	/* phase 5 */
+  tmp11 = MULTIPLY_AVX2(_mm256_sub_epi32(z11, z13), FIX_1_414213562); /* 2*c4 */
+
+  z5 = MULTIPLY_AVX2(_mm256_add_epi32(z10, z12), FIX_1_847759065); /* 2*c2 */
+  tmp10 = _mm256_sub_epi32(z5, MULTIPLY_AVX2(z12, FIX_1_082392200)); /* 2*(c2-c6) */
+  tmp12 = _mm256_sub_epi32(z5, MULTIPLY_AVX2(z10, FIX_2_613125930)); /* 2*(c2+c6) */
+
+  tmp6 = _mm256_sub_epi32(tmp12, tmp7);	/* phase 2 */
+  tmp5 = _mm256_sub_epi32(tmp11, tmp6);
+  tmp4 = _mm256_sub_epi32(tmp10, tmp5);
+
+  v[0] = _mm256_add_epi32(tmp0, tmp7);
+  v[7] = _mm256_sub_epi32(tmp0, tmp7);
+  v[1] = _mm256_add_epi32(tmp1, tmp6);
+  v[6] = _mm256_sub_epi32(tmp1, tmp6);
+  v[2] = _mm256_add_epi32(tmp2, tmp5);
+  v[5] = _mm256_sub_epi32(tmp2, tmp5);
+  v[3] = _mm256_add_epi32(tmp3, tmp4);
+  v[4] = _mm256_sub_epi32(tmp3, tmp4);
+}
+
+GLOBAL(void) IDCT_TARGET_AVX2
+jpeg_idct_ifast_avx2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		      JCOEFPTR coef_block,
+		      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  IFAST_MULT_TYPE * quantptr = (IFAST_MULT_TYPE *) compptr->dct_table;
+  __m256i v[DCTSIZE];
+  int ctr;
+
+  if (idct_ac_zero_sse2(coef_block)) {
+    idct_fill_sse2(ifast_dc_sample(cinfo, compptr, coef_block),
+		   output_buf, output_col);
+    return;
+  }
+
+  /* Pass 1: process columns from input, one vector per row. */
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    v[ctr] = idct_load_avx2(coef_block + DCTSIZE*ctr, quantptr + DCTSIZE*ctr);
+  ifast_1d_avx2(v);
+
+  /* Pass 2: process rows, one vector per column. */
+
+  idct_transpose8x8_avx2(v);
+  v[0] = _mm256_add_epi32(v[0], _mm256_set1_epi32(IFAST_PASS2_BIAS));
+  ifast_1d_avx2(v);
+
+  /* Final output stage: scale down by a factor of 8 and range-limit */
+
+  idct_store_avx2(v, PASS1_BITS+3, output_buf, output_col);
+}
+
+#endif /* IDCT_SIMD_SUPPORTED */
+
 #endif /* DCT_IFAST_SUPPORTED */
@@ -424,6 +424,284 @@ jpeg_idct_islow (j_decompress_ptr cinfo, jpeg_component_info * compptr,
   }
 }
 
+#ifdef IDCT_SIMD_SUPPORTED
+
+/*
+ * SIMD versions of jpeg_idct_islow, see jdct.h.
+ *
+ * Pass 1 processes the columns in parallel, one vector per row; pass 2
+ * transposes the work array and processes the rows in the same way.
+ * Each operation is the same as in the C code above, so the results are
+ * identical: the skipped zero columns and rows give the same values as
+ * the full calculation.  Only a block without any AC terms is handled
+ * separately.
+ *
+ * The lanes are 32 bits wide, while INT32 in the C code may be wider.
+ * With dequantized coefficients up to ISLOW_SIMD_MAX_COEF in magnitude
+ * no intermediate value exceeds 32 bits (at most 0.89 * 2^31), so there
+ * is no difference.  Valid 8-bit data stays within this range; blocks
+ * with larger values (corrupt data) are passed to jpeg_idct_islow.
+ */
+
+#define ISLOW_SIMD_MAX_COEF  1024
+
+/* Fudge factor for final descale and range-limit, see pass 2 above. */
+#define ISLOW_PASS2_BIAS  \
+  ((((INT32) RANGE_CENTER) << (PASS1_BITS+3)) + (ONE << (PASS1_BITS+2)))
+
+/* Block with only a DC term: each output sample is the DC value. */
+
+LOCAL(JSAMPLE)
+islow_dc_sample (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		 JCOEFPTR coef_block)
+{
+  JSAMPLE *range_limit = IDCT_range_limit(cinfo);
+  int dcval = DEQUANTIZE(coef_block[0],
+			 ((ISLOW_MULT_TYPE *) compptr->dct_table)[0]) << PASS1_BITS;
+  SHIFT_TEMPS
+
+  return range_limit[(int) RIGHT_SHIFT((INT32) dcval + ISLOW_PASS2_BIAS,
+				       PASS1_BITS+3) & RANGE_MASK];
+}
+
+#define MULTIPLY_SSE2(var,const)  \
+  idct_mullo_sse2(var, _mm_set1_epi32((int) (const)))
+
+/* 1-D IDCT of v[0..7], the results are not descaled.
+ * round is added to the even part (the fudge factor of pass 1).
+ */
+
+IDCT_SIMD_INLINE IDCT_TARGET_SSE2 void
+islow_1d_sse2 (__m128i * v, __m128i round)
+{
+  __m128i tmp0, tmp1, tmp2, tmp3;
+  __m128i tmp10, tmp11, tmp12, tmp13;
+  __m128i z1, z2, z3;
+
+  /* Even part: reverse the even part of the forward DCT.
+   * The rotator is c(-6).
+   */
+
+  tmp0 = _mm_add_epi32(_mm_slli_epi32(_mm_add_epi32(v[0], v[4]), CONST_BITS),
+		       round);
+  tmp1 = _mm_add_epi32(_mm_slli_epi32(_mm_sub_epi32(v[0], v[4]), CONST_BITS),
+		       round);
+
+  z2 = v[2];
+  z3 = v[6];
+
+  z1 = MULTIPLY_SSE2(_mm_add_epi32(z2, z3), FIX_0_541196100);       /* c6 */
+  tmp2 = _mm_add_epi32(z1, MULTIPLY_SSE2(z2, FIX_0_765366865));     /* c2-c6 */
+  tmp3 = _mm_sub_epi32(z1, MULTIPLY_SSE2(z3, FIX_1_847759065));     /* c2+c6 */
+
+  tmp10 = _mm_add_epi32(tmp0, tmp2);
+  tmp13 = _mm_sub_epi32(tmp0, tmp2);
+  tmp11 = _mm_add_epi32(tmp1, tmp3);
+  tmp12 = _mm_sub_epi32(tmp1, tmp3);
+
+  /* Odd part per figure 8; the matrix is unitary and hence its
+   * transpose is its inverse.  i0..i3 are y7,y5,y3,y1 respectively.
+   */
+
+  tmp0 = v[7];
+  tmp1 = v[5];
+  tmp2 = v[3];
+  tmp3 = v[1];
+
+  z2 = _mm_add_epi32(tmp0, tmp2);
+  z3 = _mm_add_epi32(tmp1, tmp3);
+
+  z1 = MULTIPLY_SSE2(_mm_add_epi32(z2, z3), FIX_1_175875602);       /*  c3 */
+  z2 = MULTIPLY_SSE2(z2, - FIX_1_961570560);          /* -c3-c5 */
+  z3 = MULTIPLY_SSE2(z3, - FIX_0_390180644);          /* -c3+c5 */
+  z2 = _mm_add_epi32(z2, z1);
+  z3 = _mm_add_epi32(z3, z1);
+
+  z1 = MULTIPLY_SSE2(_mm_add_epi32(tmp0, tmp3), - FIX_0_899976223); /* -c3+c7 */
+  tmp0 = MULTIPLY_SSE2(tmp0, FIX_0_298631336);        /* -c1+c3+c5-c7 */
+  tmp3 = MULTIPLY_SSE2(tmp3, FIX_1_501321110);        /*  c1+c3-c5-c7 */
+  tmp0 = _mm_add_epi32(tmp0, _mm_add_epi32(z1, z2));
+  tmp3 = _mm_add_epi32(tmp3, _mm_add_epi32(z1, z3));
+
+  z1 = MULTIPLY_SSE2(_mm_add_epi32(tmp1, tmp2), - FIX_2_562915447); /* -c1-c3 */
+  tmp1 = MULTIPLY_SSE2(tmp1, FIX_2_053119869);        /*  c1+c3-c5+c7 */
+  tmp2 = MULTIPLY_SSE2(tmp2, FIX_3_072711026);        /*  c1+c3+c5-c7 */
+  tmp1 = _mm_add_epi32(tmp1, _mm_add_epi32(z1, z3));
+  tmp2 = _mm_add_epi32(tmp2, _mm_add_epi32(z1, z2));
+
+  /* Final output stage: inputs are tmp10..tmp13, tmp0..tmp3 */
+
+  v[0] = _mm_add_epi32(tmp10, tmp3);
+  v[7] = _mm_sub_epi32(tmp10, tmp3);
+  v[1] = _mm_add_epi32(tmp11, tmp2);
+  v[6] = _mm_sub_epi32(tmp11, tmp2);
+  v[2] = _mm_add_epi32(tmp12, tmp1);
+  v[5] = _mm_sub_epi32(tmp12, tmp1);
+  v[3] = _mm_add_epi32(tmp13, tmp0);
+  v[4] = _mm_sub_epi32(tmp13, tmp0);
+}
+
+GLOBAL(void) IDCT_TARGET_SSE2
+jpeg_idct_islow_sse2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		      JCOEFPTR coef_block,
+		      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  ISLOW_MULT_TYPE * quantptr = (ISLOW_MULT_TYPE *) compptr->dct_table;
+  __m128i lo[DCTSIZE], hi[DCTSIZE];	/* columns 0-3 and 4-7 */
+  __m128i round, bias;
+  int ctr;
+
+  if (idct_ac_zero_sse2(coef_block)) {
+    idct_fill_sse2(islow_dc_sample(cinfo, compptr, coef_block),
+		   output_buf, output_col);
+    return;
+  }
+
+  /* Pass 1: process columns from input, one vector per row. */
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    idct_load_sse2(coef_block + DCTSIZE*ctr, quantptr + DCTSIZE*ctr,
+		   &lo[ctr], &hi[ctr]);
+  if (! idct_in_range_sse2(lo, DCTSIZE, ISLOW_SIMD_MAX_COEF) ||
+      ! idct_in_range_sse2(hi, DCTSIZE, ISLOW_SIMD_MAX_COEF)) {
+    jpeg_idct_islow(cinfo, compptr, coef_block, output_buf, output_col);
+    return;
+  }
+  round = _mm_set1_epi32(ONE << (CONST_BITS-PASS1_BITS-1));
+  islow_1d_sse2(lo, round);
+  islow_1d_sse2(hi, round);
+  for (ctr = 0; ctr < DCTSIZE; ctr++) {
+    lo[ctr] = _mm_srai_epi32(lo[ctr], CONST_BITS-PASS1_BITS);
+    hi[ctr] = _mm_srai_epi32(hi[ctr], CONST_BITS-PASS1_BITS);
+  }
+
+  /* Pass 2: process rows, one vector per column. */
+
+  idct_transpose8x8_sse2(lo, hi);
+  bias = _mm_set1_epi32(ISLOW_PASS2_BIAS);
+  lo[0] = _mm_add_epi32(lo[0], bias);
+  hi[0] = _mm_add_epi32(hi[0], bias);
+  round = _mm_setzero_si128();
+  islow_1d_sse2(lo, round);
+  islow_1d_sse2(hi, round);
+
+  /* Final output stage: scale down by a factor of 8 and range-limit */
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    lo[ctr] = _mm_packs_epi32(idct_range_sse2(lo[ctr], CONST_BITS+PASS1_BITS+3),
+			      idct_range_sse2(hi[ctr], CONST_BITS+PASS1_BITS+3));
+  idct_store_sse2(lo, output_buf, output_col);
+}
+
+#define MULTIPLY_AVX2(var,const)  \
+  _mm256_mullo_epi32(var, _mm256_set1_epi32((int) (const)))
+
+IDCT_SIMD_INLINE IDCT_TARGET_AVX2 void
+islow_1d_avx2 (__m256i * v, __m256i round)
+{
+  __m256i tmp0, tmp1, tmp2, tmp3;
+  __m256i tmp10, tmp11, tmp12, tmp13;
+  __m256i z1, z2, z3;
+
+  /* Even part */
+
+  tmp0 = _mm256_add_epi32(
+    _mm256_slli_epi32(_mm256_add_epi32(v[0], v[4]), CONST_BITS), round);
+  tmp1 = _mm256_add_epi32(
+    _mm256_slli_epi32(_mm256_sub_epi32(v[0], v[4]), CONST_BITS), round);
+
+  z2 = v[2];
+  z3 = v[6];
+
+  z1 = MULTIPLY_AVX2(_mm256_add_epi32(z2, z3), FIX_0_541196100);    /* c6 */
+  tmp2 = _mm256_add_epi32(z1, MULTIPLY_AVX2(z2, FIX_0_765366865));  /* c2-c6 */
+  tmp3 = _mm256_sub_epi32(z1, MULTIPLY_AVX2(z3, FIX_1_847759065));  /* c2+c6 */
+
+  tmp10 = _mm256_add_epi32(tmp0, tmp2);
+  tmp13 = _mm256_sub_epi32(tmp0, tmp2);
+  tmp11 = _mm256_add_epi32(tmp1, tmp3);
+  tmp12 = _mm256_sub_epi32(tmp1, tmp3);
+
+  /* Odd part */
+
+  tmp0 = v[7];
+  tmp1 = v[5];
+  tmp2 = v[3];
+  tmp3 = v[1];
+
+  z2 = _mm256_add_epi32(tmp0, tmp2);
+  z3 = _mm256_add_epi32(tmp1, tmp3);
+
+  z1 = MULTIPLY_AVX2(_mm256_add_epi32(z2, z3), FIX_1_175875602);    /*  c3 */
+  z2 = MULTIPLY_AVX2(z2, - FIX_1_961570560);          /* -c3-c5 */
+  z3 = MULTIPLY_AVX2(z3, - FIX_0_390180644);          /* -c3+c5 */
+  z2 = _mm256_add_epi32(z2, z1);
+  z3 = _mm256_add_epi32(z3, z1);
+
+  z1 = MULTIPLY_AVX2(_mm256_add_epi32(tmp0, tmp3), - FIX_0_899976223); /* -c3+c7 */
+  tmp0 = MULTIPLY_AVX2(tmp0, FIX_0_298631336);        /* -c1+c3+c5-c7 */
+  tmp3 = MULTIPLY_AVX2(tmp3, FIX_1_501321110);        /*  c1+c3-c5-c7 */
+  tmp0 = _mm256_add_epi32(tmp0, _mm256_add_epi32(z1, z2));
+  tmp3 = _mm256_add_epi32(tmp3, _mm256_add_epi32(z1, z3));
+
+  z1 = MULTIPLY_AVX2(_mm256_add_epi32(tmp1, tmp2), - FIX_2_562915447); /* -c1-c3 */
+  tmp1 = MULTIPLY_AVX2(tmp1, FIX_2_053119869);        /*  c1+c3-c5+c7 */
+  tmp2 = MULTIPLY_AVX2(tmp2, FIX_3_072711026);        /*  c1+c3+c5-c7 */
+  tmp1 = _mm256_add_epi32(tmp1, _mm256_add_epi32(z1, z3));
+  tmp2 = _mm256_add_epi32(tmp2, _mm256_add_epi32(z1, z2));
+
+  /* Final output stage: inputs are tmp10..tmp13, tmp0..tmp3 */
+
+  v[0] = _mm256_add_epi32(tmp10, tmp3);
+  v[7] = _mm256_sub_epi32(tmp10, tmp3);
+  v[1] = _mm256_add_epi32(tmp11, tmp2);
+  v[6] = _mm256_sub_epi32(tmp11, tmp2);
+  v[2] = _mm256_add_epi32(tmp12, tmp1);
+  v[5] = _mm256_sub_epi32(tmp12, tmp1);
+  v[3] = _mm256_add_epi32(tmp13, tmp0);
+  v[4] = _mm256_sub_epi32(tmp13, tmp0);
+}
+
+GLOBAL(void) IDCT_TARGET_AVX2
+jpeg_idct_islow_avx2 (j_decompress_ptr cinfo, jpeg_component_info * compptr,
+		      JCOEFPTR coef_block,
+		      JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  ISLOW_MULT_TYPE * quantptr = (ISLOW_MULT_TYPE *) compptr->dct_table;
+  __m256i v[DCTSIZE];
+  int ctr;
+
+  if (idct_ac_zero_sse2(coef_block)) {
+    idct_fill_sse2(islow_dc_sample(cinfo, compptr, coef_block),
+		   output_buf, output_col);
+    return;
+  }
+
+  /* Pass 1: process columns from input, one vector per row. */
+
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    v[ctr] = idct_load_avx2(coef_block + DCTSIZE*ctr, quantptr + DCTSIZE*ctr);
+  if (! idct_in_range_avx2(v, DCTSIZE, ISLOW_SIMD_MAX_COEF)) {
+    jpeg_idct_islow(cinfo, compptr, coef_block, output_buf, output_col);
+    return;
+  }
+  islow_1d_avx2(v, _mm256_set1_epi32(ONE << (CONST_BITS-PASS1_BITS-1)));
+  for (ctr = 0; ctr < DCTSIZE; ctr++)
+    v[ctr] = _mm256_srai_epi32(v[ctr], CONST_BITS-PASS1_BITS);
+
+  /* Pass 2: process rows, one vector per column. */
+
+  idct_transpose8x8_avx2(v);
+  v[0] = _mm256_add_epi32(v[0], _mm256_set1_epi32(ISLOW_PASS2_BIAS));
+  islow_1d_avx2(v, _mm256_setzero_si256());
+
+  /* Final output stage: scale down by a factor of 8 and range-limit */
+
+  idct_store_avx2(v, CONST_BITS+PASS1_BITS+3, output_buf, output_col);
+}
+
+#endif /* IDCT_SIMD_SUPPORTED */
+
 #ifdef IDCT_SCALING_SUPPORTED
 
 
@@ -353,6 +353,8 @@ struct jpeg_color_quantizer {
 #define jpeg_natural_order3	jZAG3Table
 #define jpeg_natural_order2	jZAG2Table
 #define jpeg_aritab		jAriTab
+#define jpeg_simd_support	jSimdSupport
+#define jpeg_ycc_rgb_row_simd	jYccRgbSimd
 #endif /* NEED_SHORT_EXTERNAL_NAMES */
 
 
@@ -436,6 +438,61 @@ extern const int jpeg_natural_order2[]; /* zz to natural order for 2x2 block */
 /* Arithmetic coding probability estimation tables in jaricom.c */
 extern const INT32 jpeg_aritab[];
 
+/* SIMD code for x86/x64 (SSE2, AVX2), selected at run time.
+ * The SIMD routines produce exactly the same output as the C versions
+ * (the islow IDCT leaves blocks with out-of-range coefficients to the C
+ * version, see jidctint.c).
+ * Define NO_SIMD to use the C versions only.  jpeg_simd_support in
+ * jutils.c tells which instruction sets the CPU (and OS) supports; the
+ * environment variable JPEGSIMD=none or JPEGSIMD=sse2 limits them.
+ */
+
+#if !defined(NO_SIMD) && BITS_IN_JSAMPLE == 8 && \
+    (defined(_M_IX86) || defined(_M_X64) || \
+     defined(__i386__) || defined(__x86_64__)) && \
+    (defined(_MSC_VER) || defined(__clang__) || \
+     (defined(__GNUC__) && (__GNUC__ > 4 || \
+			    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define JSIMD_SUPPORTED
+#endif
+
+#ifdef JSIMD_SUPPORTED
+
+#define JSIMD_SSE2	1
+#define JSIMD_AVX2	2
+
+/* Functions compiled for an instruction set, see jpeg_simd_support */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define JSIMD_INLINE		static __inline
+#define JSIMD_TARGET_SSE2
+#define JSIMD_TARGET_AVX2
+#else
+#define JSIMD_INLINE		static __inline__
+#define JSIMD_TARGET_SSE2	__attribute__((target("sse2")))
+#define JSIMD_TARGET_AVX2	__attribute__((target("avx2")))
+#endif
+
+EXTERN(int) jpeg_simd_support JPP((void));
+
+/* YCbCr->RGB conversion of the leading part of a row in jdcolor.c, also
+ * used by jdmerge.c.  Cb and Cr have the width of Y, or half of it if
+ * chroma_h2 is TRUE.  Returns the # of pixels done, the caller converts
+ * the rest.  Only for the standard RGB pixel layout.
+ */
+#if !defined(NO_COLOR_SIMD) && RGB_RED == 0 && RGB_GREEN == 1 && \
+    RGB_BLUE == 2 && RGB_PIXELSIZE == 3
+#define COLOR_SIMD_SUPPORTED
+
+typedef JMETHOD(JDIMENSION, jpeg_ycc_rgb_row_ptr,
+		(JSAMPROW inptr0, JSAMPROW inptr1, JSAMPROW inptr2,
+		 JSAMPROW outptr, JDIMENSION num_cols, boolean chroma_h2));
+
+/* Returns the row converter for this CPU, or NULL */
+EXTERN(jpeg_ycc_rgb_row_ptr) jpeg_ycc_rgb_row_simd JPP((void));
+#endif
+
+#endif /* JSIMD_SUPPORTED */
+
 /* Suppress undefined-structure complaints if necessary. */
 
 #ifdef INCOMPLETE_TYPES_BROKEN
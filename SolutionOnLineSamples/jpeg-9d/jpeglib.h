@@ -498,6 +498,15 @@ struct jpeg_decompress_struct {
   boolean enable_external_quant;/* enable future use of external colormap */
   boolean enable_2pass_quant;	/* enable future use of 2-pass quantizer */
 
+  /* Local change: region of interest in iMCU columns and rows (end is
+   * exclusive).  Blocks outside it are entropy decoded, but not dequantized
+   * and transformed; their output samples are undefined.  jpeg_read_header()
+   * selects the whole image.  May also be changed between calls of
+   * jpeg_read_scanlines() or jpeg_read_raw_data().
+   */
+  JDIMENSION roi_iMCU_col_start, roi_iMCU_col_end;
+  JDIMENSION roi_iMCU_row_start, roi_iMCU_row_end;
+
   /* Description of actual output image that will be returned to application.
    * These fields are computed by jpeg_start_decompress().
    * You can also use jpeg_calc_output_dimensions() to determine these values
@@ -16,6 +16,19 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 
+#ifdef JSIMD_SUPPORTED
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#ifndef NO_GETENV
+#ifndef HAVE_STDLIB_H		/* <stdlib.h> should declare getenv() */
+extern char * getenv JPP((const char * name));
+#endif
+#endif
+#endif
+
 
 /*
  * jpeg_zigzag_order[i] is the zigzag-order position of the i'th element
@@ -225,3 +238,69 @@ jcopy_block_row (JBLOCKROW input_row, JBLOCKROW output_row,
   }
 #endif
 }
+
+
+#ifdef JSIMD_SUPPORTED
+
+/*
+ * Determine which SIMD instruction sets the CPU can run (detected once).
+ * AVX2 also needs the OS support for the YMM registers (OSXSAVE, XCR0).
+ * The environment variable JPEGSIMD can limit the result to SSE2 ("sse2")
+ * or to the C code ("none"), e.g. to compare the output.  If your system
+ * doesn't support getenv(), define NO_GETENV to disable this feature.
+ */
+
+GLOBAL(int)
+jpeg_simd_support (void)
+{
+  static int support = -1;
+  unsigned int regs[4] = { 0, 0, 0, 0 };
+  unsigned int maxleaf, eax = 0;
+  int result = 0;
+
+  if (support >= 0)
+    return support;
+
+#if defined(_MSC_VER)
+  __cpuid((int *) regs, 0);
+  maxleaf = regs[0];
+  __cpuid((int *) regs, 1);
+#else
+  __cpuid(0, regs[0], regs[1], regs[2], regs[3]);
+  maxleaf = regs[0];
+  __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+  if (regs[3] & (1U << 26))
+    result |= JSIMD_SSE2;
+  if ((regs[2] & (1U << 27)) && (regs[2] & (1U << 28)) && maxleaf >= 7) {
+#if defined(_MSC_VER)
+    eax = (unsigned int) _xgetbv(0);
+    __cpuidex((int *) regs, 7, 0);
+#else
+    {
+      unsigned int edx;
+      __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    }
+    __cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    if ((eax & 6) == 6 && (regs[1] & (1U << 5)))
+      result |= JSIMD_AVX2;
+  }
+
+#ifndef NO_GETENV
+  { char * simdenv;
+
+    if ((simdenv = getenv("JPEGSIMD")) != NULL) {
+      if (strcmp(simdenv, "none") == 0)
+	result = 0;
+      else if (strcmp(simdenv, "sse2") == 0)
+	result &= JSIMD_SSE2;
+    }
+  }
+#endif
+
+  support = result;
+  return support;
+}
+
+#endif /* JSIMD_SUPPORTED */